@@ -251,6 +251,92 @@ void image_data_c::ShrinkMasked(int new_w, int new_h)
 	height = new_h;
 }
 
+//
+// Dividing by the summed alpha is done by multiplying with a fixed
+// point reciprocal.  The sums are at most 4 * 255 * 255, so 32 bits
+// of fraction is enough for the result to be exact.
+//
+class alpha_recip_c
+{
+public:
+	u64_t recip[4 * 255 + 1];
+
+	alpha_recip_c()
+	{
+		recip[0] = 0;
+
+		for (int a = 1; a <= 4 * 255; a++)
+			recip[a] = (((u64_t)1 << 32) + a - 1) / a;
+	}
+
+	inline u8_t Divide(u32_t value, u32_t a) const
+	{
+		return (u8_t)((value * recip[a]) >> 32);
+	}
+};
+
+static void HalveRowRGB(u8_t *dest, const u8_t *row0, const u8_t *row1,
+						int new_w, int dx)
+{
+	// dx is 3 (next pixel) or 0 when the width is 1.  The sums use
+	// four samples either way, so the result matches Shrink().
+	for (int x = 0; x < new_w; x++, dest += 3, row0 += 6, row1 += 6)
+	{
+		dest[0] = (row0[0] + row0[dx+0] + row1[0] + row1[dx+0]) >> 2;
+		dest[1] = (row0[1] + row0[dx+1] + row1[1] + row1[dx+1]) >> 2;
+		dest[2] = (row0[2] + row0[dx+2] + row1[2] + row1[dx+2]) >> 2;
+	}
+}
+
+static void HalveRowRGBA(u8_t *dest, const u8_t *row0, const u8_t *row1,
+						 int new_w, int dx, const alpha_recip_c& R)
+{
+	for (int x = 0; x < new_w; x++, dest += 4, row0 += 8, row1 += 8)
+	{
+		u32_t w0 = row0[3];
+		u32_t w1 = row0[dx+3];
+		u32_t w2 = row1[3];
+		u32_t w3 = row1[dx+3];
+
+		u32_t a = w0 + w1 + w2 + w3;
+
+		u32_t r = row0[0]*w0 + row0[dx+0]*w1 + row1[0]*w2 + row1[dx+0]*w3;
+		u32_t g = row0[1]*w0 + row0[dx+1]*w1 + row1[1]*w2 + row1[dx+1]*w3;
+		u32_t b = row0[2]*w0 + row0[dx+2]*w1 + row1[2]*w2 + row1[dx+2]*w3;
+
+		// recip[0] is zero, so fully clear pixels come out as zero
+		dest[0] = R.Divide(r, a);
+		dest[1] = R.Divide(g, a);
+		dest[2] = R.Divide(b, a);
+		dest[3] = a >> 2;
+	}
+}
+
+void image_data_c::HalveMaskedRows(image_data_c *dest, int y1, int y2) const
+{
+	SYS_ASSERT(bpp >= 3 && dest->bpp == bpp);
+	SYS_ASSERT(dest->width  == MAX(1, width  / 2));
+	SYS_ASSERT(dest->height == MAX(1, height / 2));
+
+	static const alpha_recip_c recips;
+
+	int dx = (width  > 1) ? bpp : 0;
+	int dy = (height > 1) ? 1 : 0;
+
+	for (int y = y1; y < y2; y++)
+	{
+		int sy = (height > 1) ? y * 2 : 0;
+
+		const u8_t *row0 = PixelAt(0, sy);
+		const u8_t *row1 = PixelAt(0, sy + dy);
+
+		if (bpp == 3)
+			HalveRowRGB(dest->PixelAt(0, y), row0, row1, dest->width, dx);
+		else
+			HalveRowRGBA(dest->PixelAt(0, y), row0, row1, dest->width, dx, recips);
+	}
+}
+
 void image_data_c::Grow(int new_w, int new_h)
 {
 	SYS_ASSERT(new_w >= width && new_h >= height);
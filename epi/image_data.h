@@ -119,6 +119,13 @@ public:
 	// purely transparent pixels never affect the final color
 	// of a pixel group.
 
+	void HalveMaskedRows(image_data_c *dest, int y1, int y2) const;
+	// compute rows [y1, y2) of the image shrunk to half size (sides
+	// of 1 stay 1), giving the same result as ShrinkMasked().  The
+	// 'dest' image must already have that size.  This is much faster
+	// for building mipmaps, and separate rows can be done on separate
+	// threads.  Only for RGB and RGBA images.
+
 	void Grow(int new_w, int new_h);
 	// scale the image up to a larger size.
 	// The old size and the new size must be powers of two.
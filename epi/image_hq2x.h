@@ -32,19 +32,44 @@ namespace epi
 {
 	namespace Hq2x
 	{
+		class palette_c
+		{
+			// the look-up tables for one palette.  Once made it is
+			// only read, so any number of threads can use it at once.
+
+		public:
+			palette_c(const byte *palette, int trans_pixel);
+			// the 'trans_pixel' gives a pixel index which is fully
+			// transparent, or none when -1.
+
+			u32_t rgb[256];
+
+			// one bit for each pair of colours, set when they are
+			// different enough to count as an edge.
+			u32_t diff[256][8];
+
+			inline bool Diff(u8_t p1, u8_t p2) const
+			{
+				return (diff[p1][p2 >> 5] >> (p2 & 31)) & 1;
+			}
+		};
+
 		/* ------ Functions ------------------------------------- */
 
-		void Setup(const byte *palette, int trans_pixel);
-		// initialises look-up tables based on the given palette.
-		// The 'trans_pixel' gives a pixel index which is fully
-		// transparent, or none when -1.
+		image_data_c *NewResult(const image_data_c *img, bool solid);
+		// creates the (empty) image which Convert() would return.
+
+		void ConvertRows(const palette_c *pal, const image_data_c *img,
+						 image_data_c *result, bool solid, bool invert,
+						 int y1, int y2);
+		// converts the rows [y1, y2) of the palettised image into the
+		// result (from NewResult).  Different rows of the same image
+		// may be done on different threads at the same time.
 
-		image_data_c *Convert(image_data_c *img, bool solid, bool invert = false);
+		image_data_c *Convert(const palette_c *pal, image_data_c *img,
+							  bool solid, bool invert = false);
 		// converts a single palettised image into an RGB or RGBA
-		// image (depending on the solid parameter).  The Setup()
-		// method must be called sometime prior to calling this
-		// function, and this determines the palette of the input
-		// image.
+		// image (depending on the solid parameter).
 	}
 
 }  // namespace epi
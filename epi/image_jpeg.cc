@@ -52,7 +52,9 @@ namespace epi
     {
         SYS_ASSERT(img->bpp == 3);
 
-        stbi_flip_vertically_on_write(1);
+        // a global inside stb_image_write, see PNG_Save()
+        static const bool flip_set = (stbi_flip_vertically_on_write(1), true);
+        (void) flip_set;
 
         if (epimg_write_jpg(fp, img->width, img->height, img->bpp, img->PixelAt(0, 0), quality))
             return true;
@@ -118,8 +118,13 @@ namespace epi
 	{
 		SYS_ASSERT(img->bpp >= 3);
 
-        stbi_write_png_compression_level = compress;
-        stbi_flip_vertically_on_write(1);
+		// these are globals inside stb_image_write, so only touch them
+		// when needed (saves may run on several threads at once).
+		if (stbi_write_png_compression_level != compress)
+			stbi_write_png_compression_level = compress;
+
+		static const bool flip_set = (stbi_flip_vertically_on_write(1), true);
+		(void) flip_set;
 
         if (epimg_write_png(fp, img->used_w, img->used_h, img->bpp, img->PixelAt(0, 0), (int)img->width*img->bpp))
             return true;
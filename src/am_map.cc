@@ -45,6 +45,8 @@
 #include <float.h>
 #include <math.h>
 
+#include <vector>
+
 #define DEBUG_TRUEBSP  0
 #define DEBUG_COLLIDE  0
 
@@ -241,6 +243,8 @@ static void ClearMarks(void)
 }
 
 
+static void InitLineCache(void);
+
 void AM_InitLevel(void)
 {
 	if (!cheat_amap.sequence)
@@ -252,6 +256,8 @@ void AM_InitLevel(void)
 
 	FindMinMaxBoundaries();
 
+	InitLineCache();
+
 	m_scale = INIT_MSCALE;
 
 }
@@ -644,100 +650,167 @@ static bool CheckSimiliarRegions(sector_t *front, sector_t *back)
 
 
 //
-// Determines visible lines, draws them.
-//
-// -AJA- This is now *lineseg* based, not linedef.
+// Works out the colour of a line on the automap, or -1 when the line
+// is not shown.
 //
-static void AM_WalkSeg(seg_t *seg)
+static int ClassifyLine(line_t *line, bool allmap)
 {
-	mline_t l;
-	line_t *line;
+	sector_t *front = line->frontsector;
+	sector_t *back  = line->backsector;
 
-	sector_t *front = seg->frontsector;
-	sector_t *back  = seg->backsector;
-
-	if (seg->miniseg)
+	if ((line->flags & MLF_Mapped) || show_walls)
 	{
-#if (DEBUG_TRUEBSP == 1)
-		if (seg->partner && seg > seg->partner)
-			return;
+		if ((line->flags & MLF_DontDraw) && !show_walls)
+			return -1;
 
-		GetRotatedCoords(seg->v1->x, seg->v1->y, &l.a.x, &l.a.y);
-		GetRotatedCoords(seg->v2->x, seg->v2->y, &l.b.x, &l.b.y);
+		if (!front || !back)
+			return AMCOL_Wall;
 
-		DrawMLine(&l, RGB_MAKE(0,0,128), false);
-#endif
-		return;
+		if (line->flags & MLF_Secret)
+		{  
+			// secret door
+			return show_walls ? AMCOL_Secret : AMCOL_Wall;
+		}
+		else if (back->f_h != front->f_h)
+		{
+			float diff = fabs(back->f_h - front->f_h);
+
+			// floor level change
+			return (diff > 24) ? AMCOL_Ledge : AMCOL_Step;
+		}
+		else if (back->c_h != front->c_h)
+		{
+			// ceiling level change
+			return AMCOL_Ceil;
+		}
+		else if ((front->exfloor_used > 0 || back->exfloor_used > 0) &&
+			(front->exfloor_used != back->exfloor_used ||
+			! CheckSimiliarRegions(front, back)))
+		{
+			// -AJA- 1999/10/09: extra floor change.
+			return AMCOL_Ledge;
+		}
+		else if (show_walls)
+		{
+			return AMCOL_Allmap;
+		}
+		else if (line->slide_door)
+		{ //Lobo: draw sliding doors on automap
+			return AMCOL_Ceil;
+		}
+	}
+	else if (allmap)
+	{
+		if (! (line->flags & MLF_DontDraw))
+			return AMCOL_Allmap;
 	}
 
-	line = seg->linedef;
-	SYS_ASSERT(line);
+	return -1;
+}
 
-	// only draw segs on the _right_ side of linedefs
-	if (line->side[1] == seg->sidedef)
-		return;
 
-	GetRotatedCoords(seg->v1->x, seg->v1->y, &l.a.x, &l.a.y);
-	GetRotatedCoords(seg->v2->x, seg->v2->y, &l.b.x, &l.b.y);
+//
+// The lines are classified once and kept in lists by colour, which
+// are only rebuilt when something they depend on changes: the mapped
+// lines, the sector heights, the cheat level or the allmap power.
+//
+// Only linedefs with a (non-mini) seg on their right side are drawn,
+// same as walking the BSP tree did.
+//
 
-	if ((line->flags & MLF_Mapped) || show_walls)
+int am_mapped_count;
+
+static std::vector<int> cached_lines[AM_NUM_COLORS];
+
+static std::vector<byte>  line_has_seg;
+static std::vector<float> sector_heights;
+
+static int  cached_mapped = -1;
+static int  cached_mode   = -1;
+
+static void InitLineCache(void)
+{
+	line_has_seg.assign(numlines, 0);
+
+	for (int i = 0; i < numsegs; i++)
 	{
-		if ((line->flags & MLF_DontDraw) && !show_walls)
-			return;
+		seg_t *seg = &segs[i];
 
-		if (!front || !back)
+		// only segs on the _right_ side of linedefs
+		if (! seg->miniseg && seg->linedef &&
+			seg->sidedef != seg->linedef->side[1])
 		{
-			DrawMLine(&l, am_colors[AMCOL_Wall]);
+			line_has_seg[seg->linedef - lines] = 1;
 		}
-		else
+	}
+
+	sector_heights.clear();
+
+	cached_mapped = -1;
+}
+
+static bool SectorsChanged(void)
+{
+	bool changed = ((int)sector_heights.size() != numsectors * 2);
+
+	sector_heights.resize(numsectors * 2);
+
+	float *h = &sector_heights[0];
+
+	for (int i = 0; i < numsectors; i++, h += 2)
+	{
+		if (h[0] != sectors[i].f_h || h[1] != sectors[i].c_h)
 		{
-			if (line->flags & MLF_Secret)
-			{  
-				// secret door
-				if (show_walls)
-					DrawMLine(&l, am_colors[AMCOL_Secret]);
-				else
-					DrawMLine(&l, am_colors[AMCOL_Wall]);
-			}
-			else if (back->f_h != front->f_h)
-			{
-				float diff = fabs(back->f_h - front->f_h);
-
-				// floor level change
-				if (diff > 24)
-					DrawMLine(&l, am_colors[AMCOL_Ledge]);
-				else
-					DrawMLine(&l, am_colors[AMCOL_Step]);
-			}
-			else if (back->c_h != front->c_h)
-			{
-				// ceiling level change
-				DrawMLine(&l, am_colors[AMCOL_Ceil]);
-			}
-			else if ((front->exfloor_used > 0 || back->exfloor_used > 0) &&
-				(front->exfloor_used != back->exfloor_used ||
-				! CheckSimiliarRegions(front, back)))
-			{
-				// -AJA- 1999/10/09: extra floor change.
-				DrawMLine(&l, am_colors[AMCOL_Ledge]);
-			}
-			else if (show_walls)
-			{
-				DrawMLine(&l, am_colors[AMCOL_Allmap]);
-			}
-			else if (line->slide_door)
-			{ //Lobo: draw sliding doors on automap
-				DrawMLine(&l, am_colors[AMCOL_Ceil]);
-			}
+			h[0] = sectors[i].f_h;
+			h[1] = sectors[i].c_h;
+
+			changed = true;
 		}
 	}
-	else if (f_focus->player && (show_allmap || f_focus->player->powers[PW_AllMap] != 0))
+
+	return changed;
+}
+
+static void UpdateLineCache(void)
+{
+	if ((int)line_has_seg.size() != numlines)
+		InitLineCache();
+
+	bool allmap = f_focus->player &&
+		(show_allmap || f_focus->player->powers[PW_AllMap] != 0);
+
+	int mode = (show_walls ? 1 : 0) | (allmap ? 2 : 0);
+
+	// (the sector heights must be checked every time, to keep the
+	// copy of them up to date)
+	bool changed = SectorsChanged();
+
+	if (! changed && cached_mapped == am_mapped_count && cached_mode == mode)
+		return;
+
+	cached_mapped = am_mapped_count;
+	cached_mode   = mode;
+
+	for (int c = 0; c < AM_NUM_COLORS; c++)
+		cached_lines[c].clear();
+
+	for (int i = 0; i < numlines; i++)
 	{
-		if (! (line->flags & MLF_DontDraw))
-			DrawMLine(&l, am_colors[AMCOL_Allmap]);
+		if (! line_has_seg[i])
+			continue;
+
+		int col = ClassifyLine(&lines[i], allmap);
+
+		if (col >= 0)
+			cached_lines[col].push_back(i);
 	}
 }
 
+void AM_LinesChanged(void)
+{
+	cached_mapped = -1;
+}
+
 
 static void DrawLineCharacter(mline_t *lineguy, int lineguylines, 
 							  float radius, angle_t angle,
@@ -948,78 +1021,78 @@ static void AM_WalkThing(mobj_t *mo)
 
 
 //
-// Visit a subsector and draw everything.
+// Draws the cached lines, and the things.  Everything goes through
+// the HUD line batch, so it ends up as a few draw calls.
 //
-static void AM_WalkSubsector(unsigned int num)
+static void DrawLines(void)
 {
-	subsector_t *sub = &subsectors[num];
+	float left  = f_x;
+	float right = f_x + f_w;
+	float top   = f_y;
+	float bottom= f_y + f_h;
 
-	// handle each seg
-	for (seg_t *seg = sub->segs; seg; seg = seg->sub_next)
+	for (int c = 0; c < AM_NUM_COLORS; c++)
 	{
-		AM_WalkSeg(seg);
-	}
+		const std::vector<int>& list = cached_lines[c];
 
-	// handle each thing
-	for (mobj_t *mo = sub->thinglist; mo; mo = mo->snext)
-	{
-		AM_WalkThing(mo);
-	}
-}
+		for (size_t k = 0; k < list.size(); k++)
+		{
+			line_t *line = &lines[list[k]];
 
+			mline_t l;
 
-//
-// Checks BSP node/subtree bounding box.
-// Returns true if some part of the bbox might be visible.
-//
-static bool AM_CheckBBox(float *bspcoord)
-{
-	float xl = bspcoord[BOXLEFT];
-	float yt = bspcoord[BOXTOP];
-	float xr = bspcoord[BOXRIGHT];
-	float yb = bspcoord[BOXBOTTOM];
+			GetRotatedCoords(line->v1->x, line->v1->y, &l.a.x, &l.a.y);
+			GetRotatedCoords(line->v2->x, line->v2->y, &l.b.x, &l.b.y);
 
-	// TODO: improve this quick'n'dirty hack
-	if (rotatemap)
-		return true;
+			// skip lines which are completely off one side
+			float x1 = CXMTOF(l.a.x), x2 = CXMTOF(l.b.x);
+			float y1 = CYMTOF(l.a.y), y2 = CYMTOF(l.b.y);
+
+			if ((x1 < left && x2 < left) || (x1 > right  && x2 > right) ||
+				(y1 < top  && y2 < top)  || (y1 > bottom && y2 > bottom))
+				continue;
 
-	float x1 = CXMTOF(xl);
-	float x2 = CXMTOF(xr);
+			DrawMLine(&l, am_colors[c]);
+		}
+	}
 
-	float y1 = CYMTOF(yt);
-	float y2 = CYMTOF(yb);
+#if (DEBUG_TRUEBSP == 1)
+	for (int i = 0; i < numsegs; i++)
+	{
+		seg_t *seg = &segs[i];
 
-	// some part of bbox is visible?
-	return HUD_ScissorTest(x1, y1, x2, y2);
-}
+		if (! seg->miniseg || (seg->partner && seg > seg->partner))
+			continue;
 
+		mline_t l;
 
-//
-// Walks all subsectors below a given node, traversing subtree
-// recursively.  Just call with BSP root.
-//
-static void AM_WalkBSPNode(unsigned int bspnum)
-{
-	node_t *node;
-	int side;
+		GetRotatedCoords(seg->v1->x, seg->v1->y, &l.a.x, &l.a.y);
+		GetRotatedCoords(seg->v2->x, seg->v2->y, &l.b.x, &l.b.y);
 
-	// Found a subsector?
-	if (bspnum & NF_V5_SUBSECTOR)
-	{
-		AM_WalkSubsector(bspnum & (~NF_V5_SUBSECTOR));
-		return;
+		DrawMLine(&l, RGB_MAKE(0,0,128), false);
 	}
+#endif
+}
 
-	node = &nodes[bspnum];
-	side = 0;
+static void DrawThings(void)
+{
+	for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
+	{
+		// only things linked into a subsector were drawn before
+		if (mo->flags & MF_NOSECTOR)
+			continue;
+
+		if (! rotatemap)
+		{
+			float R = mo->radius + 64;
 
-	// Recursively divide right space
-	if (AM_CheckBBox(node->bbox[0]))
-		AM_WalkBSPNode(node->children[side]);
+			if (! HUD_ScissorTest(CXMTOF(mo->x - R), CYMTOF(mo->y + R),
+								  CXMTOF(mo->x + R), CYMTOF(mo->y - R)))
+				continue;
+		}
 
-	// Recursively divide back space
-	if (AM_CheckBBox(node->bbox[side ^ 1]))
-		AM_WalkBSPNode(node->children[side ^ 1]);
+		AM_WalkThing(mo);
+	}
 }
 
 
@@ -1054,10 +1127,19 @@ static void DrawMarks(void)
 
 static void AM_RenderScene(void)
 {
+	UpdateLineCache();
+
 	HUD_PushScissor(f_x, f_y, f_x+f_w, f_y+f_h, true);
 
-	// walk the bsp tree
-	AM_WalkBSPNode(root_node);
+	// the batch sorts its lines by colour, so the things get a batch
+	// of their own to stay on top of the walls.
+	HUD_StartLines();
+	DrawLines();
+	HUD_FinishLines();
+
+	HUD_StartLines();
+	DrawThings();
+	HUD_FinishLines();
 
 	HUD_PopScissor();
 }
@@ -1082,7 +1164,11 @@ void AM_Drawer(float x, float y, float w, float h, mobj_t *focus)
 	SYS_ASSERT(automap_style);
 
 	if (grid && !rotatemap)
+	{
+		HUD_StartLines();
 		DrawGrid();
+		HUD_FinishLines();
+	}
 
 	AM_RenderScene();
 
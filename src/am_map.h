@@ -52,6 +52,14 @@ mline_t;
 
 void AM_InitLevel(void);
 
+// Bumped whenever a line becomes mapped, so the automap knows when
+// it must re-classify its lines.
+extern int am_mapped_count;
+
+// Forces the automap lines to be re-classified, e.g. after loading
+// a savegame (which restores the mapped flags directly).
+void AM_LinesChanged(void);
+
 // Called by main loop.
 bool AM_Responder(event_t * ev);
 
@@ -21,6 +21,9 @@
 #include "system/i_defs.h"
 #include "system/i_defs_gl.h"
 #include "system/i_sdlinc.h"
+#include "system/i_pacer.h"
+
+#include <vector>
 
 #include "../ddf/language.h"
 
@@ -34,6 +37,9 @@
 #include "m_shift.h"
 #include "r_draw.h"
 #include "r_image.h"
+#include "r_dlight.h"
+#include "r_bloom.h"
+#include "r_md5.h"
 #include "r_modes.h"
 #include "r_wipe.h"
 
@@ -44,6 +50,10 @@
 
 DEF_CVAR(debug_fps, int, "c", 0);
 DEF_CVAR(debug_pos, int, "c", 0);
+DEF_CVAR(debug_lights, int, "c", 0);
+DEF_CVAR(debug_models, int, "c", 0);
+DEF_CVAR(debug_pacing, int, "c", 0);
+DEF_CVAR(debug_bloom, int, "c", 0);
 DEF_CVAR(debug_ticrate, int, "c", 0);
 
 static visible_t con_visible;
@@ -64,33 +74,33 @@ static rgbcol_t current_color;
 // TODO: console var
 #define MAX_CON_LINES  560
 
-class console_line_c
+// the text of all the lines lives in one circular arena, and the
+// lines themselves in a ring, so adding a line never has to move or
+// allocate anything.  When the arena runs out, the oldest lines get
+// dropped (even if there are less than MAX_CON_LINES of them).
+#define CON_TEXT_SIZE  (128 * 1024)
+
+// longer lines are cut off (they would be off the screen anyway)
+#define MAX_CON_LINE_LEN  2000
+
+typedef struct
 {
-public:
-	std::string line;
+	int start;   // offset into con_text[]
+	int length;  // not including the NUL
 
 	rgbcol_t color;
+}
+console_line_t;
 
-public:
-	console_line_c(const std::string& text, rgbcol_t _col = T_LGREY) :
-		line(text), color(_col)
-	{ }
-
-	console_line_c(const char *text, rgbcol_t _col = T_LGREY) :
-		line(text), color(_col)
-	{ }
+static console_line_t console_lines[MAX_CON_LINES];
 
-	~console_line_c()
-	{ }
+// where the newest line is in console_lines[]
+static int con_head = 0;
 
-	void Append(const char *text)
-	{
-		line = line + std::string(text);
-	}
-};
+static char con_text[CON_TEXT_SIZE];
 
-// entry [0] is the bottom-most one
-static console_line_c * console_lines[MAX_CON_LINES];
+// where the next text goes in con_text[]
+static int con_text_pos = 0;
 
 static int con_used_lines = 0;
 static bool con_partial_last_line = false;
@@ -137,31 +147,124 @@ static bool TabbedLast;
 static int scroll_dir;
 
 
+//
+// Returns a console line, where 0 is the bottom-most one, or NULL if
+// there are not that many lines.
+//
+static const console_line_t *GetLine(int idx)
+{
+	if (idx < 0 || idx >= con_used_lines)
+		return NULL;
+
+	return &console_lines[(con_head - idx + MAX_CON_LINES) % MAX_CON_LINES];
+}
+
+static inline const char *LineText(const console_line_t *CL)
+{
+	return con_text + CL->start;
+}
+
+//
+// Makes room for 'length' bytes at 'pos' in the text arena, dropping
+// the oldest lines whose text is in the way.  The newest 'keep' lines
+// are never dropped.
+//
+static void DropOverlapping(int pos, int length, int keep)
+{
+	while (con_used_lines > keep)
+	{
+		const console_line_t *CL = GetLine(con_used_lines - 1);
+
+		if (CL->start + CL->length + 1 <= pos || CL->start >= pos + length)
+			break;
+
+		con_used_lines--;
+	}
+}
+
+//
+// Finds a place in the arena for a line of 'length' characters (plus
+// the NUL), wrapping around to the beginning when needed.
+//
+static int AllocText(int length, int keep)
+{
+	int pos = con_text_pos;
+
+	if (pos + length + 1 > CON_TEXT_SIZE)
+	{
+		// the lines at the end of the arena are the oldest ones, and
+		// they must go before the ones at the beginning.
+		DropOverlapping(pos, CON_TEXT_SIZE - pos, keep);
+
+		pos = 0;
+	}
+
+	DropOverlapping(pos, length + 1, keep);
+
+	con_text_pos = pos + length + 1;
+
+	return pos;
+}
+
 static void CON_AddLine(const char *s, bool partial)
 {
-	if (con_partial_last_line)
+	int len = (int)strlen(s);
+
+	if (con_partial_last_line && con_used_lines > 0)
 	{
-		SYS_ASSERT(console_lines[0]);
+		console_line_t *CL = &console_lines[con_head];
 
-		console_lines[0]->Append(s);
+		len = MIN(len, MAX_CON_LINE_LEN - CL->length);
+
+		if (CL->start + CL->length + len + 1 <= CON_TEXT_SIZE)
+		{
+			// the newest line is always at the end of the text, so
+			// it can usually just grow.
+			DropOverlapping(CL->start + CL->length, len + 1, 1);
+
+			con_text_pos = CL->start + CL->length + len + 1;
+		}
+		else
+		{
+			// move it to the beginning.  Since lines are much smaller
+			// than the arena, the old and new places cannot overlap.
+			int old_start = CL->start;
+
+			CL->start = AllocText(CL->length + len, 1);
+
+			memmove(con_text + CL->start, con_text + old_start, CL->length);
+		}
+
+		memcpy(con_text + CL->start + CL->length, s, len);
+
+		CL->length += len;
+		con_text[CL->start + CL->length] = 0;
 
 		con_partial_last_line = partial;
 		return;
 	}
 
-	// scroll everything up 
-
-	delete console_lines[MAX_CON_LINES-1];
-
-	for (int i = MAX_CON_LINES-1; i > 0; i--)
-		console_lines[i] = console_lines[i-1];
+	len = MIN(len, MAX_CON_LINE_LEN);
 
 	rgbcol_t col = current_color;
 
 	if (col == T_LGREY && (strncmp(s, "WARNING", 7) == 0))
 		col = T_ORANGE;
 
-	console_lines[0] = new console_line_c(s, col);
+	// the text must be placed before the new line is in the ring,
+	// otherwise it could be dropped by its own text.
+	int start = AllocText(len, 0);
+
+	con_head = (con_head + 1) % MAX_CON_LINES;
+
+	console_line_t *CL = &console_lines[con_head];
+
+	CL->start  = start;
+	CL->length = len;
+	CL->color  = col;
+
+	memcpy(con_text + start, s, len);
+	con_text[start + len] = 0;
 
 	con_partial_last_line = partial;
 
@@ -285,16 +388,52 @@ static void SplitIntoLines(char *src)
 	current_color = T_LGREY;
 }
 
+//
+// Formats the message into 'buffer' when it fits (leaving room for
+// 'extra' more characters), otherwise into a new buffer, doubling the
+// size until it fits, like epi::STR_FormatCStr().  Returns whichever
+// was used, a new one must be freed with delete[].
+//
+static char *FormatMessage(char *buffer, int buf_size, int extra,
+						   const char *fmt, va_list args)
+{
+	char *buf = buffer;
+
+	for (;;)
+	{
+		va_list copy;
+
+		va_copy(copy, args);
+		int out_len = vsnprintf(buf, buf_size - extra, fmt, copy);
+		va_end(copy);
+
+		// old versions of vsnprintf() simply return -1 when
+		// the output doesn't fit.
+		if (out_len >= 0 && out_len < buf_size - extra)
+			return buf;
+
+		if (buf != buffer)
+			delete[] buf;
+
+		buf_size = MAX(buf_size * 2, out_len + extra + 1);
+
+		buf = new char[buf_size];
+	}
+}
+
 void CON_Printf(const char *message, ...)
 {
 	va_list argptr;
 	char buffer[1024];
 
 	va_start(argptr, message);
-	vsprintf(buffer, message, argptr);
+	char *text = FormatMessage(buffer, sizeof(buffer), 0, message, argptr);
 	va_end(argptr);
 
-	SplitIntoLines(buffer);
+	SplitIntoLines(text);
+
+	if (text != buffer)
+		delete[] text;
 }
 
 void CON_Message(const char *message,...)
@@ -305,17 +444,19 @@ void CON_Message(const char *message,...)
 	va_start(argptr, message);
 
 	// Print the message into a text string
-	vsprintf(buffer, message, argptr);
+	char *text = FormatMessage(buffer, sizeof(buffer), 1, message, argptr);
 
 	va_end(argptr);
 
 
-	HU_StartMessage(buffer);
+	HU_StartMessage(text);
 
-	strcat(buffer, "\n");
+	strcat(text, "\n");
 
-	SplitIntoLines(buffer);
+	SplitIntoLines(text);
 
+	if (text != buffer)
+		delete[] text;
 }
 
 void CON_MessageLDF(const char *lookup, ...)
@@ -326,14 +467,17 @@ void CON_MessageLDF(const char *lookup, ...)
 	lookup = language[lookup];
 
 	va_start(argptr, lookup);
-	vsprintf(buffer, lookup, argptr);
+	char *text = FormatMessage(buffer, sizeof(buffer), 1, lookup, argptr);
 	va_end(argptr);
 
-	HU_StartMessage(buffer);
+	HU_StartMessage(text);
+
+	strcat(text, "\n");
 
-	strcat(buffer, "\n");
+	SplitIntoLines(text);
 
-	SplitIntoLines(buffer);
+	if (text != buffer)
+		delete[] text;
 }
 
 void CON_MessageColor(rgbcol_t col)
@@ -365,8 +509,59 @@ static void CalcSizes()
 }
 
 
+// all the text for a frame is collected here, with the colour in
+// each vertex, and drawn with a single call by FlushText().
+typedef struct
+{
+	GLfloat x, y;
+	GLfloat u, v;
+	byte r, g, b, a;
+}
+con_vert_t;
+
+static std::vector<con_vert_t> con_verts;
+
+static void FlushText(void)
+{
+	if (con_verts.empty())
+		return;
+
+	GLuint tex_id = W_ImageCache(con_font);
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, tex_id);
+ 
+	glEnable(GL_BLEND);
+	glEnable(GL_ALPHA_TEST);
+	glAlphaFunc(GL_GREATER, 0);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	glVertexPointer  (2, GL_FLOAT, sizeof(con_vert_t), &con_verts[0].x);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(con_vert_t), &con_verts[0].u);
+	glColorPointer   (4, GL_UNSIGNED_BYTE, sizeof(con_vert_t), &con_verts[0].r);
+
+	glDrawArrays(GL_QUADS, 0, (GLsizei)con_verts.size());
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_BLEND);
+
+	con_verts.clear();
+}
+
+
 static void SolidBox(int x, int y, int w, int h, rgbcol_t col, float alpha)
 {
+	// keep things in the right order
+	FlushText();
+
 	if (alpha < 0.99f)
 		glEnable(GL_BLEND);
   
@@ -395,11 +590,6 @@ static void DrawChar(int x, int y, char ch, rgbcol_t col)
 	if (x + FNSZ < 0)
 		return;
 
-	float alpha = 1.0f;
-
-	glColor4f(RGB_RED(col)/255.0f, RGB_GRN(col)/255.0f, 
-	          RGB_BLU(col)/255.0f, alpha);
-
 	int px =      int((byte)ch) % 16;
 	int py = 15 - int((byte)ch) / 16;
 
@@ -409,55 +599,34 @@ static void DrawChar(int x, int y, char ch, rgbcol_t col)
 	float ty1 = (py  ) / 16.0;
 	float ty2 = (py+1) / 16.0;
 
-	/*glBegin(GL_POLYGON);
-  
-	glTexCoord2f(tx1, ty1);
-	glVertex2i(x, y);
+	byte r = RGB_RED(col);
+	byte g = RGB_GRN(col);
+	byte b = RGB_BLU(col);
 
-	glTexCoord2f(tx1, ty2); 
-	glVertex2i(x, y + FNSZ);
-  
-	glTexCoord2f(tx2, ty2);
-	glVertex2i(x + FNSZ, y + FNSZ);
-  
-	glTexCoord2f(tx2, ty1);
-	glVertex2i(x + FNSZ, y);
-  
-	glEnd();*/
+	con_vert_t quad[4] =
+	{
+		{ (GLfloat) x,        (GLfloat) y,        tx1, ty1, r, g, b, 255 },
+		{ (GLfloat) x,        (GLfloat) y + FNSZ, tx1, ty2, r, g, b, 255 },
+		{ (GLfloat) x + FNSZ, (GLfloat) y + FNSZ, tx2, ty2, r, g, b, 255 },
+		{ (GLfloat) x + FNSZ, (GLfloat) y,        tx2, ty1, r, g, b, 255 }
+	};
 
-	RQImmBuffer<RQVertex3fTextured> buffer(RQVertex3fTextured::format);
-	buffer.add({(float) x, (float)y, 0.f, tx1, ty1});
-	buffer.add({(float) x, (float) y + FNSZ, 0.f, tx1, ty2});
-	buffer.add({(float) x + FNSZ, (float)y + FNSZ, 0.f, tx2, ty2});
-	buffer.add({(float) x + FNSZ, (float) y, 0.f, tx2, ty1});
-	buffer.draw(GL_QUADS);
+	con_verts.insert(con_verts.end(), quad, quad + 4);
 }
 
 // writes the text on coords (x,y) of the console
 static void DrawText(int x, int y, const char *s, rgbcol_t col)
 {
-	GLuint tex_id = W_ImageCache(con_font);
-
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, tex_id);
- 
-	glEnable(GL_BLEND);
-	glEnable(GL_ALPHA_TEST);
-	glAlphaFunc(GL_GREATER, 0);
-
 	for (; *s; s++)
 	{
-		DrawChar(x, y, *s, col);
+		if (*s != ' ')
+			DrawChar(x, y, *s, col);
 
 		x += XMUL;
 
 		if (x >= SCREENWIDTH)
 			break;
 	}
-
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_ALPHA_TEST);
-	glDisable(GL_BLEND);
 }
 
 
@@ -539,21 +708,23 @@ void CON_Drawer(void)
 
 	for (int i = MAX(0,bottomrow); i < MAX_CON_LINES; i++)
 	{
-		console_line_c *CL = console_lines[i];
+		const console_line_t *CL = GetLine(i);
 
 		if (! CL)
 			break;
 
-		if (strncmp(CL->line.c_str(), "--------", 8) == 0)
+		if (strncmp(LineText(CL), "--------", 8) == 0)
 			HorizontalLine(y + YMUL/2, CL->color);
 		else
-			DrawText(0, y, CL->line.c_str(), CL->color);
+			DrawText(0, y, LineText(CL), CL->color);
 
 		y += YMUL;
 
 		if (y >= SCREENHEIGHT)
 			break;
 	}
+
+	FlushText();
 }
 
 
@@ -1134,6 +1305,57 @@ void CON_Ticker(void)
 }
 
 
+void CON_ScrollbackBenchmark(int count)
+{
+	count = MAX(count, 1);
+
+	// filler for lines of varying length
+	static const char *filler =
+		"the quick brown fox jumps over the lazy dog, "
+		"pack my box with five dozen liquor jugs.";
+
+	std::string huge(3000, 'x');
+
+	u32_t t0 = I_ReadMicroSeconds();
+
+	for (int i = 0; i < count; i++)
+	{
+		if (i % 1000 == 999)
+		{
+			// longer than the old fixed buffer
+			CON_Printf("bench %d: %s\n", i, huge.c_str());
+		}
+		else if (i % 16 == 15)
+		{
+			// built from pieces, like the DDF parser does
+			CON_Printf("bench %d:", i);
+			CON_Printf(" partial");
+			CON_Printf(" line\n");
+		}
+		else
+		{
+			CON_Printf("bench %d: %s\n", i, filler + (i % 40));
+		}
+	}
+
+	u32_t t1 = I_ReadMicroSeconds();
+
+	// check the last line came out right
+	char expect[64];
+	sprintf(expect, "bench %d:", count - 1);
+
+	const console_line_t *last = GetLine(0);
+	bool ok = last && strncmp(LineText(last), expect, strlen(expect)) == 0;
+
+	float ms = MAX(1, (int)(t1 - t0)) / 1000.0f;
+
+	CON_Printf("Console scrollback: %d lines in %1.2f ms (%1.0f lines/sec)\n",
+			   count, ms, count * 1000.0f / ms);
+	CON_Printf("  kept %d lines, %d KB text arena, last line %s\n",
+			   con_used_lines, CON_TEXT_SIZE / 1024, ok ? "OK" : "WRONG");
+}
+
+
 //
 // Initialises the console
 //
@@ -1163,7 +1385,8 @@ void CON_ShowFPS(void)
 {
 	CON_SetupFont();
 
-	if (debug_fps <= 0 && debug_pos <= 0)
+	if (debug_fps <= 0 && debug_pos <= 0 && debug_lights <= 0 && debug_models <= 0 &&
+	    debug_pacing <= 0 && debug_bloom <= 0)
 		return;
 
 	static int numframes = 0, lasttime = 0;
@@ -1193,6 +1416,18 @@ void CON_ShowFPS(void)
 	if (debug_pos)
 		lcount += 8;
 
+	if (debug_lights)
+		lcount += 5;
+
+	if (debug_models)
+		lcount += 4;
+
+	if (debug_pacing)
+		lcount += 6;
+
+	if (debug_bloom)
+		lcount += 6;
+
 	int x = SCREENWIDTH  - XMUL * 16;
 	int y = SCREENHEIGHT - YMUL * lcount;
 
@@ -1250,6 +1485,105 @@ void CON_ShowFPS(void)
 		DrawText(x, y, textbuf, T_GREY176);
 		y -= YMUL*2;
 	}
+
+	if (debug_lights)
+	{
+		sprintf(textbuf, "lites: %d/%d", dlight_stats.visible - dlight_stats.dropped,
+				dlight_stats.total);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "tests: %d", dlight_stats.tests);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, " pass: %d", dlight_stats.hits);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, " cull: %d us", dlight_stats.cull_us);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "  mix: %d / %d v", dlight_stats.mix_draws, dlight_stats.mix_verts);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "1pass: %d / %d v", dlight_stats.pass_draws, dlight_stats.pass_verts);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL*2;
+	}
+
+	if (debug_models)
+	{
+		const md5_skin_stats_t& st = md5_skin_stats;
+
+		int hit_pc = (st.instances > 0) ? (st.instances - MIN(st.skinned, st.instances)) * 100 / st.instances : 0;
+
+		sprintf(textbuf, "  md5: %d (%d%%)", st.instances, hit_pc);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "skins: %d", st.skinned);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "verts: %d", st.skinned_verts);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL*2;
+	}
+
+	if (debug_pacing)
+	{
+		const pacer_stats_t& st = pacer_stats;
+
+		sprintf(textbuf, "frame: %1.2f", st.frame_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "  dev: %1.2f", st.dev_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "  max: %1.2f", st.max_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "sleep: %d ms", st.sleep_us / 1000);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, " spin: %d ms", st.spin_us / 1000);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL*2;
+	}
+
+	if (debug_bloom)
+	{
+		const bloom_stats_t& st = bloom_stats;
+
+		sprintf(textbuf, "expos: %1.2f", st.exposure_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "extrc: %1.2f", st.extract_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, " blur: %1.2f", st.blur_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, " comb: %1.2f", st.combine_ms);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL;
+
+		sprintf(textbuf, "  cpu: %d us", st.cpu_us);
+		DrawText(x, y, textbuf, T_GREY176);
+		y -= YMUL*2;
+	}
+
+	FlushText();
 }
 
 
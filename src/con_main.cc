@@ -31,6 +31,11 @@
 #include "g_game.h"
 #include "m_menu.h"
 #include "m_misc.h"
+#include "r_colormap.h"
+#include "r_dlight.h"
+#include "r_md2.h"
+#include "r_texgl.h"
+#include "s_cache.h"
 #include "s_sound.h"
 #include "w_wad.h"
 #include "version.h"
@@ -167,6 +172,43 @@ int CMD_ScreenShot(char **argv, int argc)
 	return 0;
 }
 
+int CMD_Capture(char **argv, int argc)
+{
+	if (argc < 2)
+	{
+		CON_Printf("Usage: capture <frames> [rate]\n");
+		CON_Printf("       capture forever [rate]\n");
+		CON_Printf("       capture stop\n");
+		return 1;
+	}
+
+	if (stricmp(argv[1], "stop") == 0)
+	{
+		M_StopCapture();
+		return 0;
+	}
+
+	int count = -1;
+
+	if (stricmp(argv[1], "forever") != 0)
+	{
+		count = atoi(argv[1]);
+
+		if (count <= 0)
+		{
+			CON_Printf("capture: bad frame count '%s'\n", argv[1]);
+			return 1;
+		}
+	}
+
+	// rate is in captures per second, default is every frame
+	int rate = (argc >= 3) ? atoi(argv[2]) : 0;
+
+	M_StartCapture(count, rate);
+
+	return 0;
+}
+
 int CMD_QuitEDGE(char **argv, int argc)
 {
 #if 0
@@ -256,6 +298,13 @@ int CMD_ShowFiles(char **argv, int argc)
 	return 0;
 }
 
+int CMD_CacheInfo(char **argv, int argc)
+{
+	W_ShowCacheInfo();
+	S_ShowCacheInfo();
+	return 0;
+}
+
 int CMD_ShowLumps(char **argv, int argc)
 {
 	int for_file = -1;  // all files
@@ -277,6 +326,47 @@ int CMD_ShowLumps(char **argv, int argc)
 	return 0;
 }
 
+int CMD_ShowMobjs(char **argv, int argc)
+{
+	P_ShowMobjRegistries();
+	return 0;
+}
+
+int CMD_PalBench(char **argv, int argc)
+{
+	V_PaletteBenchmark();
+	return 0;
+}
+
+int CMD_LightBench(char **argv, int argc)
+{
+	R_DynamicLightBenchmark();
+	return 0;
+}
+
+int CMD_MD2Bench(char **argv, int argc)
+{
+	MD2_Benchmark();
+	return 0;
+}
+
+int CMD_TexBench(char **argv, int argc)
+{
+	R_TextureUploadBenchmark();
+	return 0;
+}
+
+int CMD_ConBench(char **argv, int argc)
+{
+	int count = 20000;
+
+	if (argc >= 2)
+		count = atoi(argv[1]);
+
+	CON_ScrollbackBenchmark(count);
+	return 0;
+}
+
 int CMD_ShowVars(char **argv, int argc)
 {
 	bool show_defaults = false;
@@ -843,13 +933,21 @@ const con_cmd_t builtin_commands[] =
 	{ "playsound",      CMD_PlaySound },
 //	{ "resetkeys",      CMD_ResetKeys },
 	{ "resetvars",      CMD_ResetVars },
+	{ "cacheinfo",      CMD_CacheInfo },
 	{ "showfiles",      CMD_ShowFiles },
   	{ "showjoysticks",  CMD_ShowJoysticks },
 //	{ "showkeys",       CMD_ShowKeys },
 	{ "showlumps",      CMD_ShowLumps },
 	{ "showcmds",       CMD_ShowCmds },
+	{ "showmobjs",      CMD_ShowMobjs },
+	{ "palbench",       CMD_PalBench },
+	{ "lightbench",     CMD_LightBench },
+	{ "md2bench",       CMD_MD2Bench },
+	{ "conbench",       CMD_ConBench },
+	{ "texbench",       CMD_TexBench },
 	{ "showvars",       CMD_ShowVars },
 	{ "screenshot",     CMD_ScreenShot },
+	{ "capture",        CMD_Capture },
 	{ "type",           CMD_Type },
 	{ "version",        CMD_Version },
 	{ "quit",           CMD_QuitEDGE },
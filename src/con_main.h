@@ -57,6 +57,10 @@ visible_t;
 // Displays/Hides the console.
 void CON_SetVisible(visible_t v);
 
+// Prints lots of lines into the console (nothing is drawn) and
+// shows how fast that was.
+void CON_ScrollbackBenchmark(int count);
+
 int CON_MatchAllCmds(std::vector<const char *>& list,
                      const char *pattern);
 
@@ -94,6 +94,8 @@
 #else
 #include "system/i_ffmpeg.h"
 #endif
+#include "system/i_log.h"
+#include "system/i_pacer.h"
 #include "system/i_x86.h"
 
 #include "../epi/pfd.h"
@@ -730,6 +732,11 @@ void E_Display(void)
 			M_ScreenShot(false);
 	}
 
+	M_CaptureFrame();
+
+	// collect finished screen reads, report saved shots
+	M_UpdateScreenShots(false);
+
 	// draw console _after_ doing screenshots
 	CON_Drawer();
 
@@ -1748,6 +1755,9 @@ static void SetupLogAndDebugFiles(void)
 		//if (!shadercompilefile)
 			//I_Warning("[E_Startup] Unable to create shadercompilefile");
 	}
+
+	// log messages are written out by a background thread from now on
+	I_StartupLog();
 }
 
 static void AddSingleCmdLineFile(const char *name)
@@ -1922,6 +1932,9 @@ void E_EngineShutdown(void)
 	if (demorecording)
 		G_FinishDemo();
 
+	// finish off any screenshots still in progress
+	M_UpdateScreenShots(true);
+
 	N_QuitNetGame();
 
 	S_StopMusic();
@@ -2338,7 +2351,8 @@ void E_Tick(void)
 	// Render frames until it's time to run a gametic
 	// Measure frame length in order to avoid
 	float interpstart = 0, interpdiff = 0;
-	static int nextframe = 0;
+	static u64_t nextframe = 0;
+
 	do {
 		interpstart += interpdiff;
 
@@ -2346,15 +2360,22 @@ void E_Tick(void)
 
 		if (r_maxfps > 0)
 		{
-			while (I_GetMillies() < nextframe)
+			u64_t now = I_PreciseMicroSeconds();
+			u64_t period = 1000000 / r_maxfps;
+
+			if (nextframe > now && nextframe - now <= period)
 			{
-				//just in case someone plays for over 24 days and nextframe/getmillies overflow
-				if ((nextframe - I_GetMillies()) > 1000)
-					break;
+				I_WaitUntil(nextframe);
+
+				// step from the deadline, so the rate does not drift
+				nextframe += period;
 			}
-			nextframe = I_GetMillies() + 1000.0f / r_maxfps;
+			else
+				nextframe = now + period;
 		}
 
+		I_PacerFrame();
+
 		N_SetInterpolater();
 		E_Display();
 
@@ -375,6 +375,8 @@ static void P_SpawnPlayer(player_t *p, const spawnpoint_t *point, bool is_hub)
 	mobj->player = p;
 	mobj->health = p->health;
 
+	P_RefileMobj(mobj);
+
 	p->mo = mobj;
 	p->playerstate = PST_LIVE;
 	p->refire = 0;
@@ -431,6 +433,8 @@ static void P_SpawnVoodooDoll(player_t *p, const spawnpoint_t *point)
 	mobj->player = p;
 	mobj->health = p->health;
 
+	P_RefileMobj(mobj);
+
 	if (COOP_MATCH())
 		mobj->side = ~0;
 
@@ -56,6 +56,7 @@
 #include "s_music.h"
 #include "w_wad.h"
 #include "w_model.h"
+#include "w_prefetch.h"
 
 
 typedef enum
@@ -277,6 +278,8 @@ void F_Ticker(void)
 {
 	SYS_ASSERT(gamestate == GS_FINALE);
 
+	W_PrefetchTicker();
+
 	// advance animation
 	finalecount++;
 
@@ -45,6 +45,7 @@
 #include "r_misc.h"
 #include "r_draw.h"
 #include "r_modes.h"
+#include "w_prefetch.h"
 
 
 //
@@ -1340,6 +1341,8 @@ void WI_Ticker(void)
 
 	SYS_ASSERT(gamestate == GS_INTERMISSION);
 
+	W_PrefetchTicker();
+
 	int i;
 
 	// counter for general background animation
@@ -1601,6 +1604,9 @@ void WI_Start(void)
 			break;
 		}
 	}
+
+	// read the next map while the player looks at the stats
+	W_StartPrefetch(wi_stats.next);
 }
 
 
@@ -538,7 +538,10 @@ static void RespawnPlayer(player_t *p)
 {
 	// first disassociate the corpse (if any)
 	if (p->mo)
+	{
 		p->mo->player = NULL;
+		P_RefileMobj(p->mo);
+	}
 
 	p->mo = NULL;
 
@@ -842,6 +845,7 @@ static bool G_LoadGameFromFile(const char *filename, bool is_hub)
 	if (SV_LoadEverything() && SV_GetError() == 0)
 	{
 		/* all went well */
+		AM_LinesChanged();
 	}
 	else
 	{
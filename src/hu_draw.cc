@@ -19,6 +19,9 @@
 #include "system/i_defs.h"
 #include "system/i_defs_gl.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "../ddf/font.h"
 
 #include "dm_state.h"
@@ -67,6 +70,25 @@ static float margin_H;
 #define VERT_SPACING  2.0f
 
 
+// lines collected between HUD_StartLines and HUD_FinishLines
+typedef struct
+{
+	float x1, y1, x2, y2;
+
+	rgbcol_t col;
+	float alpha;
+
+	bool thick;
+	bool smooth;
+}
+hud_line_t;
+
+static std::vector<hud_line_t> hud_lines;
+static bool hud_batching;
+
+static void FlushLines(void);
+
+
 void HUD_SetCoordSys(int width, int height)
 {
 	cur_coord_W = width;
@@ -189,6 +211,9 @@ void HUD_PushScissor(float x1, float y1, float x2, float y2, bool expand)
 {
 	SYS_ASSERT(sci_stack_top < MAX_SCISSOR_STACK);
 
+	// batched lines belong to the old scissor rectangle
+	FlushLines();
+
 	// expand rendered view to cover whole screen
 	if (expand && x1 < 1 && x2 > cur_coord_W-1)
 	{
@@ -250,6 +275,8 @@ void HUD_PopScissor()
 {
 	SYS_ASSERT(sci_stack_top > 0);
 
+	FlushLines();
+
 	sci_stack_top--;
 
 	if (sci_stack_top == 0)
@@ -488,6 +515,22 @@ void HUD_SolidLine(float x1, float y1, float x2, float y2, rgbcol_t col,
 	dx = COORD_X(dx) - COORD_X(0);
 	dy = COORD_Y( 0) - COORD_Y(dy);
 
+	if (hud_batching)
+	{
+		hud_line_t L;
+
+		L.x1 = (int)x1 + (int)dx;  L.y1 = (int)y1 + (int)dy;
+		L.x2 = (int)x2 + (int)dx;  L.y2 = (int)y2 + (int)dy;
+
+		L.col    = col;
+		L.alpha  = cur_alpha;
+		L.thick  = thick;
+		L.smooth = smooth;
+
+		hud_lines.push_back(L);
+		return;
+	}
+
 	if (thick)
 		glLineWidth(1.5f);
 #ifndef NO_LINE_SMOOTH
@@ -514,6 +557,105 @@ void HUD_SolidLine(float x1, float y1, float x2, float y2, rgbcol_t col,
 }
 
 
+struct Compare_Line_pred
+{
+	inline bool operator() (const hud_line_t& A, const hud_line_t& B) const
+	{
+		if (A.thick != B.thick)
+			return A.thick < B.thick;
+
+		if (A.smooth != B.smooth)
+			return A.smooth < B.smooth;
+
+		if (A.alpha != B.alpha)
+			return A.alpha < B.alpha;
+
+		return A.col < B.col;
+	}
+};
+
+//
+// FlushLines
+//
+// Draws the batched lines, with one glDrawArrays call for each
+// combination of colour, alpha, width and smoothing.
+//
+static void FlushLines(void)
+{
+	if (hud_lines.empty())
+		return;
+
+	Compare_Line_pred pred;
+
+	std::stable_sort(hud_lines.begin(), hud_lines.end(), pred);
+
+	static std::vector<GLfloat> verts;
+
+	verts.resize(hud_lines.size() * 4);
+
+	for (size_t i = 0; i < hud_lines.size(); i++)
+	{
+		const hud_line_t& L = hud_lines[i];
+
+		verts[i*4 + 0] = L.x1;  verts[i*4 + 1] = L.y1;
+		verts[i*4 + 2] = L.x2;  verts[i*4 + 3] = L.y2;
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, &verts[0]);
+
+	for (size_t first = 0; first < hud_lines.size(); )
+	{
+		const hud_line_t& L = hud_lines[first];
+
+		size_t last = first + 1;
+
+		while (last < hud_lines.size() &&
+			   ! pred(L, hud_lines[last]) && ! pred(hud_lines[last], L))
+		{
+			last++;
+		}
+
+		if (L.thick)
+			glLineWidth(1.5f);
+#ifndef NO_LINE_SMOOTH
+		if (L.smooth)
+			glEnable(GL_LINE_SMOOTH);
+#endif
+		if (L.smooth || L.alpha < 0.99f)
+			glEnable(GL_BLEND);
+
+		glColor4f(RGB_RED(L.col)/255.0, RGB_GRN(L.col)/255.0, RGB_BLU(L.col)/255.0, L.alpha);
+
+		glDrawArrays(GL_LINES, (GLint)first * 2, (GLsizei)(last - first) * 2);
+
+		glDisable(GL_BLEND);
+#ifndef NO_LINE_SMOOTH
+		glDisable(GL_LINE_SMOOTH);
+#endif
+		glLineWidth(1.0f);
+
+		first = last;
+	}
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	hud_lines.clear();
+}
+
+void HUD_StartLines(void)
+{
+	hud_batching = true;
+}
+
+void HUD_FinishLines(void)
+{
+	FlushLines();
+
+	hud_batching = false;
+}
+
+
 void HUD_ThinBox(float x1, float y1, float x2, float y2, rgbcol_t col)
 {
 	std::swap(y1, y2);
@@ -629,6 +771,99 @@ void HUD_DrawChar(float left_x, float top_y, const image_c *img)
 }
 
 
+//
+// Characters which are in the font's atlas are collected here, and
+// the whole string is drawn with one bind and one draw call.
+//
+static std::vector<GLfloat> text_verts;
+
+static void AddGlyph(float left_x, float top_y, const image_c *img,
+					 const font_glyph_t *G)
+{
+	float sc_x = cur_scale; // TODO * aspect;
+	float sc_y = cur_scale;
+
+	float x = left_x - IM_OFFSETX(img) * sc_x;
+	float y = top_y  - IM_OFFSETY(img) * sc_y;
+
+	float w = IM_WIDTH(img)  * sc_x;
+	float h = IM_HEIGHT(img) * sc_y;
+
+	// same rounding and clipping as HUD_RawImage
+	int x1 = I_ROUND(COORD_X(x));
+	int x2 = I_ROUND(COORD_X(x+w) + 0.25f);
+
+	int y1 = I_ROUND(COORD_Y(y+h));
+	int y2 = I_ROUND(COORD_Y(y) + 0.25f);
+
+	if (x1 >= x2 || y1 >= y2)
+		return;
+
+	if (x2 < 0 || x1 > SCREENWIDTH ||
+		y2 < 0 || y1 > SCREENHEIGHT)
+		return;
+
+	GLfloat quad[16] =
+	{
+		(GLfloat)x1, (GLfloat)y1, G->tx1, G->ty1,
+		(GLfloat)x2, (GLfloat)y1, G->tx2, G->ty1,
+		(GLfloat)x2, (GLfloat)y2, G->tx2, G->ty2,
+		(GLfloat)x1, (GLfloat)y2, G->tx1, G->ty2
+	};
+
+	text_verts.insert(text_verts.end(), quad, quad + 16);
+}
+
+static void FlushText(GLuint tex_id, int opacity)
+{
+	if (text_verts.empty())
+		return;
+
+	float alpha = cur_alpha;
+	float r = 1.0f, g = 1.0f, b = 1.0f;
+
+	if (cur_color != RGB_NO_VALUE)
+	{
+		r = RGB_RED(cur_color) / 255.0;
+		g = RGB_GRN(cur_color) / 255.0;
+		b = RGB_BLU(cur_color) / 255.0;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, tex_id);
+
+	// the atlas is never solid (there are gaps between characters)
+	glEnable(GL_ALPHA_TEST);
+
+	if (! (alpha < 0.11f || opacity == OPAC_Complex))
+		glAlphaFunc(GL_GREATER, alpha * 0.66f);
+
+	if (opacity == OPAC_Complex || alpha < 0.99f)
+		glEnable(GL_BLEND);
+
+	glColor4f(r, g, b, alpha);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	glVertexPointer  (2, GL_FLOAT, 4 * sizeof(GLfloat), &text_verts[0]);
+	glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &text_verts[2]);
+
+	glDrawArrays(GL_QUADS, 0, (GLsizei)(text_verts.size() / 4));
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_ALPHA_TEST);
+	glDisable(GL_BLEND);
+
+	glAlphaFunc(GL_GREATER, 0);
+
+	text_verts.clear();
+}
+
+
 //
 // Write a string using the current font
 //
@@ -636,6 +871,8 @@ void HUD_DrawText(float x, float y, const char *str)
 {
 	SYS_ASSERT(cur_font);
 
+	GLuint atlas = cur_font->AtlasTexture(cur_color != RGB_NO_VALUE);
+
 	float cy = y;
 
 	if (cur_y_align >= 0)
@@ -675,8 +912,11 @@ void HUD_DrawText(float x, float y, const char *str)
 			char ch = str[k];
 
 			const image_c *img = cur_font->CharImage(ch);
+			const font_glyph_t *G = atlas ? cur_font->CharGlyph(ch) : NULL;
 
-			if (img)
+			if (img && G)
+				AddGlyph(cx, cy, img, G);
+			else if (img)
 				HUD_DrawChar(cx, cy, img);
 
 			cx += cur_font->CharWidth(ch) * cur_scale;
@@ -688,6 +928,8 @@ void HUD_DrawText(float x, float y, const char *str)
 		str += (len + 1);
 		cy  += HUD_FontHeight() + VERT_SPACING;
 	}
+
+	FlushText(atlas, cur_font->AtlasOpacity());
 }
 
 // forward declaration to detect outdated opengl
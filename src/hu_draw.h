@@ -81,6 +81,12 @@ void HUD_SolidLine(float x1, float y1, float x2, float y2, rgbcol_t col,
 // to the current scissor rectangle.  The dx/dy fields are used by
 // the automap code to reduce the wobblies.
 
+void HUD_StartLines(void);
+void HUD_FinishLines(void);
+// Lines drawn by HUD_SolidLine between these two calls are collected,
+// then drawn grouped by colour (a few draw calls instead of one per
+// line).  Changing the scissor also draws the lines collected so far.
+
 void HUD_ThinBox(float x1, float y1, float x2, float y2, rgbcol_t col);
 // Draw a thin outline of a box.
 
@@ -17,6 +17,9 @@
 //----------------------------------------------------------------------------
 
 #include "system/i_defs.h"
+#include "system/i_defs_gl.h"
+
+#include "../epi/image_data.h"
 
 #include "../ddf/main.h"
 #include "../ddf/font.h"
@@ -29,9 +32,16 @@
 #include "r_draw.h"
 #include "r_modes.h"
 #include "r_image.h"
+#include "r_texgl.h"
 
 #define DUMMY_WIDTH  4
 
+// largest atlas texture we will make for a font
+#define MAX_ATLAS_SIZE  2048
+
+// space between glyphs in the atlas, so smoothing does not bleed
+#define ATLAS_PAD  2
+
 // all the fonts that's fit to print
 font_container_c hu_fonts;
 
@@ -45,6 +55,15 @@ font_c::font_c(fontdef_c *_def) : def(_def)
 
 	im_div.sub_w = 0;
 	im_div.sub_h = 0;
+
+	atlas_img[0] = atlas_img[1] = NULL;
+	atlas_tex[0] = atlas_tex[1] = 0;
+
+	glyphs = NULL;
+	atlas_opacity = OPAC_Masked;
+
+	atlas_wanted = false;
+	atlas_built  = false;
 }
 
 font_c::~font_c()
@@ -52,6 +71,8 @@ font_c::~font_c()
 	if (p_cache.images)
 		delete[] p_cache.images;
 
+	DeleteAtlas();
+
 	// FIXME: im_div.images
 }
 
@@ -148,6 +169,243 @@ void font_c::LoadPatches()
 
 	p_cache.width = I_ROUND(IM_WIDTH(Nom));  // XXX: make fields float???
 	p_cache.height = I_ROUND(IM_HEIGHT(Nom));
+
+	atlas_wanted = true;
+}
+
+//
+// Packs all the characters of a patch font into a single image, row
+// by row.  Nothing is made if they would not fit in MAX_ATLAS_SIZE,
+// and the characters are then drawn one at a time like before.
+//
+void font_c::BuildAtlas()
+{
+	int total = p_cache.last - p_cache.first + 1;
+
+	// the last entry is for the missing patch
+	const image_c **images = new const image_c *[total + 1];
+
+	for (int i = 0; i < total; i++)
+		images[i] = p_cache.images[i];
+
+	images[total] = p_cache.missing;
+
+	epi::image_data_c **pieces[2];
+
+	pieces[0] = new epi::image_data_c *[total + 1];
+	pieces[1] = new epi::image_data_c *[total + 1];
+
+	// size of each piece in the atlas
+	int *piece_w = new int[total + 1];
+	int *piece_h = new int[total + 1];
+
+	int widest = 0;
+	int count  = 0;
+
+	for (int i = 0; i <= total; i++)
+	{
+		pieces[0][i] = pieces[1][i] = NULL;
+
+		// animated characters need the normal path
+		if (! images[i] || images[i]->anim.cur != images[i] ||
+			images[i]->anim.next != NULL)
+			continue;
+
+		pieces[0][i] = W_ImageReadRGBA(images[i], false);
+
+		if (! pieces[0][i])
+			continue;
+
+		pieces[1][i] = W_ImageReadRGBA(images[i], true);
+
+		// Hq2x scaled characters have more pixels than the image says
+		int scale = MAX(1, pieces[0][i]->width / images[i]->total_w);
+
+		piece_w[i] = images[i]->actual_w * scale;
+		piece_h[i] = images[i]->actual_h * scale;
+
+		widest = MAX(widest, piece_w[i]);
+		count++;
+
+		if (images[i]->opacity == OPAC_Complex)
+			atlas_opacity = OPAC_Complex;
+	}
+
+	// find the smallest size which everything fits into
+	int atlas_w = 64;
+	int atlas_h = 0;
+
+	for (;;)
+	{
+		int x = 0, y = 0, row_h = 0;
+
+		for (int i = 0; i <= total; i++)
+		{
+			if (! pieces[0][i])
+				continue;
+
+			int w = piece_w[i] + ATLAS_PAD;
+			int h = piece_h[i] + ATLAS_PAD;
+
+			if (x + w > atlas_w)
+			{
+				x = 0; y += row_h; row_h = 0;
+			}
+
+			x += w;
+			row_h = MAX(row_h, h);
+		}
+
+		atlas_h = W_MakeValidSize(y + row_h);
+
+		if ((atlas_h <= atlas_w && widest + ATLAS_PAD <= atlas_w) ||
+			atlas_w >= MAX_ATLAS_SIZE)
+			break;
+
+		atlas_w *= 2;
+	}
+
+	if (count > 0 && atlas_h <= MAX_ATLAS_SIZE && widest + ATLAS_PAD <= atlas_w)
+	{
+		glyphs = new font_glyph_t[total + 1];
+
+		for (int k = 0; k < 2; k++)
+		{
+			atlas_img[k] = new epi::image_data_c(atlas_w, atlas_h, 4);
+			atlas_img[k]->Clear(0);
+		}
+
+		int x = 0, y = 0, row_h = 0;
+
+		for (int i = 0; i <= total; i++)
+		{
+			font_glyph_t *G = &glyphs[i];
+
+			G->tx1 = G->ty1 = G->tx2 = G->ty2 = -1;
+
+			if (! pieces[0][i])
+				continue;
+
+			int w = piece_w[i];
+			int h = piece_h[i];
+
+			if (x + w + ATLAS_PAD > atlas_w)
+			{
+				x = 0; y += row_h; row_h = 0;
+			}
+
+			for (int k = 0; k < 2; k++)
+			{
+				epi::image_data_c *src = pieces[k][i];
+
+				for (int py = 0; py < MIN(h, src->height); py++)
+				for (int px = 0; px < MIN(w, src->width);  px++)
+				{
+					memcpy(atlas_img[k]->PixelAt(x + px, y + py),
+						   src->PixelAt(px, py), 4);
+				}
+			}
+
+			G->tx1 = x / (float)atlas_w;
+			G->ty1 = y / (float)atlas_h;
+			G->tx2 = (x + w) / (float)atlas_w;
+			G->ty2 = (y + h) / (float)atlas_h;
+
+			x += w + ATLAS_PAD;
+			row_h = MAX(row_h, h + ATLAS_PAD);
+		}
+
+		I_Debugf("Font [%s] : atlas %dx%d\n", def->name.c_str(), atlas_w, atlas_h);
+	}
+
+	for (int i = 0; i <= total; i++)
+	{
+		delete pieces[0][i];
+		delete pieces[1][i];
+	}
+
+	delete[] pieces[0];
+	delete[] pieces[1];
+	delete[] piece_w;
+	delete[] piece_h;
+	delete[] images;
+}
+
+//
+// Returns where the character is in the atlas, or NULL if the font
+// has no atlas, or the character needs drawing the normal way.
+// Spaces give NULL too.
+//
+const font_glyph_t *font_c::CharGlyph(char ch) const
+{
+	if (! glyphs)
+		return NULL;
+
+	int total = p_cache.last - p_cache.first + 1;
+
+	if (!HasChar(ch))
+	{
+		if ('a' <= ch && ch <= 'z' && HasChar(toupper(ch)))
+			ch = toupper(ch);
+		else if (ch == ' ' || ! p_cache.missing)
+			return NULL;
+		else
+			return (glyphs[total].tx1 < 0) ? NULL : &glyphs[total];
+	}
+
+	int idx = (int(ch) & 0x00FF) - p_cache.first;
+
+	if (glyphs[idx].tx1 < 0)
+		return NULL;
+
+	return &glyphs[idx];
+}
+
+GLuint font_c::AtlasTexture(bool whiten)
+{
+	int k = whiten ? 1 : 0;
+
+	if (atlas_wanted && ! atlas_built)
+	{
+		BuildAtlas();
+		atlas_built = true;
+	}
+
+	if (! atlas_img[k])
+		return 0;
+
+	if (atlas_tex[k] == 0)
+	{
+		atlas_tex[k] = R_UploadTexture(atlas_img[k], UPL_Clamp |
+			(var_smoothing ? UPL_Smooth : 0) |
+			(atlas_opacity == OPAC_Masked ? UPL_Thresh : 0));
+	}
+
+	return atlas_tex[k];
+}
+
+void font_c::DeleteAtlas()
+{
+	for (int k = 0; k < 2; k++)
+	{
+		if (atlas_tex[k] != 0)
+		{
+			glDeleteTextures(1, &atlas_tex[k]);
+			atlas_tex[k] = 0;
+		}
+
+		delete atlas_img[k];
+		atlas_img[k] = NULL;
+	}
+
+	if (glyphs)
+	{
+		delete[] glyphs;
+		glyphs = NULL;
+	}
+
+	atlas_opacity = OPAC_Masked;
+	atlas_built   = false;
 }
 
 void font_c::LoadImageDiv()
@@ -343,6 +601,20 @@ void font_c::DrawChar320(float x, float y, char ch, float scale, float aspect,
 //  font_container_c class
 //----------------------------------------------------------------------------
 
+//
+// Called when the GL textures have all been thrown away (e.g. after
+// changing the screen mode).  They get remade when next drawn.
+//
+void DeleteFontTextures(void)
+{
+	for (epi::array_iterator_c it = hu_fonts.GetIterator(0); it.IsValid(); it++)
+	{
+		font_c *f = ITERATOR_TO_TYPE(it, font_c*);
+
+		f->DeleteAtlas();
+	}
+}
+
 void font_container_c::CleanupObject(void *obj)
 {
 	font_c *a = *(font_c**)obj;
@@ -40,6 +40,15 @@ typedef struct
 patchcache_t;
 
 
+// where a glyph is in the font's atlas (texture coordinates)
+typedef struct
+{
+	float tx1, ty1;
+	float tx2, ty2;
+}
+font_glyph_t;
+
+
 #define MAX_IMAGE_SUBDIV  4
 
 typedef struct
@@ -69,6 +78,21 @@ private:
 
 	image_subdiv_t im_div;
 
+	// patch fonts get all their characters packed into one texture,
+	// so a string can be drawn with a single bind and draw call.
+	// The second one is whitened, for coloured text.  It is built on
+	// first use, and again after the image settings have changed.
+	bool atlas_wanted;
+	bool atlas_built;
+
+	epi::image_data_c *atlas_img[2];
+	unsigned int atlas_tex[2];  // GLuint
+
+	// one per entry in p_cache.images, plus one for the missing patch
+	font_glyph_t *glyphs;
+
+	int atlas_opacity;
+
 public:
 	void Load();
 
@@ -88,10 +112,19 @@ public:
 	// FIXME: maybe shouldn't be public (assumes FNTYP_Patch !!)
 	const image_c *CharImage(char ch) const;
 
+	// the atlas (NULL glyph / zero texture when the font has none)
+	const font_glyph_t *CharGlyph(char ch) const;
+	unsigned int AtlasTexture(bool whiten);
+	int AtlasOpacity() const { return atlas_opacity; }
+
+	// frees the atlas, it gets rebuilt when next used
+	void DeleteAtlas();
+
 private:
 	void BumpPatchName(char *name);
 	void LoadPatches();
 	void LoadImageDiv();
+	void BuildAtlas();
 };
 
 class font_container_c : public epi::array_c 
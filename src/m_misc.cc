@@ -65,9 +65,13 @@
 #include "r_wipe.h"
 #include "version.h"
 
+#include "system/i_log.h"
+#include "system/i_thread.h"
+
 #include "defaults.h"
 
 #include <iostream> // TODO: remove
+#include <list>
 
 //
 // DEFAULTS
@@ -579,19 +583,82 @@ void M_DisplayDisk(void)
 #define PIXEL_BLU(pix)  (playpal_data[0][pix][2])
 
 
-void M_ScreenShot(bool show_msg)
+//
+// Screenshots are taken in three steps: the framebuffer is read with
+// RGL_BeginReadScreen() (a GPU-side copy when pixel buffers exist),
+// the pixels are collected a frame or two later by
+// M_UpdateScreenShots(), and the PNG/JPEG encoding happens on a
+// worker thread.  The main thread never waits except when too many
+// shots are in flight (so burst captures don't drop frames).
+//
+
+typedef enum
 {
-	const char *extension;
+	SHOT_Reading = 0,
+	SHOT_Encoding,
+	SHOT_Saved,
+	SHOT_Failed
+}
+shot_state_e;
 
-	if (png_scrshots)
-		extension = "png";
-	else
-		extension = "jpg";
+typedef struct
+{
+	screen_read_t *read;
 
-	std::string fn;
+	epi::image_data_c *img;
 
-	// find a file name to save it to
-	for (int i = 1; i <= 9999; i++)
+	std::string filename;
+
+	bool png;
+	bool show_msg;
+
+	std::atomic<int> state;
+}
+pending_shot_t;
+
+static std::list<pending_shot_t *> pending_shots;
+
+static job_group_c shot_jobs;
+
+// next number to try for "shotNN" file names
+static int next_shot_num = 1;
+
+// burst capture (the "capture" console command)
+static int capture_left  = 0;  // -1 for continuous
+static int capture_rate  = 0;  // captures per second, 0 = every frame
+static int capture_time  = 0;
+static int capture_count = 0;
+
+
+static void EncodeShot(void *data)
+{
+	pending_shot_t *shot = (pending_shot_t *) data;
+
+	bool result = false;
+
+	FILE *fp = fopen(shot->filename.c_str(), "wb");
+
+	if (fp)
+	{
+		if (shot->png)
+			result = epi::PNG_Save(fp, shot->img);
+		else
+			result = epi::JPEG_Save(fp, shot->img);
+
+		fclose(fp);
+	}
+
+	delete shot->img;
+	shot->img = NULL;
+
+	shot->state = result ? SHOT_Saved : SHOT_Failed;
+}
+
+static bool FindShotName(const char *extension, std::string& fn)
+{
+	// only probe from the last used number, the names handed out to
+	// pending shots may not exist on disk yet.
+	for (int i = next_shot_num; i <= 9999; i++)
 	{
 		std::string base(epi::STR_Format("shot%02d.%s", i, extension));
 
@@ -599,12 +666,92 @@ void M_ScreenShot(bool show_msg)
 
 		if (! epi::FS_Access(fn.c_str(), epi::file_c::ACCESS_READ))
 		{
-			break; // file doesn't exist
+			next_shot_num = i + 1;
+			return true;
 		}
 	}
 
-	FILE *fp = fopen(fn.c_str(), "wb");
-	if (fp == NULL)
+	return false;
+}
+
+//
+// M_UpdateScreenShots
+//
+// Collects finished screen reads, hands them to the encoder and
+// reports saved files.  Called once per frame; with 'wait' it
+// finishes every pending shot before returning.
+//
+void M_UpdateScreenShots(bool wait)
+{
+	std::list<pending_shot_t *>::iterator it;
+
+	for (it = pending_shots.begin(); it != pending_shots.end(); it++)
+	{
+		pending_shot_t *shot = *it;
+
+		if (shot->state != SHOT_Reading)
+			continue;
+
+		if (! RGL_FinishReadScreen(shot->read, shot->img->PixelAt(0,0), wait))
+			continue;
+
+		shot->read  = NULL;
+		shot->state = SHOT_Encoding;
+
+		shot_jobs.Add(EncodeShot, shot);
+	}
+
+	if (wait)
+		shot_jobs.Wait();
+
+	while (! pending_shots.empty())
+	{
+		pending_shot_t *shot = pending_shots.front();
+
+		int state = shot->state;
+
+		if (state != SHOT_Saved && state != SHOT_Failed)
+			break;
+
+		if (shot->show_msg)
+		{
+			if (state == SHOT_Saved)
+				I_Printf("Captured to file: %s\n", shot->filename.c_str());
+			else
+				I_Printf("Error saving file: %s\n", shot->filename.c_str());
+		}
+
+		pending_shots.pop_front();
+
+		delete shot;
+	}
+}
+
+void M_ScreenShot(bool show_msg)
+{
+	const char *extension;
+
+	if (png_scrshots)
+		extension = "png";
+	else
+		extension = "jpg";
+
+	// limit the memory tied up in pending shots.  Rather than drop
+	// a frame, wait here for the oldest ones to finish.
+	int max_pending = MAX(2, I_NumWorkers() + 2);
+
+	if ((int)pending_shots.size() >= max_pending)
+	{
+		M_UpdateScreenShots(false);
+
+		if ((int)pending_shots.size() >= max_pending)
+			M_UpdateScreenShots(true);
+	}
+
+	std::string fn;
+
+	// find a file name to save it to
+	if (! FindShotName(extension, fn))
 	{
 		if (show_msg)
 			I_Printf("Unable to create file: %s\n", fn.c_str());
@@ -612,27 +759,78 @@ void M_ScreenShot(bool show_msg)
 		return;
 	}
 
-	epi::image_data_c *img = new epi::image_data_c(SCREENWIDTH, SCREENHEIGHT, 3);
+	pending_shot_t *shot = new pending_shot_t;
 
-	RGL_ReadScreen(0, 0, SCREENWIDTH, SCREENHEIGHT, img->PixelAt(0,0));
+	shot->img = new epi::image_data_c(SCREENWIDTH, SCREENHEIGHT, 3);
+	shot->filename = fn;
+	shot->png = png_scrshots;
+	shot->show_msg = show_msg;
+	shot->state = SHOT_Reading;
 
-	bool result;
-	if (png_scrshots)
-		result = epi::PNG_Save(fp, img);
-	else
-		result = epi::JPEG_Save(fp, img);
+	shot->read = RGL_BeginReadScreen(0, 0, SCREENWIDTH, SCREENHEIGHT);
 
-	if (show_msg)
+	pending_shots.push_back(shot);
+}
+
+//
+// M_StartCapture
+//
+// Begins capturing 'count' frames (or continuously when negative),
+// 'rate' times per second or on every frame when zero.  Rates above
+// 1000 are taken as 1000, since the timing is in milliseconds.
+//
+void M_StartCapture(int count, int rate)
+{
+	capture_left  = count;
+	capture_rate  = CLAMP(0, rate, 1000);
+	capture_time  = I_GetMillies();
+	capture_count = 0;
+}
+
+void M_StopCapture(void)
+{
+	if (capture_left != 0)
+		I_Printf("Capture stopped after %d frames\n", capture_count);
+
+	capture_left = 0;
+}
+
+//
+// M_CaptureFrame
+//
+// Called once per frame from the display code, takes a shot when
+// a burst capture is active and the next one is due.
+//
+void M_CaptureFrame(void)
+{
+	if (capture_left == 0)
+		return;
+
+	if (capture_rate > 0)
 	{
-		if (result)
-			I_Printf("Captured to file: %s\n", fn.c_str());
-		else
-			I_Printf("Error saving file: %s\n", fn.c_str());
+		int now = I_GetMillies();
+
+		if (now - capture_time < 0)
+			return;
+
+		capture_time += 1000 / capture_rate;
+
+		// fell too far behind: don't try to catch up
+		if (now - capture_time > 1000)
+			capture_time = now;
 	}
 
-	delete img;
+	M_ScreenShot(false);
 
-	fclose(fp);
+	capture_count++;
+
+	if (capture_left > 0)
+	{
+		capture_left--;
+
+		if (capture_left == 0)
+			I_Printf("Captured %d frames\n", capture_count);
+	}
 }
 
 
@@ -777,6 +975,38 @@ byte* M_GetFileData(const char *filename, int *length)
 }
 
 
+//
+// Writes a cache file in one go.  The data goes to a temporary name
+// first, so a half-written file is never picked up by the loaders.
+// Prints nothing, hence it is safe to call from a worker thread.
+//
+// Returns false on failure.
+//
+bool M_SaveCacheFile(const std::string& filename, const byte *data, int length)
+{
+	std::string temp_name = filename + ".tmp";
+
+	epi::file_c *fp = epi::FS_Open(temp_name.c_str(), epi::file_c::ACCESS_WRITE | epi::file_c::ACCESS_BINARY);
+
+	if (! fp)
+		return false;
+
+	bool ok = (fp->Write(data, length) == (unsigned int)length);
+
+	delete fp;
+
+	if (! ok)
+	{
+		epi::FS_Delete(temp_name.c_str());
+		return false;
+	}
+
+	epi::FS_Delete(filename.c_str());
+
+	return epi::FS_Rename(temp_name.c_str(), filename.c_str());
+}
+
+
 void M_WarnError(const char *error,...)
 {
 	// Either displays a warning or produces a fatal error, depending
@@ -803,6 +1033,40 @@ void M_WarnError(const char *error,...)
 
 
 extern FILE *debugfile; // FIXME
+extern FILE *logfile; // FIXME: make file_c and unify with debugfile
+extern FILE *openglfile;
+extern FILE *shadercompilefile;
+
+// which log files get written to, one bit per channel (log_channel_e)
+DEF_CVAR(log_channels, int, "c", LOG_MASK_ALL);
+
+static void LogVPrintf(int channel, const char *message, va_list argptr)
+{
+	char message_buf[4096];
+
+	va_list argcopy;
+	va_copy(argcopy, argptr);
+
+	int len = vsnprintf(message_buf, sizeof(message_buf), message, argptr);
+
+	if (len >= (int)sizeof(message_buf))
+	{
+		// rare, so just use the heap
+		char *big_buf = new char[len + 1];
+
+		vsnprintf(big_buf, len + 1, message, argcopy);
+
+		I_LogWrite(channel, big_buf, len);
+
+		delete[] big_buf;
+	}
+	else if (len > 0)
+	{
+		I_LogWrite(channel, message_buf, len);
+	}
+
+	va_end(argcopy);
+}
 
 void I_Debugf(const char *message,...)
 {
@@ -811,100 +1075,50 @@ void I_Debugf(const char *message,...)
 	// -ACB- 1999/09/22: From #define to Procedure
 	// -AJA- 2001/02/07: Moved here from platform codes.
 	//
-	if (!debugfile)
+	if (!debugfile || !(log_channels & (1 << LOG_Debug)))
 		return;
 
-	char message_buf[4096];
-
-	message_buf[4095] = 0;
-
-	// Print the message into a text string
 	va_list argptr;
 
 	va_start(argptr, message);
-	vsprintf(message_buf, message, argptr);
+	LogVPrintf(LOG_Debug, message, argptr);
 	va_end(argptr);
-
-	// I hope nobody is printing strings longer than 4096 chars...
-	SYS_ASSERT(message_buf[4095] == 0);
-
-	fprintf(debugfile, "%s", message_buf);
-	fflush(debugfile);
 }
 
-extern FILE *logfile; // FIXME: make file_c and unify with debugfile
-
 void I_Logf(const char *message,...)
 {
-	if (!logfile)
+	if (!logfile || !(log_channels & (1 << LOG_Main)))
 		return;
 
-	char message_buf[4096];
-
-	message_buf[4095] = 0;
-
-	// Print the message into a text string
 	va_list argptr;
 
 	va_start(argptr, message);
-	vsprintf(message_buf, message, argptr);
+	LogVPrintf(LOG_Main, message, argptr);
 	va_end(argptr);
-
-	// I hope nobody is printing strings longer than 4096 chars...
-	SYS_ASSERT(message_buf[4095] == 0);
-
-	fprintf(logfile, "%s", message_buf);
-	fflush(logfile);
 }
 
-extern FILE *openglfile;
-
 void I_GLf(const char *message, ...)
 {
-	if (!openglfile)
+	if (!openglfile || !(log_channels & (1 << LOG_OpenGL)))
 		return;
 
-	char message_buf[8096];
-
-	message_buf[8095] = 0;
-
-	// Print the message into a text string
 	va_list argptr;
 
 	va_start(argptr, message);
-	vsprintf(message_buf, message, argptr);
+	LogVPrintf(LOG_OpenGL, message, argptr);
 	va_end(argptr);
-
-	// I hope nobody is printing strings longer than 4096 chars...
-	SYS_ASSERT(message_buf[8095] == 0);
-
-	fprintf(openglfile, "%s", message_buf);
-	fflush(openglfile);
 }
 
-extern FILE *shadercompilefile;
-
 void I_PrintGLSL(const char *message, ...)
 {
-	if (!shadercompilefile)
+	if (!shadercompilefile || !(log_channels & (1 << LOG_GLSL)))
 		return;
 
-	char message_buf[8096];
-
-	message_buf[8095] = 0;
-
-	// Print the message into a text string
 	va_list argptr;
 
 	va_start(argptr, message);
-	vsprintf(message_buf, message, argptr);
+	LogVPrintf(LOG_GLSL, message, argptr);
 	va_end(argptr);
-
-	// I hope nobody is printing strings longer than 4096 chars...
-	SYS_ASSERT(message_buf[8095] == 0);
-
-	fprintf(shadercompilefile, "%s", message_buf);
-	fflush(shadercompilefile);
 }
 
 
@@ -63,9 +63,14 @@ void M_SaveDefaults(void);
 void M_InitMiscConVars(void);
 void M_DisplayDisk(void);
 void M_ScreenShot(bool show_msg);
+void M_UpdateScreenShots(bool wait);
+void M_StartCapture(int count, int rate);
+void M_StopCapture(void);
+void M_CaptureFrame(void);
 void M_MakeSaveScreenShot(void);
 
 byte *M_GetFileData(const char *filename, int *length);
+bool M_SaveCacheFile(const std::string& filename, const byte *data, int length);
 std::string M_ComposeFileName(const char *dir, const char *file);
 epi::file_c *M_OpenComposedEPIFile(const char *dir, const char *file);
 void M_WarnError(const char *error,...) GCCATTR((format(printf, 1, 2)));
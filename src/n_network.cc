@@ -18,6 +18,7 @@
 
 #include "system/i_defs.h"
 #include "system/i_net.h"
+#include "system/i_pacer.h"
 
 #include <limits.h>
 #include <stdlib.h>
@@ -96,9 +97,19 @@ static void GetPackets(bool do_delay)
 {
 	if (! netgame)
 	{
-		// -AJA- This can make everything a bit "jerky" :-(
+		// wait for the next tic to come due (rather than a fixed
+		// 10 millis, which made everything a bit "jerky").
 		if (do_delay && ! m_busywait)
-			I_Sleep(10 /* millis */);
+		{
+			// done in 64 bits from one reading of the clock, since
+			// (tic * 1000) overflows an int after about 17 hours.
+			u64_t now_ms  = (u32_t) I_GetMillies();
+			u64_t next_ms = ((now_ms * TICRATE / 1000 + 1) * 1000 + TICRATE - 1) / TICRATE;
+
+			int wait_ms = (int) MIN(next_ms - now_ms, (u64_t) 10);
+
+			I_WaitUntil(I_PreciseMicroSeconds() + wait_ms * 1000);
+		}
 		return;
 	}
 
@@ -157,7 +157,8 @@ bool P_ActLookForTargets(mobj_t *we)
 	if (we->side == 0)
 		return P_LookForPlayers(we, we->info->sight_angle);
 
-	for (them = mobjlisthead; them != NULL; them = them->next)
+	for (them = P_RegistryHead(MREG_Monsters); them != NULL;
+		 them = them->reg_next[MREG_Monsters])
 	{
 		if (them == we)
 			continue;
@@ -412,6 +413,8 @@ void P_BringCorpseToLife(mobj_t * corpse)
 	corpse->vis_target = PERCENT_2_FLOAT(info->translucency);
 	corpse->tag = corpse->spawnpoint.tag;
 
+	P_RefileMobj(corpse);
+
 	if (corpse->player)
 	{
 		corpse->player->playerstate = PST_LIVE;
@@ -2161,11 +2164,8 @@ static void ObjectSpawning(mobj_t * parent, angle_t angle)
 
 	if (attack->spawn_limit > 0)
 	{
-		int count = 0;
-		for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
-			if (mo->info == shoottype)
-				if (++count >= attack->spawn_limit)
-					return;
+		if (P_TypeRegistryCount(shoottype) >= attack->spawn_limit)
+			return;
 	}
 
 	// -AJA- 1999/09/10: apply the angle offset of the attack.
@@ -3355,14 +3355,12 @@ void P_ActKeenDie(mobj_t * mo)
 	P_ActMakeIntoCorpse(mo);
 
 	// see if all other Keens are dead
-	for (mobj_t *cur = mobjlisthead; cur != NULL; cur = cur->next)
+	for (mobj_t *cur = P_TypeRegistryHead(mo->info); cur != NULL;
+		 cur = cur->reg_next[MREG_Type])
 	{
 		if (cur == mo)
 			continue;
 
-		if (cur->info != mo->info)
-			continue;
-
 		if (cur->health > 0)
 			return; // other Keen not dead
 	}
@@ -3557,6 +3555,8 @@ void P_ActBecome(struct mobj_s *mo)
 	}
 	P_SetThingPosition(mo);
 
+	P_RefileMobj(mo);
+
 	statenum_t state = P_MobjFindLabel(mo, become->start.label.c_str());
 	if (state == S_NULL)
 		I_Error("BECOME action: frame '%s' in [%s] not found!\n",
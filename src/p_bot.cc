@@ -372,7 +372,8 @@ static bool BOT_LookForEnemies(bot_t *bot)
 	mobj_t *we = bot->pl->mo;
 	mobj_t *them;
 
-	for (them = mobjlisthead; them; them = them->next)
+	for (them = P_RegistryHead(MREG_Shootable); them;
+		 them = them->reg_next[MREG_Shootable])
 	{
 		if (! (them->flags & MF_SHOOTABLE))
 			continue;
@@ -213,9 +213,9 @@ void Cheat_KillAll()
 	mobj_t *mo;
 	mobj_t *next;
 
-	for (mo = mobjlisthead; mo; mo = next)
+	for (mo = P_RegistryHead(MREG_Alive); mo; mo = next)
 	{
-		next = mo->next;
+		next = mo->reg_next[MREG_Alive];
 
 		if ((mo->extendedflags & EF_MONSTER) && (mo->health > 0))
 		{
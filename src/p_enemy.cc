@@ -498,11 +498,7 @@ void P_LookForShootSpots(const mobjtype_c *spot_type)
 	brain_spots.number = 0;
 
 	// count them
-	for (cur=mobjlisthead; cur != NULL; cur=cur->next)
-	{
-		if (cur->info == spot_type)
-			brain_spots.number++;
-	}
+	brain_spots.number = P_TypeRegistryCount(spot_type);
 
 	if (brain_spots.number == 0)
 	{
@@ -514,10 +510,10 @@ void P_LookForShootSpots(const mobjtype_c *spot_type)
 	// create the spots
 	brain_spots.targets = new mobj_t* [brain_spots.number];
 
-	for (cur=mobjlisthead, i=0; cur != NULL; cur=cur->next)
+	for (cur=P_TypeRegistryHead(spot_type), i=0; cur != NULL;
+		 cur=cur->reg_next[MREG_Type])
 	{
-		if (cur->info == spot_type)
-			brain_spots.targets[i++] = cur;
+		brain_spots.targets[i++] = cur;
 	}
 
 	SYS_ASSERT(i == brain_spots.number);
@@ -822,6 +822,8 @@ void P_KillMobj(mobj_t * source, mobj_t * target, const damage_c *damtype,
 	target->flags |= MF_CORPSE | MF_DROPOFF;
 	target->height /= 4;
 
+	P_RefileMobj(target);
+
 	RAD_MonsterIsDead(target);
 
 	if (source && source->player)
@@ -136,6 +136,15 @@ extern iteminque_t *itemquehead;
 // -ACB- 1998/08/27 Start Pointer in the mobj list.
 extern mobj_t *mobjlisthead;
 
+// mobj registries (iterate with mo->reg_next[reg])
+mobj_t *P_RegistryHead(mobj_registry_e reg);
+mobj_t *P_TypeRegistryHead(const mobjtype_c *info);
+int P_RegistryCount(mobj_registry_e reg);
+int P_TypeRegistryCount(const mobjtype_c *info);
+void P_RefileMobj(mobj_t *mo);
+void P_RebuildMobjRegistries(void);
+void P_ShowMobjRegistries(void);
+
 void P_RemoveMobj(mobj_t * th);
 statenum_t P_MobjFindLabel(mobj_t * mobj, const char *label);
 bool P_SetMobjState(mobj_t * mobj, statenum_t state);
@@ -81,6 +81,7 @@
 #include "../epi/arrays.h"
 
 #include <list>
+#include <unordered_map>
 
 #define LADDER_FRICTION  0.5f
 
@@ -404,6 +405,8 @@ static void ResurrectRespawn(mobj_t * mobj)
 
 	mobj->reactiontime = RESPAWN_DELAY;
 	mobj->UpdateLastTicRender();
+
+	P_RefileMobj(mobj);
 	return;
 }
 
@@ -1777,6 +1780,254 @@ void P_RemoveQueuedMobjs(bool force_all)
 		remove_queue.remove(NULL);
 }
 
+//----------------------------------------------------------------------------
+//  MOBJ REGISTRIES
+//----------------------------------------------------------------------------
+//
+// Subsets of the mobj list for the code which used to walk every mobj
+// looking for monsters, shootable things or a particular type.  Each
+// registry is an intrusive list in the same relative order as the main
+// list, so iterating a registry visits things in exactly the order a
+// full mobjlisthead walk would (which keeps demos in sync).
+//
+
+typedef struct
+{
+	mobj_t *head;
+	int count;
+}
+mobj_registry_t;
+
+static int mobj_total;
+
+static mobj_registry_t mobj_registries[NUM_MOBJ_REGISTRIES];
+
+static std::unordered_map<const mobjtype_c *, mobj_registry_t> mobj_type_registries;
+
+
+static bool RegistryWants(const mobj_t *mo, int reg)
+{
+	switch (reg)
+	{
+		case MREG_Monsters:
+			return (mo->extendedflags & EF_MONSTER) || mo->player;
+
+		case MREG_Alive:
+			return (mo->extendedflags & EF_MONSTER) && mo->health > 0;
+
+		case MREG_Shootable:
+			return (mo->flags & MF_SHOOTABLE) != 0;
+
+		case MREG_Type:
+			return mo->info != NULL;
+
+		default:
+			return false;
+	}
+}
+
+static inline mobj_registry_t *RegistryFor(const mobj_t *mo, int reg)
+{
+	if (reg == MREG_Type)
+		return &mobj_type_registries[mo->reg_type];
+
+	return &mobj_registries[reg];
+}
+
+static inline bool InSameRegistry(const mobj_t *A, const mobj_t *B, int reg)
+{
+	if (! (A->reg_bits & (1 << reg)))
+		return false;
+
+	return (reg != MREG_Type) || (A->reg_type == B->reg_type);
+}
+
+//
+// Links the mobj into a registry, just after the nearest preceding
+// (in mobjlisthead order) member.  When at_head is true, it goes
+// straight to the front, which is where new mobjs belong anyway.
+//
+static void RegistryLink(mobj_t *mo, int reg, bool at_head)
+{
+	if (reg == MREG_Type)
+		mo->reg_type = mo->info;
+
+	mobj_registry_t *R = RegistryFor(mo, reg);
+
+	mobj_t *after = NULL;
+
+	if (! at_head)
+	{
+		for (after = mo->prev; after; after = after->prev)
+			if (InSameRegistry(after, mo, reg))
+				break;
+	}
+
+	mo->reg_prev[reg] = after;
+	mo->reg_next[reg] = after ? after->reg_next[reg] : R->head;
+
+	if (mo->reg_next[reg])
+		mo->reg_next[reg]->reg_prev[reg] = mo;
+
+	if (after)
+		after->reg_next[reg] = mo;
+	else
+		R->head = mo;
+
+	mo->reg_bits |= (1 << reg);
+	R->count++;
+}
+
+static void RegistryUnlink(mobj_t *mo, int reg)
+{
+	if (! (mo->reg_bits & (1 << reg)))
+		return;
+
+	mobj_registry_t *R = RegistryFor(mo, reg);
+
+	if (mo->reg_prev[reg])
+		mo->reg_prev[reg]->reg_next[reg] = mo->reg_next[reg];
+	else
+	{
+		SYS_ASSERT(R->head == mo);
+		R->head = mo->reg_next[reg];
+	}
+
+	if (mo->reg_next[reg])
+		mo->reg_next[reg]->reg_prev[reg] = mo->reg_prev[reg];
+
+	mo->reg_next[reg] = mo->reg_prev[reg] = NULL;
+	mo->reg_bits &= ~(1 << reg);
+
+	if (reg == MREG_Type)
+		mo->reg_type = NULL;
+
+	R->count--;
+}
+
+//
+// P_RefileMobj
+//
+// Updates which registries the mobj is in.  Must be called whenever
+// something the registries depend on changes: info, player, flags
+// (MF_SHOOTABLE), extendedflags (EF_MONSTER) or health crossing zero.
+//
+void P_RefileMobj(mobj_t *mo)
+{
+	if (mo->isRemoved())
+		return;
+
+	for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+	{
+		bool have = (mo->reg_bits & (1 << reg)) != 0;
+		bool want = RegistryWants(mo, reg);
+
+		if (have && want && reg == MREG_Type && mo->reg_type != mo->info)
+		{
+			RegistryUnlink(mo, reg);
+			have = false;
+		}
+
+		if (have && ! want)
+			RegistryUnlink(mo, reg);
+		else if (want && ! have)
+			RegistryLink(mo, reg, false);
+	}
+}
+
+//
+// P_RebuildMobjRegistries
+//
+// Recreates all registries from mobjlisthead (e.g. after loading a
+// savegame, which builds the mobj list directly).
+//
+void P_RebuildMobjRegistries(void)
+{
+	mobj_t *mo;
+	mobj_t *tail = NULL;
+
+	for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+	{
+		mobj_registries[reg].head  = NULL;
+		mobj_registries[reg].count = 0;
+	}
+
+	mobj_type_registries.clear();
+	mobj_total = 0;
+
+	for (mo = mobjlisthead; mo; mo = mo->next)
+	{
+		for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+			mo->reg_next[reg] = mo->reg_prev[reg] = NULL;
+
+		mo->reg_bits = 0;
+		mo->reg_type = NULL;
+
+		tail = mo;
+		mobj_total++;
+	}
+
+	// link from the back, so every entry can simply go to the front
+	for (mo = tail; mo; mo = mo->prev)
+	{
+		if (mo->isRemoved())
+			continue;
+
+		for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+			if (RegistryWants(mo, reg))
+				RegistryLink(mo, reg, true);
+	}
+}
+
+mobj_t *P_RegistryHead(mobj_registry_e reg)
+{
+	SYS_ASSERT(0 <= reg && reg < MREG_Type);
+
+	return mobj_registries[reg].head;
+}
+
+mobj_t *P_TypeRegistryHead(const mobjtype_c *info)
+{
+	std::unordered_map<const mobjtype_c *, mobj_registry_t>::iterator it =
+		mobj_type_registries.find(info);
+
+	return (it == mobj_type_registries.end()) ? NULL : it->second.head;
+}
+
+int P_RegistryCount(mobj_registry_e reg)
+{
+	SYS_ASSERT(0 <= reg && reg < MREG_Type);
+
+	return mobj_registries[reg].count;
+}
+
+int P_TypeRegistryCount(const mobjtype_c *info)
+{
+	std::unordered_map<const mobjtype_c *, mobj_registry_t>::iterator it =
+		mobj_type_registries.find(info);
+
+	return (it == mobj_type_registries.end()) ? 0 : it->second.count;
+}
+
+void P_ShowMobjRegistries(void)
+{
+	int types = 0;
+
+	std::unordered_map<const mobjtype_c *, mobj_registry_t>::iterator it;
+
+	for (it = mobj_type_registries.begin(); it != mobj_type_registries.end(); it++)
+		if (it->second.count > 0)
+			types++;
+
+	I_Printf("Mobj registries:\n");
+	I_Printf("  total:     %d\n", mobj_total);
+	I_Printf("  monsters:  %d\n", mobj_registries[MREG_Monsters].count);
+	I_Printf("  alive:     %d\n", mobj_registries[MREG_Alive].count);
+	I_Printf("  shootable: %d\n", mobj_registries[MREG_Shootable].count);
+	I_Printf("  types:     %d\n", types);
+}
+
+
 static void AddMobjToList(mobj_t *mo)
 {
 	mo->prev = NULL;
@@ -1789,6 +2040,11 @@ static void AddMobjToList(mobj_t *mo)
 	}
 
 	mobjlisthead = mo;
+	mobj_total++;
+
+	for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+		if (RegistryWants(mo, reg))
+			RegistryLink(mo, reg, true);
 
 #if (DEBUG_MOBJ > 0)
 	L_WriteDebug("tics=%05d  ADD %p [%s]\n", leveltime, mo,
@@ -1798,6 +2054,11 @@ static void AddMobjToList(mobj_t *mo)
 
 static void RemoveMobjFromList(mobj_t *mo)
 {
+	for (int reg = 0; reg < NUM_MOBJ_REGISTRIES; reg++)
+		RegistryUnlink(mo, reg);
+
+	mobj_total--;
+
 	if (mo->prev != NULL)
 	{
 		SYS_ASSERT(mo->prev->next == mo);
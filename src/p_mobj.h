@@ -181,6 +181,21 @@ struct last_tic_render_s : public position_c
 	short model_animfile;
 };
 
+// Mobj registries: subsets of the mobj list, kept in the same relative
+// order as mobjlisthead.  Membership is decided by P_RefileMobj(), so
+// users must still check the exact condition they are interested in
+// (e.g. health > 0) on each entry.
+typedef enum
+{
+	MREG_Monsters = 0,  // EF_MONSTER things and players
+	MREG_Alive,         // EF_MONSTER things with health > 0
+	MREG_Shootable,     // MF_SHOOTABLE things
+	MREG_Type,          // one list per mobjtype_c (see reg_type)
+
+	NUM_MOBJ_REGISTRIES
+}
+mobj_registry_e;
+
 typedef struct dlight_state_s
 {
 	float r;  // radius
@@ -350,6 +365,14 @@ struct mobj_s : public position_c
 	// linked list (mobjlisthead)
 	mobj_t *next, *prev;
 
+	// links in the mobj registries (see mobj_registry_e).  reg_bits
+	// tells which registries we are in, reg_type is the type list.
+	mobj_t *reg_next[NUM_MOBJ_REGISTRIES];
+	mobj_t *reg_prev[NUM_MOBJ_REGISTRIES];
+
+	int reg_bits;
+	const mobjtype_c *reg_type;
+
 	// Interaction info, by BLOCKMAP.
 	// Links in blocks (if needed).
 	mobj_t *bnext, *bprev;
@@ -52,14 +52,18 @@
 #include "am_map.h"
 #include "r_gldefs.h"
 #include "r_sky.h"
+#include "s_cache.h"
 #include "s_sound.h"
 #include "s_music.h"
 #include "sv_main.h"
 #include "r_image.h"
 #include "w_texture.h"
 #include "w_wad.h"
+#include "w_prefetch.h"
 #include "z_zone.h"
 
+#include "system/i_thread.h"
+
 // debugging aide:
 #define FORCE_LOCATION  0
 #define FORCE_LOC_X     12766
@@ -149,6 +153,9 @@ static int *temp_line_sides;
 
 DEF_CVAR(m_goobers, int, "", 0);
 
+// show how long each stage of P_SetupLevel took
+DEF_CVAR(debug_setup, int, "c", 0);
+
 typedef struct {
 	uint8_t *buffer;
 	uint8_t line[512];
@@ -3555,34 +3562,58 @@ void GroupLines(void)
 		}
 	}
 
-	// build line tables for each sector
+	// build line tables for each sector.  This is one pass over the
+	// lines (in order), rather than one pass per sector.
 	linebuffer = new line_t* [total];
 
 	line_p = linebuffer;
 	sector = sectors;
 
+	int *fill = new int[numsectors];
+
 	for (i = 0; i < numsectors; i++, sector++)
 	{
-		M_ClearBox(bbox);
 		sector->lines = line_p;
-		li = lines;
-		for (j = 0; j < numlines; j++, li++)
+		line_p += sector->linecount;
+
+		fill[i] = 0;
+	}
+
+	li = lines;
+	for (j = 0; j < numlines; j++, li++)
+	{
+		sector = li->frontsector;
+		sector->lines[fill[sector - sectors]++] = li;
+
+		sector = li->backsector;
+		if (sector && sector != li->frontsector)
+			sector->lines[fill[sector - sectors]++] = li;
+	}
+
+	sector = sectors;
+
+	for (i = 0; i < numsectors; i++, sector++)
+	{
+		if (fill[i] != sector->linecount)
+			I_Error("GroupLines: miscounted");
+
+		M_ClearBox(bbox);
+
+		for (j = 0; j < sector->linecount; j++)
 		{
-			if (li->frontsector == sector || li->backsector == sector)
-			{
-				*line_p++ = li;
-				M_AddToBox(bbox, li->v1->x, li->v1->y);
-				M_AddToBox(bbox, li->v2->x, li->v2->y);
-			}
+			li = sector->lines[j];
+
+			M_AddToBox(bbox, li->v1->x, li->v1->y);
+			M_AddToBox(bbox, li->v2->x, li->v2->y);
 		}
-		if (line_p - sector->lines != sector->linecount)
-			I_Error("GroupLines: miscounted");
 
 		// set the degenmobj_t to the middle of the bounding box
 		sector->sfx_origin.x = (bbox[BOXRIGHT] + bbox[BOXLEFT]) / 2;
 		sector->sfx_origin.y = (bbox[BOXTOP] + bbox[BOXBOTTOM]) / 2;
 		sector->sfx_origin.z = (sector->f_h + sector->c_h) / 2;
 	}
+
+	delete[] fill;
 }
 
 
@@ -4065,6 +4096,169 @@ void P_ShutdownLevel(void)
 }
 
 
+typedef struct
+{
+	int lumpnum;
+	int gl_lumpnum;
+}
+setup_lumps_t;
+
+//
+// Stages of P_SetupLevel
+//
+static void Stage_MapData(void *data)
+{
+	setup_lumps_t *info = (setup_lumps_t *) data;
+
+	int lumpnum = info->lumpnum;
+
+	if (!udmf_level)
+	{
+		LoadVertexes(lumpnum + ML_VERTEXES);
+		LoadSectors(lumpnum + ML_SECTORS);
+
+		if (hexen_level)
+			LoadHexenLineDefs(lumpnum + ML_LINEDEFS);
+		else
+			LoadLineDefs(lumpnum + ML_LINEDEFS);
+
+		LoadSideDefs(lumpnum + ML_SIDEDEFS);
+	}
+	else
+	{
+		LoadUDMFVertexes(&udmf_psr);
+		LoadUDMFSectors(&udmf_psr);
+		LoadUDMFLineDefs(&udmf_psr);
+		LoadUDMFSideDefs(&udmf_psr);
+		SetupUDMFSpecials();
+	}
+
+	SetupExtrafloors();
+	SetupSlidingDoors();
+	SetupVertGaps();
+
+	delete[] temp_line_sides;
+}
+
+static void Stage_Nodes(void *data)
+{
+	setup_lumps_t *info = (setup_lumps_t *) data;
+
+	int gl_lumpnum = info->gl_lumpnum;
+
+	if (!udmf_level)
+	{
+		I_Debugf("P_SetupLevel: Load GL info\n");
+		SYS_ASSERT(gl_lumpnum >= 0);
+
+		LoadGLVertexes(gl_lumpnum + ML_GL_VERT);
+		LoadGLSegs(gl_lumpnum + ML_GL_SEGS);
+		LoadSubsectors(gl_lumpnum + ML_GL_SSECT, "GL_SSECT");
+		LoadNodes(gl_lumpnum + ML_GL_NODES, "GL_NODES");
+	}
+	else
+	{
+		I_Debugf("P_SetupLevel: Load UDMF GL info\n");
+		LoadZNodes(udmf_lumpnum);
+	}
+
+	if (wolf3d_mode)
+	{
+		WF_BuildBSP();
+	}
+
+	// REJECT is ignored
+}
+
+static void Stage_BlockMap(void *data)
+{
+	DoBlockMap(); // BLOCKMAP lump ignored
+}
+
+static void Stage_GroupLines(void *data)
+{
+	GroupLines();
+}
+
+static void Stage_DeepWater(void *data)
+{
+	DetectDeepWaterTrick();
+}
+
+static void Stage_SkyHeights(void *data)
+{
+	R_ComputeSkyHeights();
+}
+
+static void Stage_Gaps(void *data)
+{
+	// compute sector and line gaps
+	for (int j=0; j < numsectors; j++)
+		P_RecomputeGapsAroundSector(sectors + j);
+}
+
+static void Stage_Things(void *data)
+{
+	setup_lumps_t *info = (setup_lumps_t *) data;
+
+	int lumpnum = info->lumpnum;
+
+	G_ClearBodyQueue();
+
+	// set up world state
+	// (must be before loading things to create Extrafloors)
+	P_SpawnSpecials1();
+
+	// -AJA- 1999/10/21: Clear out player starts (ready to load).
+	G_ClearPlayerStarts();
+
+	if (!udmf_level)
+	{
+		if (hexen_level)
+			LoadHexenThings(lumpnum + ML_THINGS);
+		else
+			LoadThings(lumpnum + ML_THINGS);
+	}
+	else
+	{
+		LoadUDMFThings(&udmf_psr);
+
+		W_DoneWithLump(udmf_lump);
+	}
+
+	// adjust PO vertexes
+	P_PostProcessPolyObjs();
+
+	// OK, CRC values have now been computed
+#ifdef DEVELOPERS
+	L_WriteDebug("MAP CRCS: S=%08x L=%08x T=%08x\n",
+		mapsector_CRC.crc, mapline_CRC.crc, mapthing_CRC.crc);
+#endif
+}
+
+static void Stage_VertexSeclists(void *data)
+{
+	// only used by the renderer, so can run alongside the specials
+	CreateVertexSeclists();
+}
+
+static void Stage_Specials(void *data)
+{
+	P_SpawnSpecials2(currmap->autotag);
+
+	AM_InitLevel();
+}
+
+static void Stage_Precache(void *data)
+{
+	RGL_UpdateSkyBoxTextures();
+
+	// preload graphics
+	if (precache)
+		W_PrecacheLevel();
+}
+
+
 void P_SetupLevel(void)
 {
 
@@ -4073,7 +4267,6 @@ void P_SetupLevel(void)
 	//
 	// -ACB- 1998/08/09 Use currmap to ref lump and par time
 
-	int j;
 	int lumpnum;
 	int gl_lumpnum;
 	char gl_lumpname[16];
@@ -4081,6 +4274,8 @@ void P_SetupLevel(void)
 	if (level_active)
 		P_ShutdownLevel();
 
+	W_FinishPrefetch();
+
 	// -ACB- 1998/08/27 NULL the head pointers for the linked lists....
 	itemquehead = NULL;
 	mobjlisthead = NULL;
@@ -4221,126 +4416,68 @@ void P_SetupLevel(void)
 			doom_level = true;
 	}
 
-	// note: most of this ordering is important
-	// 23-6-98 KM, eg, Sectors must be loaded before sidedefs,
-	// Vertexes must be loaded before LineDefs,
-	// LineDefs + Vertexes must be loaded before BlockMap,
-	// Sectors must be loaded before Segs
-
 	numsides = 0;
 	numextrafloors = 0;
 	numvertgaps = 0;
 
-	if (!udmf_level)
-	{
-		LoadVertexes(lumpnum + ML_VERTEXES);
-		LoadSectors(lumpnum + ML_SECTORS);
-
-		if (hexen_level)
-			LoadHexenLineDefs(lumpnum + ML_LINEDEFS);
-		else
-			LoadLineDefs(lumpnum + ML_LINEDEFS);
-
-		LoadSideDefs(lumpnum + ML_SIDEDEFS);
-	}
-	else
-	{
-		LoadUDMFVertexes(&udmf_psr);
-		LoadUDMFSectors(&udmf_psr);
-		LoadUDMFLineDefs(&udmf_psr);
-		LoadUDMFSideDefs(&udmf_psr);
-		SetupUDMFSpecials();
-	}
-
-	SetupExtrafloors();
-	SetupSlidingDoors();
-	SetupVertGaps();
-
-	delete[] temp_line_sides;
+	setup_lumps_t info;
 
-	if (!udmf_level)
-	{
-		I_Debugf("P_SetupLevel: Load GL info\n");
-		SYS_ASSERT(gl_lumpnum >= 0);
-
-		LoadGLVertexes(gl_lumpnum + ML_GL_VERT);
-		LoadGLSegs(gl_lumpnum + ML_GL_SEGS);
-		LoadSubsectors(gl_lumpnum + ML_GL_SSECT, "GL_SSECT");
-		LoadNodes(gl_lumpnum + ML_GL_NODES, "GL_NODES");
-	}
-	else
-	{
-		I_Debugf("P_SetupLevel: Load UDMF GL info\n");
-		LoadZNodes(udmf_lumpnum);
-	}
+	info.lumpnum = lumpnum;
+	info.gl_lumpnum = gl_lumpnum;
 
+	// note: most of this ordering is important
+	// 23-6-98 KM, eg, Sectors must be loaded before sidedefs,
+	// Vertexes must be loaded before LineDefs,
+	// LineDefs + Vertexes must be loaded before BlockMap,
+	// Sectors must be loaded before Segs
+	//
+	// Stages which only need the map data and write their own things
+	// run on the worker threads, the rest stay on this thread.
+
+	task_graph_c graph;
+
+	int t_map    = graph.Add("map data",      Stage_MapData,   &info, true);
+	int t_nodes  = graph.Add("nodes",         Stage_Nodes,     &info, true);
+	int t_block  = graph.Add("blockmap",      Stage_BlockMap,  NULL);
+	int t_sky    = graph.Add("sky heights",   Stage_SkyHeights, NULL);
+	int t_group  = graph.Add("group lines",   Stage_GroupLines, NULL);
+	int t_deep   = graph.Add("deep water",    Stage_DeepWater, NULL);
+	int t_gaps   = graph.Add("gaps",          Stage_Gaps,      NULL);
+	int t_things = graph.Add("things",        Stage_Things,    &info, true);
+	int t_vsec   = graph.Add("vertex seclists", Stage_VertexSeclists, NULL);
+	int t_spec   = graph.Add("specials",      Stage_Specials,  NULL, true);
+	int t_cache  = graph.Add("precache",      Stage_Precache,  NULL, true);
+
+	graph.Depend(t_nodes,  t_map);
+	graph.Depend(t_block,  t_map);
+	graph.Depend(t_sky,    t_map);
+	graph.Depend(t_group,  t_nodes);
+	graph.Depend(t_deep,   t_group);
+	graph.Depend(t_gaps,   t_group);
+	graph.Depend(t_things, t_block);
+	graph.Depend(t_things, t_sky);
+	graph.Depend(t_things, t_deep);
+	graph.Depend(t_things, t_gaps);
+	graph.Depend(t_vsec,   t_things);
+	graph.Depend(t_spec,   t_things);
+	graph.Depend(t_cache,  t_spec);
+
+	// the Wolfenstein BSP builder may add to the map data
 	if (wolf3d_mode)
 	{
-		WF_BuildBSP();
+		graph.Depend(t_block, t_nodes);
+		graph.Depend(t_sky,   t_nodes);
 	}
 
-	// REJECT is ignored
-
-	DoBlockMap(); // BLOCKMAP lump ignored
-
-	GroupLines();
-
-	DetectDeepWaterTrick();
-
-	R_ComputeSkyHeights();
-
-	// compute sector and line gaps
-	for (j=0; j < numsectors; j++)
-		P_RecomputeGapsAroundSector(sectors + j);
-
-	G_ClearBodyQueue();
-
-	// set up world state
-	// (must be before loading things to create Extrafloors)
-	P_SpawnSpecials1();
-
-	// -AJA- 1999/10/21: Clear out player starts (ready to load).
-	G_ClearPlayerStarts();
+	graph.Run();
 
-	if (!udmf_level)
-	{
-		if (hexen_level)
-			LoadHexenThings(lumpnum + ML_THINGS);
-		else
-			LoadThings(lumpnum + ML_THINGS);
-	}
-	else
-	{
-		LoadUDMFThings(&udmf_psr);
-
-		W_DoneWithLump(udmf_lump);
-	}
-
-	// adjust PO vertexes
-	P_PostProcessPolyObjs();
-
-	// OK, CRC values have now been computed
-#ifdef DEVELOPERS
-	L_WriteDebug("MAP CRCS: S=%08x L=%08x T=%08x\n",
-		mapsector_CRC.crc, mapline_CRC.crc, mapthing_CRC.crc);
-#endif
-
-	CreateVertexSeclists();
-
-	P_SpawnSpecials2(currmap->autotag);
-
-	AM_InitLevel();
-
-	RGL_UpdateSkyBoxTextures();
-
-	// preload graphics
-	if (precache)
-		W_PrecacheLevel();
+	graph.ShowTimes("P_SetupLevel", debug_setup > 0);
 
 	// setup categories based on game mode (SP/COOP/DM)
 	S_ChangeChannelNum();
 
-	// FIXME: cache sounds (esp. for player)
+	// start decoding the sounds of the level's things
+	S_PrecacheLevel();
 
 	S_ChangeMusic(currmap->music, true); // start level music
 
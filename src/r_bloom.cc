@@ -64,6 +64,80 @@ namespace
 	int gl_bloom_kernel_size = 7; // CUSTOM_CVAR(Int, gl_bloom_kernel_size, 7, CVAR_ARCHIVE)
 }
 
+extern int debug_bloom;
+
+bloom_stats_t bloom_stats;
+
+// Timestamps taken at the start, then after the exposure, extract,
+// blur and combine parts.  Results are read a few frames later so
+// that the GPU never has to be waited for.
+#define BLOOM_STAMPS  5
+#define BLOOM_FRAMES  3
+
+static GLuint bloom_queries[BLOOM_FRAMES][BLOOM_STAMPS];
+static bool   bloom_issued[BLOOM_FRAMES];
+static int    bloom_frame;
+static bool   bloom_timing;
+static u32_t  bloom_cpu_start;
+
+static void BloomReadTimes(void)
+{
+	int f = (bloom_frame + 1) % BLOOM_FRAMES;
+
+	if (!bloom_issued[f])
+		return;
+
+	GLint avail = 0;
+	glGetQueryObjectiv(bloom_queries[f][BLOOM_STAMPS - 1], GL_QUERY_RESULT_AVAILABLE, &avail);
+
+	if (!avail)
+		return;
+
+	GLuint64 t[BLOOM_STAMPS];
+
+	for (int i = 0; i < BLOOM_STAMPS; i++)
+		glGetQueryObjectui64v(bloom_queries[f][i], GL_QUERY_RESULT, &t[i]);
+
+	bloom_stats.exposure_ms = (t[1] - t[0]) / 1000000.0f;
+	bloom_stats.extract_ms  = (t[2] - t[1]) / 1000000.0f;
+	bloom_stats.blur_ms     = (t[3] - t[2]) / 1000000.0f;
+	bloom_stats.combine_ms  = (t[4] - t[3]) / 1000000.0f;
+
+	bloom_issued[f] = false;
+}
+
+static void BloomTimestamp(int stamp)
+{
+	if (stamp == 0)
+	{
+		bloom_timing = (debug_bloom > 0);
+
+		if (!bloom_timing)
+			return;
+
+		if (bloom_queries[0][0] == 0)
+			glGenQueries(BLOOM_FRAMES * BLOOM_STAMPS, &bloom_queries[0][0]);
+
+		BloomReadTimes();
+
+		bloom_cpu_start = I_ReadMicroSeconds();
+	}
+
+	if (!bloom_timing)
+		return;
+
+	glQueryCounter(bloom_queries[bloom_frame][stamp], GL_TIMESTAMP);
+
+	if (stamp == BLOOM_STAMPS - 1)
+	{
+		bloom_stats.cpu_us = I_ReadMicroSeconds() - bloom_cpu_start;
+
+		bloom_issued[bloom_frame] = true;
+		bloom_frame = (bloom_frame + 1) % BLOOM_FRAMES;
+		bloom_timing = false;
+	}
+}
+
 
 //-----------------------------------------------------------------------------
 //
@@ -83,7 +157,9 @@ void RGL_BloomScene()
 	savedState.SaveTextureBindings(2);
 
 	const float blurAmount = gl_bloom_amount;
-	int sampleCount = gl_bloom_kernel_size;
+
+	// must be odd, see ComputeBlurSamples()
+	int sampleCount = CLAMP(1, gl_bloom_kernel_size, 63) | 1;
 
 	auto renderbuffers = FGLRenderBuffers::Instance();
 	const auto &level0 = renderbuffers->BloomLevels[0];
@@ -106,6 +182,8 @@ void RGL_BloomScene()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+	BloomTimestamp(2);
+
 	// Blur and downscale:
 	for (int i = 0; i < FGLRenderBuffers::NumBloomLevels - 1; i++)
 	{
@@ -139,6 +217,8 @@ void RGL_BloomScene()
 	renderbuffers->Blur.BlurHorizontal(blurAmount, sampleCount, level0.VTexture, level0.HFramebuffer, level0.Width, level0.Height);
 	renderbuffers->Blur.BlurVertical(blurAmount, sampleCount, level0.HTexture, level0.VFramebuffer, level0.Width, level0.Height);
 
+	BloomTimestamp(3);
+
 	// Add bloom back to scene texture:
 	renderbuffers->BindCurrentFB();
 	glViewport(viewwindow_x, viewwindow_y, viewwindow_w, viewwindow_h);
@@ -154,6 +234,8 @@ void RGL_BloomScene()
 	RGL_RenderScreenQuad();
 	glViewport(0, 0, SCREENWIDTH, SCREENHEIGHT);
 
+	BloomTimestamp(4);
+
 	//FGLDebug::PopGroup();
 }
 
@@ -170,6 +252,8 @@ void RGL_UpdateCameraExposure()
 
 	//FGLDebug::PushGroup("UpdateCameraExposure");
 
+	BloomTimestamp(0);
+
 	FGLPostProcessState savedState;
 	savedState.SaveTextureBindings(2);
 
@@ -228,6 +312,8 @@ void RGL_UpdateCameraExposure()
 	RGL_RenderScreenQuad();
 	glViewport(0, 0, SCREENWIDTH, SCREENHEIGHT);
 
+	BloomTimestamp(1);
+
 	//FGLDebug::PopGroup();
 }
 
@@ -447,11 +533,27 @@ void FBlurShader::BlurHorizontal(float blurAmount, int sampleCount, GLuint input
 
 void FBlurShader::Blur(float blurAmount, int sampleCount, GLuint inputTexture, GLuint outputFrameBuffer, int width, int height, bool vertical)
 {
-	BlurSetup *setup = GetSetup(blurAmount, sampleCount);
-	if (vertical)
-		setup->VerticalShader->Bind();
-	else
-		setup->HorizontalShader->Bind();
+	BlurProgram *prog = GetProgram(blurAmount, sampleCount);
+
+	prog->Shader.Bind();
+	prog->SourceTexture.Set(0);
+	prog->Direction.Set(vertical ? 0.0f : 1.0f, vertical ? 1.0f : 0.0f);
+
+	if (prog->blurAmount != blurAmount || prog->sampleCount != sampleCount)
+	{
+		std::vector<float> sampleWeights;
+		std::vector<int> sampleOffsets;
+		ComputeBlurSamples(sampleCount, blurAmount, sampleWeights, sampleOffsets);
+
+		std::vector<float> offsets(sampleOffsets.begin(), sampleOffsets.end());
+
+		glUniform1fv(prog->Weights, sampleCount, sampleWeights.data());
+		glUniform1fv(prog->Offsets, sampleCount, offsets.data());
+		prog->SampleCount.Set(sampleCount);
+
+		prog->blurAmount = blurAmount;
+		prog->sampleCount = sampleCount;
+	}
 
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, inputTexture);
@@ -469,48 +571,43 @@ void FBlurShader::Blur(float blurAmount, int sampleCount, GLuint inputTexture, G
 
 //==========================================================================
 //
-// Compiles the blur shaders needed for the specified blur amount and
-// kernel size
+// Returns the blur program for the tap class which the kernel size
+// falls into, compiling it the first time it is needed.  Both passes
+// share it, the direction is a uniform.
 //
 //==========================================================================
 
-FBlurShader::BlurSetup *FBlurShader::GetSetup(float blurAmount, int sampleCount)
+FBlurShader::BlurProgram *FBlurShader::GetProgram(float blurAmount, int sampleCount)
 {
-	for (size_t mBlurSetupIndex = 0; mBlurSetupIndex < mBlurSetups.size(); mBlurSetupIndex++)
+	int tapClass = 0;
+	int maxTaps = 8;
+
+	while (maxTaps < sampleCount && tapClass < NumTapClasses - 1)
 	{
-		if (mBlurSetups[mBlurSetupIndex].blurAmount == blurAmount && mBlurSetups[mBlurSetupIndex].sampleCount == sampleCount)
-		{
-			return &mBlurSetups[mBlurSetupIndex];
-		}
+		tapClass++;
+		maxTaps *= 2;
 	}
 
-	BlurSetup blurSetup(blurAmount, sampleCount);
-
-	std::string vertexCode = VertexShaderCode();
-	std::string horizontalCode = FragmentShaderCode(blurAmount, sampleCount, false);
-	std::string verticalCode = FragmentShaderCode(blurAmount, sampleCount, true);
-
-	blurSetup.VerticalShader = std::make_shared<FShaderProgram>();
-	blurSetup.VerticalShader->Compile(FShaderProgram::Vertex, "vertical blur vertex shader", vertexCode, "", 330);
-	blurSetup.VerticalShader->Compile(FShaderProgram::Fragment, "vertical blur fragment shader", verticalCode, "", 330);
-	blurSetup.VerticalShader->SetFragDataLocation(0, "FragColor");
-	blurSetup.VerticalShader->SetAttribLocation(0, "PositionInProjection");
-	blurSetup.VerticalShader->Link("vertical blur");
-	blurSetup.VerticalShader->Bind();
-	glUniform1i(glGetUniformLocation(*blurSetup.VerticalShader.get(), "SourceTexture"), 0);
-
-	blurSetup.HorizontalShader = std::make_shared<FShaderProgram>();
-	blurSetup.HorizontalShader->Compile(FShaderProgram::Vertex, "horizontal blur vertex shader", vertexCode, "", 330);
-	blurSetup.HorizontalShader->Compile(FShaderProgram::Fragment, "horizontal blur fragment shader", horizontalCode, "", 330);
-	blurSetup.HorizontalShader->SetFragDataLocation(0, "FragColor");
-	blurSetup.HorizontalShader->SetAttribLocation(0, "PositionInProjection");
-	blurSetup.HorizontalShader->Link("horizontal blur");
-	blurSetup.HorizontalShader->Bind();
-	glUniform1i(glGetUniformLocation(*blurSetup.HorizontalShader.get(), "SourceTexture"), 0);
-
-	mBlurSetups.push_back(blurSetup);
-
-	return &mBlurSetups[mBlurSetups.size() - 1];
+	BlurProgram *prog = &mPrograms[tapClass];
+
+	if (!prog->Shader)
+	{
+		std::string defines = "#define MAX_TAPS " + std::to_string(maxTaps) + "\n";
+
+		prog->Shader.Compile(FShaderProgram::Vertex, "blur vertex shader", VertexShaderCode(), defines.c_str(), 330);
+		prog->Shader.Compile(FShaderProgram::Fragment, "blur fragment shader", FragmentShaderCode(), defines.c_str(), 330);
+		prog->Shader.SetFragDataLocation(0, "FragColor");
+		prog->Shader.SetAttribLocation(0, "PositionInProjection");
+		prog->Shader.Link("blur");
+
+		prog->SourceTexture.Init(prog->Shader, "SourceTexture");
+		prog->Direction.Init(prog->Shader, "Direction");
+		prog->SampleCount.Init(prog->Shader, "SampleCount");
+		prog->Weights = glGetUniformLocation(prog->Shader, "Weights");
+		prog->Offsets = glGetUniformLocation(prog->Shader, "Offsets");
+	}
+
+	return prog;
 }
 
 //==========================================================================
@@ -535,46 +632,33 @@ std::string FBlurShader::VertexShaderCode()
 
 //==========================================================================
 //
-// Generates the fragment shader GLSL code for a specific blur setup
+// The fragment shader GLSL code.  Offsets are in texels of the source
+// texture, along Direction.
 //
 //==========================================================================
 
-std::string FBlurShader::FragmentShaderCode(float blurAmount, int sampleCount, bool vertical)
+std::string FBlurShader::FragmentShaderCode()
 {
-	std::vector<float> sampleWeights;
-	std::vector<int> sampleOffsets;
-	ComputeBlurSamples(sampleCount, blurAmount, sampleWeights, sampleOffsets);
-
-	const char *fragmentShader =
-		R"(
+	return R"(
 		in vec2 TexCoord;
 		uniform sampler2D SourceTexture;
+		uniform vec2 Direction;
+		uniform int SampleCount;
+		uniform float Weights[MAX_TAPS];
+		uniform float Offsets[MAX_TAPS];
 		out vec4 FragColor;
-		#if __VERSION__ < 130
-		uniform float ScaleX;
-		uniform float ScaleY;
-		vec4 textureOffset(sampler2D s, vec2 texCoord, ivec2 offset)
-		{
-			return texture2D(s, texCoord + vec2(ScaleX * float(offset.x), ScaleY * float(offset.y)));
-		}
-		#endif
-		)";
 
-	std::string loopCode;
-	for (int i = 0; i < sampleCount; i++)
-	{
-		if (i > 0)
-			loopCode += " + ";
+		void main()
+		{
+			vec2 step = Direction / vec2(textureSize(SourceTexture, 0));
+			vec4 sum = vec4(0.0);
 
-		if (vertical)
-			loopCode += "\r\n\t\t\ttextureOffset(SourceTexture, TexCoord, ivec2(0, " + std::to_string(sampleOffsets[i]) + ")) * " + std::to_string((double)sampleWeights[i]);
-		else
-			loopCode += "\r\n\t\t\ttextureOffset(SourceTexture, TexCoord, ivec2(" + std::to_string(sampleOffsets[i]) + ", 0)) * " + std::to_string((double)sampleWeights[i]);
-	}
+			for (int i = 0; i < SampleCount; i++)
+				sum += texture(SourceTexture, TexCoord + step * Offsets[i]) * Weights[i];
 
-	std::string code = fragmentShader;
-	code += "void main() { FragColor = " + loopCode + "; }\r\n";
-	return code;
+			FragColor = sum;
+		}
+	)";
 }
 
 //==========================================================================
@@ -80,25 +80,46 @@ public:
 private:
 	void Blur(float blurAmount, int sampleCount, GLuint inputTexture, GLuint outputFrameBuffer, int width, int height, bool vertical);
 
-	struct BlurSetup
+	// Kernel sizes are rounded up to 8, 16, 32 or 64 taps.  Each class
+	// has one program, the weights and offsets are uniforms.
+	enum { NumTapClasses = 4, MaxTaps = 64 };
+
+	struct BlurProgram
 	{
-		BlurSetup(float blurAmount, int sampleCount) : blurAmount(blurAmount), sampleCount(sampleCount) { }
-
-		float blurAmount;
-		int sampleCount;
-		std::shared_ptr<FShaderProgram> VerticalShader;
-		std::shared_ptr<FShaderProgram> HorizontalShader;
-		FBufferedUniform1f VerticalScaleX, VerticalScaleY;
-		FBufferedUniform1f HorizontalScaleX, HorizontalScaleY;
+		FShaderProgram Shader;
+		FBufferedUniformSampler SourceTexture;
+		FBufferedUniform2f Direction;
+		FBufferedUniform1i SampleCount;
+		GLint Weights = -1;
+		GLint Offsets = -1;
+
+		// what the Weights and Offsets arrays currently hold
+		float blurAmount = -1;
+		int sampleCount = 0;
 	};
 
-	BlurSetup *GetSetup(float blurAmount, int sampleCount);
+	BlurProgram *GetProgram(float blurAmount, int sampleCount);
 
 	std::string VertexShaderCode();
-	std::string FragmentShaderCode(float blurAmount, int sampleCount, bool vertical);
+	std::string FragmentShaderCode();
 
 	float ComputeGaussian(float n, float theta);
 	void ComputeBlurSamples(int sampleCount, float blurAmount, std::vector<float> &sample_weights, std::vector<int> &sample_offsets);
 
-	std::vector<BlurSetup> mBlurSetups;
+	BlurProgram mPrograms[NumTapClasses];
 };
+
+typedef struct
+{
+	// GPU time of each part, in milliseconds
+	float exposure_ms;
+	float extract_ms;
+	float blur_ms;
+	float combine_ms;
+
+	// CPU time spent submitting all of it
+	int cpu_us;
+}
+bloom_stats_t;
+
+extern bloom_stats_t bloom_stats;
@@ -48,6 +48,10 @@
 #include "z_zone.h"
 #include "defaults.h"
 
+#include "system/i_thread.h"
+
+#include <vector>
+
 // -AJA- 1999/06/30: added this
 byte playpal_data[14][256][3];
 
@@ -237,21 +241,271 @@ void V_InitColour(void)
 	InitTranslationTables();
 }
 
+//----------------------------------------------------------------------------
+//  NEAREST COLOUR CUBE
+//----------------------------------------------------------------------------
 //
-// Find the closest matching colour in the palette.
+// The RGB space is split into PAL_CUBE_DIM^3 cells.  For each cell we
+// store the palette entries which could possibly be the closest match
+// for some colour in that cell: any entry whose nearest distance to
+// the cell is not more than the smallest farthest distance of all
+// entries.  A lookup then only checks those few candidates (in index
+// order, like the full search) and gives exactly the same answer.
 //
-int V_FindColour(int r, int g, int b)
+
+#define PAL_CUBE_BITS   5
+#define PAL_CUBE_DIM    (1 << PAL_CUBE_BITS)
+#define PAL_CUBE_SHIFT  (8 - PAL_CUBE_BITS)
+#define PAL_CUBE_CELLS  (PAL_CUBE_DIM * PAL_CUBE_DIM * PAL_CUBE_DIM)
+
+class palette_cube_c
 {
-	int i;
+public:
+	bool valid;
+
+	byte pal[256 * 3];
+
+	// candidates for cell N are cands[cell_start[N] .. cell_start[N+1]-1]
+	std::vector<int>  cell_start;
+	std::vector<byte> cands;
+
+public:
+	palette_cube_c() : valid(false), cell_start(), cands()
+	{ }
+
+	bool Matches(const byte *palette) const
+	{
+		return valid && memcmp(pal, palette, sizeof(pal)) == 0;
+	}
+
+	void Build(const byte *palette);
+
+	inline int Find(int r, int g, int b) const
+	{
+		int cell = ((r >> PAL_CUBE_SHIFT) << (PAL_CUBE_BITS * 2)) |
+		           ((g >> PAL_CUBE_SHIFT) <<  PAL_CUBE_BITS) |
+		            (b >> PAL_CUBE_SHIFT);
+
+		// every cell has at least one candidate
+		const byte *c   = cands.data() + cell_start[cell];
+		const byte *end = cands.data() + cell_start[cell + 1];
+
+		int best = *c;
+		int best_dist = 1 << 30;
+
+		for (; c < end; c++)
+		{
+			const byte *p = pal + (*c) * 3;
+
+			int d_r = r - p[0];
+			int d_g = g - p[1];
+			int d_b = b - p[2];
+
+			int dist = d_r * d_r + d_g * d_g + d_b * d_b;
+
+			if (dist < best_dist)
+			{
+				best = *c;
+				best_dist = dist;
+
+				if (dist == 0)
+					break;
+			}
+		}
+
+		return best;
+	}
+};
+
+static palette_cube_c pal_cube;
+
+
+static inline int AxisMinDist(int v, int lo, int hi)
+{
+	if (v < lo) return lo - v;
+	if (v > hi) return v - hi;
+
+	return 0;
+}
+
+static inline int AxisMaxDist(int v, int lo, int hi)
+{
+	return MAX(ABS(v - lo), ABS(v - hi));
+}
+
+typedef struct
+{
+	const byte *pal;
+
+	// entries which repeat an earlier colour can never be the match
+	bool dup[256];
+
+	// candidates for each slice of the cube (a single red value)
+	std::vector<byte> slice_cands[PAL_CUBE_DIM];
+	std::vector<int>  slice_counts[PAL_CUBE_DIM];
+}
+cube_build_t;
+
+static void BuildCubeSlice(int ri, void *data)
+{
+	cube_build_t *cb = (cube_build_t *) data;
+
+	std::vector<byte>& out = cb->slice_cands[ri];
+	std::vector<int>&  counts = cb->slice_counts[ri];
+
+	counts.resize(PAL_CUBE_DIM * PAL_CUBE_DIM);
+
+	int min_d[256];
+
+	int r_lo = ri << PAL_CUBE_SHIFT;
+	int r_hi = r_lo + (1 << PAL_CUBE_SHIFT) - 1;
+
+	for (int gi = 0; gi < PAL_CUBE_DIM; gi++)
+	for (int bi = 0; bi < PAL_CUBE_DIM; bi++)
+	{
+		int g_lo = gi << PAL_CUBE_SHIFT;
+		int g_hi = g_lo + (1 << PAL_CUBE_SHIFT) - 1;
+		int b_lo = bi << PAL_CUBE_SHIFT;
+		int b_hi = b_lo + (1 << PAL_CUBE_SHIFT) - 1;
+
+		int limit = 1 << 30;
+
+		for (int i = 0; i < 256; i++)
+		{
+			const byte *p = cb->pal + i * 3;
+
+			int n_r = AxisMinDist(p[0], r_lo, r_hi);
+			int n_g = AxisMinDist(p[1], g_lo, g_hi);
+			int n_b = AxisMinDist(p[2], b_lo, b_hi);
+
+			int f_r = AxisMaxDist(p[0], r_lo, r_hi);
+			int f_g = AxisMaxDist(p[1], g_lo, g_hi);
+			int f_b = AxisMaxDist(p[2], b_lo, b_hi);
+
+			min_d[i] = n_r * n_r + n_g * n_g + n_b * n_b;
+
+			limit = MIN(limit, f_r * f_r + f_g * f_g + f_b * f_b);
+		}
+
+		int count = 0;
+
+		for (int i = 0; i < 256; i++)
+		{
+			if (min_d[i] <= limit && ! cb->dup[i])
+			{
+				out.push_back((byte)i);
+				count++;
+			}
+		}
+
+		counts[gi * PAL_CUBE_DIM + bi] = count;
+	}
+}
+
+void palette_cube_c::Build(const byte *palette)
+{
+	memcpy(pal, palette, sizeof(pal));
+
+	cube_build_t *cb = new cube_build_t;
+
+	cb->pal = pal;
+
+	for (int i = 0; i < 256; i++)
+	{
+		cb->dup[i] = false;
+
+		for (int k = 0; k < i && ! cb->dup[i]; k++)
+			if (memcmp(pal + i * 3, pal + k * 3, 3) == 0)
+				cb->dup[i] = true;
+	}
 
+	I_ParallelFor(PAL_CUBE_DIM, BuildCubeSlice, cb);
+
+	cell_start.resize(PAL_CUBE_CELLS + 1);
+	cands.clear();
+
+	int cell = 0;
+	int pos  = 0;
+
+	for (int ri = 0; ri < PAL_CUBE_DIM; ri++)
+	{
+		for (int k = 0; k < PAL_CUBE_DIM * PAL_CUBE_DIM; k++)
+		{
+			cell_start[cell++] = pos;
+			pos += cb->slice_counts[ri][k];
+		}
+
+		cands.insert(cands.end(), cb->slice_cands[ri].begin(), cb->slice_cands[ri].end());
+	}
+
+	cell_start[cell] = pos;
+
+	delete cb;
+
+	valid = true;
+
+	L_WriteDebug("V_PaletteCube: %d candidates (%1.1f per cell)\n",
+		(int)cands.size(), cands.size() / (float)PAL_CUBE_CELLS);
+}
+
+
+//
+// V_PrepareColourCube
+//
+// Makes sure the lookup cube matches the given palette, rebuilding it
+// when the palette has changed.  Must be called from the main thread
+// before using V_FindColours() with that palette from other threads.
+//
+void V_PrepareColourCube(const byte *palette)
+{
+	if (! pal_cube.Matches(palette))
+		pal_cube.Build(palette);
+}
+
+//
+// V_FindColours
+//
+// Finds the closest palette entry for each pixel of a row of RGB or
+// RGBA pixels (the alpha is ignored).  Gives the same results as
+// V_FindColour() would for each pixel.
+//
+void V_FindColours(const byte *palette, const byte *src, int bpp, int count, byte *dest)
+{
+	SYS_ASSERT(pal_cube.Matches(palette));
+
+	int last_r = -1, last_g = -1, last_b = -1;
+	int last = 0;
+
+	for (; count > 0; count--, src += bpp, dest++)
+	{
+		// runs of the same colour are very common
+		if (src[0] != last_r || src[1] != last_g || src[2] != last_b)
+		{
+			last_r = src[0];
+			last_g = src[1];
+			last_b = src[2];
+
+			last = pal_cube.Find(last_r, last_g, last_b);
+		}
+
+		*dest = (byte)last;
+	}
+}
+
+//
+// Find the closest matching colour in the palette (the slow way).
+// Only used when checking the cube.
+//
+static int FindColourBrute(const byte *palette, int r, int g, int b)
+{
 	int best = 0;
 	int best_dist = 1 << 30;
 
-	for (i = 0; i < 256; i++)
+	for (int i = 0; i < 256; i++)
 	{
-		int d_r = ABS(r - playpal_data[0][i][0]);
-		int d_g = ABS(g - playpal_data[0][i][1]);
-		int d_b = ABS(b - playpal_data[0][i][2]);
+		int d_r = ABS(r - palette[i * 3 + 0]);
+		int d_g = ABS(g - palette[i * 3 + 1]);
+		int d_b = ABS(b - palette[i * 3 + 2]);
 
 		int dist = d_r * d_r + d_g * d_g + d_b * d_b;
 
@@ -268,6 +522,102 @@ int V_FindColour(int r, int g, int b)
 	return best;
 }
 
+//
+// Find the closest matching colour in the palette.
+//
+int V_FindColour(int r, int g, int b)
+{
+	const byte *palette = &playpal_data[0][0][0];
+
+	V_PrepareColourCube(palette);
+
+	return pal_cube.Find(r, g, b);
+}
+
+//
+// V_PaletteBenchmark
+//
+// Compares the lookup cube against the brute force search, both for
+// correctness and speed, using the current palette.
+//
+void V_PaletteBenchmark(void)
+{
+	if (! loaded_playpal)
+		return;
+
+	const byte *palette = &playpal_data[0][0][0];
+
+	u32_t t0 = I_ReadMicroSeconds();
+
+	palette_cube_c test_cube;
+	test_cube.Build(palette);
+
+	u32_t t1 = I_ReadMicroSeconds();
+
+	V_PrepareColourCube(palette);
+
+	// a noisy 512x512 image, so runs don't help the cube path
+	const int total = 512 * 512;
+
+	byte *pixels = new byte[total * 4];
+	byte *res_a  = new byte[total];
+	byte *res_b  = new byte[total];
+
+	unsigned int seed = 12345;
+
+	for (int i = 0; i < total * 4; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		pixels[i] = (byte)(seed >> 16);
+	}
+
+	u32_t t2 = I_ReadMicroSeconds();
+
+	for (int i = 0; i < total; i++)
+		res_a[i] = FindColourBrute(palette, pixels[i*4+0], pixels[i*4+1], pixels[i*4+2]);
+
+	u32_t t3 = I_ReadMicroSeconds();
+
+	V_FindColours(palette, pixels, 4, total, res_b);
+
+	u32_t t4 = I_ReadMicroSeconds();
+
+	int mismatches = 0;
+
+	for (int i = 0; i < total; i++)
+		if (res_a[i] != res_b[i])
+			mismatches++;
+
+	// a whole texture remap, like a TEXT_RED translation would do
+	epi::image_data_c *img = new epi::image_data_c(512, 512, 4);
+
+	memcpy(img->PixelAt(0, 0), pixels, total * 4);
+
+	u32_t t5 = I_ReadMicroSeconds();
+
+	R_PaletteRemapRGBA(img, &playpal_data[PAIN_PALS][0][0], palette);
+
+	u32_t t6 = I_ReadMicroSeconds();
+
+	delete img;
+	delete[] pixels;
+	delete[] res_a;
+	delete[] res_b;
+
+	float brute_us = MAX(1, (int)(t3 - t2));
+	float cube_us  = MAX(1, (int)(t4 - t3));
+	float remap_us = MAX(1, (int)(t6 - t5));
+
+	I_Printf("Palette lookup cube: %dx%dx%d cells, %d candidates, built in %1.1f ms\n",
+		PAL_CUBE_DIM, PAL_CUBE_DIM, PAL_CUBE_DIM,
+		(int)test_cube.cands.size(), (t1 - t0) / 1000.0f);
+
+	I_Printf("  brute force : %7.2f Mpixels/sec\n", total / brute_us);
+	I_Printf("  lookup cube : %7.2f Mpixels/sec\n", total / cube_us);
+	I_Printf("  RGBA remap  : %7.2f Mpixels/sec (%d workers)\n", total / remap_us, I_NumWorkers());
+	I_Printf("  mismatches  : %d\n", mismatches);
+}
+
 //
 // Find the best match for the pure colour.  `which' is 0 for red, 1
 // for green and 2 for blue.
@@ -58,6 +58,9 @@ extern byte playpal_data[14][256][3];
 #define PALETTE_SUIT     3
 
 int V_FindColour(int r, int g, int b);
+void V_PrepareColourCube(const byte *palette);
+void V_FindColours(const byte *palette, const byte *src, int bpp, int count, byte *dest);
+void V_PaletteBenchmark(void);
 void V_SetPalette(int type, float amount);
 void VL_NormalizePalette(byte * palette);
 void V_ColourNewFrame(void);
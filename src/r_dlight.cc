@@ -0,0 +1,560 @@
+//----------------------------------------------------------------------------
+//  EDGE Dynamic Light Culling
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  Lights outside the view frustum are kept (flagged) rather than
+//  thrown away, since a mirror or portal may show them.  They are only
+//  skipped while no mirror is active.
+//
+//  The lights are visited in the same order as P_DynamicLightIterator()
+//  would visit them, so the render passes come out the same.
+//
+//----------------------------------------------------------------------------
+
+#include "system/i_defs.h"
+#include "system/i_defs_gl.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "dm_state.h"
+#include "m_bbox.h"
+#include "p_local.h"
+#include "r_defs.h"
+#include "r_dlight.h"
+#include "r_gldefs.h"
+#include "r_misc.h"
+#include "r_shader.h"
+#include "r_state.h"
+
+
+// maximum number of lights used in a view (0 = no limit)
+DEF_CVAR(r_maxdlights, int, "c", 0);
+
+
+extern int dlmap_width;
+extern int dlmap_height;
+extern mobj_t **dlmap_things;
+
+// FIXME: have a proper API
+extern abstract_shader_c *MakeDLightShader(mobj_t *mo);
+
+
+typedef struct
+{
+	mobj_t *mo;
+
+	float x, y, z, r;
+
+	// light map cell, and next light in the same cell (or -1)
+	int cell;
+	int next;
+
+	bool in_view;
+}
+cull_light_t;
+
+typedef struct
+{
+	// view number when 'first' and 'count' were last built
+	int stamp;
+
+	int first;
+	int count;
+}
+sub_lights_t;
+
+
+dlight_stats_t dlight_stats;
+
+static int cull_stamp = 0;
+
+static std::vector<cull_light_t> cull_lights;
+
+// first and last light of each light map cell (-1 when empty)
+static std::vector<int> cell_head;
+static std::vector<int> cell_tail;
+
+static std::vector<int> used_cells;
+
+static std::vector<sub_lights_t> sub_lights;
+static std::vector<int> sub_pool;
+
+// scratch space for the r_maxdlights limit
+static std::vector<cull_light_t> all_lights;
+static std::vector<float> light_dist;
+static std::vector<int> light_order;
+
+
+static bool SphereInView(float x, float y, float z, float r)
+{
+	float dx = x - viewx;
+	float dy = y - viewy;
+	float dz = z - viewz;
+
+	float f = dx * viewforward.x + dy * viewforward.y + dz * viewforward.z;
+
+	if (f < -r || f > r_farclip + r)
+		return false;
+
+	// a little slack for the stretched and widescreen modes
+	float xs = view_x_slope * 1.05f;
+	float ys = view_y_slope * 1.05f;
+
+	float s = dx * viewright.x + dy * viewright.y + dz * viewright.z;
+
+	if (fabs(s) - f * xs > r * sqrt(1.0f + xs * xs))
+		return false;
+
+	float u = dx * viewup.x + dy * viewup.y + dz * viewup.z;
+
+	if (fabs(u) - f * ys > r * sqrt(1.0f + ys * ys))
+		return false;
+
+	return true;
+}
+
+static bool CloserLight(int a, int b)
+{
+	return light_dist[a] < light_dist[b];
+}
+
+static void LimitLights(void)
+{
+	int total = (int)all_lights.size();
+
+	light_dist.resize(total);
+	light_order.resize(total);
+
+	for (int i = 0; i < total; i++)
+	{
+		const cull_light_t *L = &all_lights[i];
+
+		float dx = L->x - viewx;
+		float dy = L->y - viewy;
+		float dz = L->z - viewz;
+
+		float d = MAX(0.0f, (float)sqrt(dx*dx + dy*dy + dz*dz) - L->r);
+
+		// lights in view always beat the others
+		if (! L->in_view)
+			d += r_farclip * 4.0f;
+
+		light_dist[i]  = d;
+		light_order[i] = i;
+	}
+
+	std::nth_element(light_order.begin(), light_order.begin() + r_maxdlights,
+					 light_order.end(), CloserLight);
+
+	for (int k = r_maxdlights; k < total; k++)
+	{
+		cull_light_t *L = &all_lights[light_order[k]];
+
+		if (L->in_view)
+			dlight_stats.dropped++;
+
+		L->mo = NULL;
+	}
+}
+
+static void LinkLight(const cull_light_t *src)
+{
+	int cell  = src->cell;
+	int index = (int)cull_lights.size();
+
+	cull_lights.push_back(*src);
+	cull_lights.back().next = -1;
+
+	if (cell_head[cell] < 0)
+	{
+		cell_head[cell] = index;
+		used_cells.push_back(cell);
+	}
+	else
+		cull_lights[cell_tail[cell]].next = index;
+
+	cell_tail[cell] = index;
+}
+
+//
+// R_CullDynamicLights
+//
+void R_CullDynamicLights(void)
+{
+	u32_t start = I_ReadMicroSeconds();
+
+	cull_stamp++;
+
+	dlight_stats.total   = 0;
+	dlight_stats.visible = 0;
+	dlight_stats.dropped = 0;
+	dlight_stats.queries = 0;
+	dlight_stats.tests   = 0;
+	dlight_stats.hits    = 0;
+
+	dlight_stats.mix_draws  = 0;
+	dlight_stats.mix_verts  = 0;
+	dlight_stats.pass_draws = 0;
+	dlight_stats.pass_verts = 0;
+
+	for (size_t i = 0; i < used_cells.size(); i++)
+	{
+		cell_head[used_cells[i]] = -1;
+		cell_tail[used_cells[i]] = -1;
+	}
+
+	used_cells.clear();
+	cull_lights.clear();
+	all_lights.clear();
+
+	if (! dlmap_things || ! use_dlights)
+		return;
+
+	int cells = dlmap_width * dlmap_height;
+
+	if ((int)cell_head.size() != cells)
+	{
+		cell_head.assign(cells, -1);
+		cell_tail.assign(cells, -1);
+	}
+
+	if ((int)sub_lights.size() != numsubsectors)
+	{
+		sub_lights.resize(numsubsectors);
+
+		for (int i = 0; i < numsubsectors; i++)
+			sub_lights[i].stamp = -1;
+	}
+
+	sub_pool.clear();
+
+	for (int c = 0; c < cells; c++)
+	{
+		for (mobj_t *mo = dlmap_things[c]; mo; mo = mo->dlnext)
+		{
+			SYS_ASSERT(mo->state);
+
+			// skip "off" lights
+			if (mo->state->bright <= 0 || mo->dlight.r <= 0)
+				continue;
+
+			cull_light_t L;
+
+			L.mo = mo;
+			L.x  = mo->x;
+			L.y  = mo->y;
+			L.z  = mo->z;
+			L.r  = mo->dlight.r;
+
+			L.cell = c;
+			L.next = -1;
+
+			L.in_view = SphereInView(L.x, L.y, L.z, L.r);
+
+			dlight_stats.total++;
+
+			if (L.in_view)
+				dlight_stats.visible++;
+
+			all_lights.push_back(L);
+		}
+	}
+
+	if (r_maxdlights > 0 && (int)all_lights.size() > r_maxdlights)
+		LimitLights();
+
+	for (size_t i = 0; i < all_lights.size(); i++)
+		if (all_lights[i].mo)
+			LinkLight(&all_lights[i]);
+
+	dlight_stats.cull_us = (int)(I_ReadMicroSeconds() - start);
+}
+
+
+static inline bool LightWanted(const cull_light_t *L)
+{
+	return L->in_view || num_active_mirrors > 0;
+}
+
+static inline void VisitLight(const cull_light_t *L,
+		                      void (* func)(mobj_t *, void *), void *data)
+{
+	mobj_t *mo = L->mo;
+
+	// create shader if necessary
+	if (! mo->dlight.shader)
+		  mo->dlight.shader = MakeDLightShader(mo);
+
+	dlight_stats.hits++;
+
+	func(mo, data);
+}
+
+//
+// R_DynamicLightIterator
+//
+void R_DynamicLightIterator(float x1, float y1, float z1,
+		                    float x2, float y2, float z2,
+		                    void (* func)(mobj_t *, void *), void *data)
+{
+	if (cull_lights.empty())
+		return;
+
+	dlight_stats.queries++;
+
+	int lx = LIGHTMAP_GET_X(x1) - 1;
+	int ly = LIGHTMAP_GET_Y(y1) - 1;
+	int hx = LIGHTMAP_GET_X(x2) + 1;
+	int hy = LIGHTMAP_GET_Y(y2) + 1;
+
+	lx = MAX(0, lx);  hx = MIN(dlmap_width-1,  hx);
+	ly = MAX(0, ly);  hy = MIN(dlmap_height-1, hy);
+
+	for (int by = ly; by <= hy; by++)
+	for (int bx = lx; bx <= hx; bx++)
+	{
+		for (int k = cell_head[by * dlmap_width + bx]; k >= 0; k = cull_lights[k].next)
+		{
+			const cull_light_t *L = &cull_lights[k];
+
+			if (! LightWanted(L))
+				continue;
+
+			dlight_stats.tests++;
+
+			float r = L->r;
+
+			if (L->x + r <= x1 || L->x - r >= x2 ||
+			    L->y + r <= y1 || L->y - r >= y2 ||
+				L->z + r <= z1 || L->z - r >= z2)
+				continue;
+
+			VisitLight(L, func, data);
+		}
+	}
+}
+
+
+static void BuildSubsectorLights(sub_lights_t *SL, const float *bbox)
+{
+	SL->stamp = cull_stamp;
+	SL->first = (int)sub_pool.size();
+	SL->count = 0;
+
+	int lx = LIGHTMAP_GET_X(bbox[BOXLEFT])   - 1;
+	int ly = LIGHTMAP_GET_Y(bbox[BOXBOTTOM]) - 1;
+	int hx = LIGHTMAP_GET_X(bbox[BOXRIGHT])  + 1;
+	int hy = LIGHTMAP_GET_Y(bbox[BOXTOP])    + 1;
+
+	lx = MAX(0, lx);  hx = MIN(dlmap_width-1,  hx);
+	ly = MAX(0, ly);  hy = MIN(dlmap_height-1, hy);
+
+	for (int by = ly; by <= hy; by++)
+	for (int bx = lx; bx <= hx; bx++)
+	{
+		for (int k = cell_head[by * dlmap_width + bx]; k >= 0; k = cull_lights[k].next)
+		{
+			const cull_light_t *L = &cull_lights[k];
+
+			dlight_stats.tests++;
+
+			float r = L->r;
+
+			if (L->x + r <= bbox[BOXLEFT]   || L->x - r >= bbox[BOXRIGHT] ||
+			    L->y + r <= bbox[BOXBOTTOM] || L->y - r >= bbox[BOXTOP])
+				continue;
+
+			sub_pool.push_back(k);
+			SL->count++;
+		}
+	}
+}
+
+//
+// R_SubsectorLightIterator
+//
+void R_SubsectorLightIterator(subsector_t *sub,
+		                      float x1, float y1, float z1,
+		                      float x2, float y2, float z2,
+		                      void (* func)(mobj_t *, void *), void *data)
+{
+	if (cull_lights.empty())
+		return;
+
+	int num = (int)(sub - subsectors);
+
+	if (num < 0 || num >= (int)sub_lights.size())
+	{
+		R_DynamicLightIterator(x1, y1, z1, x2, y2, z2, func, data);
+		return;
+	}
+
+	const float *bbox = sub->bbox;
+
+	// the shared list is only good for surfaces inside the subsector
+	if (x1 < bbox[BOXLEFT]   - 1 || x2 > bbox[BOXRIGHT] + 1 ||
+		y1 < bbox[BOXBOTTOM] - 1 || y2 > bbox[BOXTOP]   + 1)
+	{
+		R_DynamicLightIterator(x1, y1, z1, x2, y2, z2, func, data);
+		return;
+	}
+
+	dlight_stats.queries++;
+
+	sub_lights_t *SL = &sub_lights[num];
+
+	if (SL->stamp != cull_stamp)
+		BuildSubsectorLights(SL, bbox);
+
+	for (int i = 0; i < SL->count; i++)
+	{
+		const cull_light_t *L = &cull_lights[sub_pool[SL->first + i]];
+
+		if (! LightWanted(L))
+			continue;
+
+		dlight_stats.tests++;
+
+		float r = L->r;
+
+		if (L->x + r <= x1 || L->x - r >= x2 ||
+		    L->y + r <= y1 || L->y - r >= y2 ||
+			L->z + r <= z1 || L->z - r >= z2)
+			continue;
+
+		VisitLight(L, func, data);
+	}
+}
+
+
+//----------------------------------------------------------------------------
+//  BENCHMARK
+//----------------------------------------------------------------------------
+
+static void CountLight(mobj_t *mo, void *data)
+{
+	(*(int *)data)++;
+}
+
+void R_DynamicLightBenchmark(void)
+{
+	if (! dlmap_things || numsubsectors == 0)
+	{
+		I_Printf("No level loaded.\n");
+		return;
+	}
+
+	const int runs = 10;
+
+	int old_hits = 0;
+	int new_hits = 0;
+
+	u32_t t0 = I_ReadMicroSeconds();
+
+	for (int n = 0; n < runs; n++)
+	{
+		old_hits = 0;
+
+		for (int i = 0; i < numsubsectors; i++)
+		{
+			subsector_t *sub = &subsectors[i];
+
+			float bbox[4];
+
+			M_ClearBox(bbox);
+
+			for (seg_t *seg = sub->segs; seg; seg = seg->sub_next)
+				M_AddToBox(bbox, seg->v1->x, seg->v1->y);
+
+			// one floor and one ceiling query, as RGL_DrawPlane does
+			P_DynamicLightIterator(bbox[BOXLEFT],  bbox[BOXBOTTOM], sub->sector->f_h,
+					               bbox[BOXRIGHT], bbox[BOXTOP],    sub->sector->f_h,
+								   CountLight, &old_hits);
+			P_DynamicLightIterator(bbox[BOXLEFT],  bbox[BOXBOTTOM], sub->sector->c_h,
+					               bbox[BOXRIGHT], bbox[BOXTOP],    sub->sector->c_h,
+								   CountLight, &old_hits);
+		}
+
+		for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
+		{
+			float r = mo->radius;
+
+			P_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
+					               mo->x + r, mo->y + r, mo->z + mo->height,
+								   CountLight, &old_hits);
+		}
+	}
+
+	u32_t t1 = I_ReadMicroSeconds();
+
+	int cull_us = 0;
+
+	for (int n = 0; n < runs; n++)
+	{
+		R_CullDynamicLights();
+
+		cull_us += dlight_stats.cull_us;
+
+		new_hits = 0;
+
+		for (int i = 0; i < numsubsectors; i++)
+		{
+			subsector_t *sub = &subsectors[i];
+
+			float bbox[4];
+
+			M_ClearBox(bbox);
+
+			for (seg_t *seg = sub->segs; seg; seg = seg->sub_next)
+				M_AddToBox(bbox, seg->v1->x, seg->v1->y);
+
+			R_SubsectorLightIterator(sub,
+					                 bbox[BOXLEFT],  bbox[BOXBOTTOM], sub->sector->f_h,
+					                 bbox[BOXRIGHT], bbox[BOXTOP],    sub->sector->f_h,
+								     CountLight, &new_hits);
+			R_SubsectorLightIterator(sub,
+					                 bbox[BOXLEFT],  bbox[BOXBOTTOM], sub->sector->c_h,
+					                 bbox[BOXRIGHT], bbox[BOXTOP],    sub->sector->c_h,
+								     CountLight, &new_hits);
+		}
+
+		for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
+		{
+			float r = mo->radius;
+
+			R_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
+					               mo->x + r, mo->y + r, mo->z + mo->height,
+								   CountLight, &new_hits);
+		}
+	}
+
+	u32_t t2 = I_ReadMicroSeconds();
+
+	I_Printf("Dynamic light benchmark (%d runs, %d subsectors):\n", runs, numsubsectors);
+	I_Printf("  lights:   %d on, %d in view, %d over limit\n",
+			 dlight_stats.total, dlight_stats.visible, dlight_stats.dropped);
+	I_Printf("  old:      %d us per run, %d passes\n",
+			 (int)(t1 - t0) / runs, old_hits);
+	I_Printf("  culled:   %d us per run (cull %d us), %d passes, %d tests\n",
+			 (int)(t2 - t1) / runs, cull_us / runs, new_hits, dlight_stats.tests);
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
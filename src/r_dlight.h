@@ -0,0 +1,78 @@
+//----------------------------------------------------------------------------
+//  EDGE Dynamic Light Culling
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  Once per view, every dynamic light is checked against the view
+//  frustum (and the r_maxdlights limit) and the survivors are linked
+//  into the light map cells.  Walls and planes then use a list built
+//  once for their subsector, while sprites and models use the culled
+//  cells, instead of each surface walking the whole light map.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __R_DLIGHT_H__
+#define __R_DLIGHT_H__
+
+typedef struct
+{
+	int total;      // lights which are switched on
+	int visible;    // ... and touch the view frustum
+	int dropped;    // ... but were over the r_maxdlights limit
+
+	int queries;    // calls to the iterators
+	int tests;      // lights checked against a bbox
+	int hits;       // lights passed to a callback (i.e. render passes)
+
+	int mix_draws;  // polygons drawn once per light (WorldMix)
+	int mix_verts;
+	int pass_draws; // polygons drawn with all their lights (r_lightpass)
+	int pass_verts;
+
+	int cull_us;    // time taken by R_CullDynamicLights
+}
+dlight_stats_t;
+
+extern dlight_stats_t dlight_stats;
+
+void R_CullDynamicLights(void);
+// Builds the light lists for the current view.  Called at the start of
+// each view, after the camera has been set up.
+
+void R_DynamicLightIterator(float x1, float y1, float z1,
+		                    float x2, float y2, float z2,
+		                    void (* func)(mobj_t *, void *),
+						    void *data = NULL);
+// Like P_DynamicLightIterator(), but only visits the lights which
+// survived culling for this view.
+
+void R_SubsectorLightIterator(subsector_t *sub,
+		                      float x1, float y1, float z1,
+		                      float x2, float y2, float z2,
+		                      void (* func)(mobj_t *, void *),
+						      void *data = NULL);
+// Same again, for surfaces which lie inside the given subsector
+// (walls and planes).  The lights touching the subsector are found
+// once per view and shared by all its surfaces.
+
+void R_DynamicLightBenchmark(void);
+// Compares the culled iterators with P_DynamicLightIterator over every
+// subsector and thing of the level, without drawing anything.
+
+#endif /* __R_DLIGHT_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
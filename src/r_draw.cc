@@ -121,15 +121,133 @@ void RGL_ReadScreen(int x, int y, int w, int h, byte *rgb_buffer)
 	glFlush();
 
 	glPixelZoom(1.0f, 1.0f);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 
-	for (; h > 0; h--, y++)
+	// rows are tightly packed, so the whole block can be read at once
+	glReadPixels(x, y, w, h, GL_RGB, GL_UNSIGNED_BYTE, rgb_buffer);
+#endif
+}
+
+
+struct screen_read_s
+{
+	int w, h;
+
+	// pixel buffer being filled by the GPU, or 0 when the pixels
+	// were read straight away (into 'direct').
+	GLuint pbo;
+	GLsync fence;
+
+	// number of polls since the read was started
+	int age;
+
+	byte *direct;
+};
+
+//
+// RGL_BeginReadScreen
+//
+// Starts reading a block of the framebuffer.  When pixel buffers are
+// available the copy happens on the GPU and this returns immediately,
+// otherwise the pixels are read right now.
+//
+screen_read_t *RGL_BeginReadScreen(int x, int y, int w, int h)
+{
+	screen_read_t *rd = new screen_read_t;
+
+	rd->w = w;
+	rd->h = h;
+	rd->pbo = 0;
+	rd->fence = NULL;
+	rd->age = 0;
+	rd->direct = NULL;
+
+#ifndef DREAMCAST
+	if (gl.flags & RFL_PIXEL_BUFFER)
+	{
+		glGenBuffers(1, &rd->pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rd->pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, w * h * 3, NULL, GL_STREAM_READ);
+
+		glPixelZoom(1.0f, 1.0f);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(x, y, w, h, GL_RGB, GL_UNSIGNED_BYTE, 0);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (gl.flags & RFL_SYNC)
+			rd->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		return rd;
+	}
+#endif
+
+	rd->direct = new byte[w * h * 3];
+
+	RGL_ReadScreen(x, y, w, h, rd->direct);
+
+	return rd;
+}
+
+//
+// RGL_FinishReadScreen
+//
+// Copies the pixels of a finished read into rgb_buffer (bottom row
+// first, like RGL_ReadScreen) and frees the read.  Returns false if
+// the GPU is not done yet, in which case the read stays valid and
+// should be polled again later.  With 'wait' it always completes.
+//
+bool RGL_FinishReadScreen(screen_read_t *rd, byte *rgb_buffer, bool wait)
+{
+	int total = rd->w * rd->h * 3;
+
+#ifndef DREAMCAST
+	if (rd->pbo)
 	{
-		glReadPixels(x, y, w, 1, GL_RGB, GL_UNSIGNED_BYTE, rgb_buffer);
+		rd->age++;
+
+		if (rd->fence)
+		{
+			GLenum res = glClientWaitSync(rd->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+			                              wait ? 1000000000ULL : 0);
+
+			if (! wait && res != GL_ALREADY_SIGNALED && res != GL_CONDITION_SATISFIED)
+				return false;
+
+			glDeleteSync(rd->fence);
+			rd->fence = NULL;
+		}
+		else if (! wait && rd->age < 3)
+		{
+			// no fences: give the GPU a couple of frames
+			return false;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rd->pbo);
+
+		const byte *src = (const byte *) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
 
-		rgb_buffer += w * 3;
+		if (src)
+		{
+			memcpy(rgb_buffer, src, total);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		else
+			memset(rgb_buffer, 0, total);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glDeleteBuffers(1, &rd->pbo);
 	}
+	else
 #endif
+	{
+		memcpy(rgb_buffer, rd->direct, total);
+		delete[] rd->direct;
+	}
+
+	delete rd;
+
+	return true;
 }
 
 
@@ -37,6 +37,13 @@ void RGL_DrawImage(float x, float y, float w, float h, const image_c *image,
  
 void RGL_ReadScreen(int x, int y, int w, int h, byte *rgb_buffer);
 
+// Asynchronous screen reading.  Begin starts the copy, Finish gets the
+// pixels once the GPU has caught up (returning false until then).
+typedef struct screen_read_s screen_read_t;
+
+screen_read_t *RGL_BeginReadScreen(int x, int y, int w, int h);
+bool RGL_FinishReadScreen(screen_read_t *rd, byte *rgb_buffer, bool wait);
+
 // This routine should inform the lower level system(s) that the
 // screen has changed size/depth.  New size/depth is given.  Must be
 // called before any rendering has occurred (e.g. just before
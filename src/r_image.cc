@@ -33,6 +33,7 @@
 
 #include "system/i_defs.h"
 #include "system/i_defs_gl.h"
+#include "system/i_thread.h"
 
 #include <limits.h>
 #include <list>
@@ -87,6 +88,7 @@ extern void CloseUserFileOrLump(imagedef_c *def, epi::file_c *f);
 
 extern void DeleteSkyTextures(void);
 extern void DeleteColourmapTextures(void);
+extern void DeleteFontTextures(void);
 
 //
 // This structure is for "cached" images (i.e. ready to be used for
@@ -1294,35 +1296,118 @@ static void CreateUserBuiltinShadow(epi::image_data_c *img)
 		}
 }
 
-static GLuint LoadImageOGL(image_c *rim, const colourmap_c *trans2)
+//
+// Making the HQ2x tables for a palette means comparing every pair of
+// colours, so the last few are kept.  Only a handful are ever used
+// (the normal palette, plus any translations).
+//
+#define MAX_HQ2X_PALETTES  8
+
+typedef struct
 {
-	bool clamp = IM_ShouldClamp(rim);
-	bool mip = IM_ShouldMipmap(rim);
-	bool smooth = IM_ShouldSmooth(rim);
+	byte colours[256 * 3];
+	int trans_pixel;
 
-	int max_pix = IM_PixelLimit(rim);
+	epi::Hq2x::palette_c *pal;
+}
+hq2x_palette_t;
 
-	const colourmap_c *trans = trans2 == (const colourmap_c *)-1 ? NULL : trans2;
+// most recently used first
+static std::list<hq2x_palette_t *> hq2x_palettes;
 
-	
-	//I_Printf("LoadImageOGL: Loading \"%.*s\"\n",16,rim->name);
-	
-	if (rim->source_type == IMSRC_User)
+static const epi::Hq2x::palette_c *LookupHq2xPalette(const byte *palette, int trans_pixel)
+{
+	std::list<hq2x_palette_t *>::iterator HI;
+
+	for (HI = hq2x_palettes.begin(); HI != hq2x_palettes.end(); HI++)
 	{
-		if (rim->source.user.def->special & IMGSP_Clamp)
-			clamp = true;
+		hq2x_palette_t *HP = *HI;
 
-		if (rim->source.user.def->special & IMGSP_Mip)
-			mip = true;
-		else if (rim->source.user.def->special & IMGSP_NoMip)
-			mip = false;
+		if (HP->trans_pixel == trans_pixel &&
+			memcmp(HP->colours, palette, sizeof(HP->colours)) == 0)
+		{
+			hq2x_palettes.erase(HI);
+			hq2x_palettes.push_front(HP);
 
-		if (rim->source.user.def->special & IMGSP_Smooth)
-			smooth = true;
-		else if (rim->source.user.def->special & IMGSP_NoSmooth)
-			smooth = false;
+			return HP->pal;
+		}
+	}
+
+	if (hq2x_palettes.size() >= MAX_HQ2X_PALETTES)
+	{
+		hq2x_palette_t *HP = hq2x_palettes.back();
+		hq2x_palettes.pop_back();
+
+		delete HP->pal;
+		delete HP;
 	}
 
+	hq2x_palette_t *HP = new hq2x_palette_t;
+
+	memcpy(HP->colours, palette, sizeof(HP->colours));
+
+	HP->trans_pixel = trans_pixel;
+	HP->pal = new epi::Hq2x::palette_c(palette, trans_pixel);
+
+	hq2x_palettes.push_front(HP);
+
+	return HP->pal;
+}
+
+typedef struct
+{
+	const epi::Hq2x::palette_c *pal;
+
+	epi::image_data_c *src;
+	epi::image_data_c *dest;
+
+	bool solid;
+	int rows;  // per job
+}
+hq2x_job_t;
+
+static void Hq2xRows(int index, void *data)
+{
+	hq2x_job_t *J = (hq2x_job_t *)data;
+
+	int y1 = index * J->rows;
+	int y2 = MIN(y1 + J->rows, J->src->height);
+
+	epi::Hq2x::ConvertRows(J->pal, J->src, J->dest, J->solid, false, y1, y2);
+}
+
+static epi::image_data_c *ConvertHq2x(epi::image_data_c *img,
+	const byte *palette, bool solid)
+{
+	hq2x_job_t J;
+
+	J.pal   = LookupHq2xPalette(palette, solid ? -1 : TRANS_PIXEL);
+	J.src   = img;
+	J.dest  = epi::Hq2x::NewResult(img, solid);
+	J.solid = solid;
+
+	// about 16K pixels per job, small images are done in one go
+	J.rows = MAX(8, 16384 / MAX(1, img->width));
+
+	int count = (img->height + J.rows - 1) / J.rows;
+
+	if (count > 1)
+		I_ParallelFor(count, Hq2xRows, &J);
+	else
+		Hq2xRows(0, &J);
+
+	return J.dest;
+}
+
+//
+// ProcessImage
+//
+// Reads the image and does everything which comes before the upload:
+// offsets, swirling, Hq2x scaling, palette conversion and translation.
+// The result is an RGB or RGBA image.
+//
+static epi::image_data_c *ProcessImage(image_c *rim, const colourmap_c *trans)
+{
 	const byte *what_palette = (const byte *)&playpal_data[0];
 	bool what_pal_cached = false;
 
@@ -1365,10 +1450,8 @@ static GLuint LoadImageOGL(image_c *rim, const colourmap_c *trans2)
 	{
 		bool solid = (rim->opacity == OPAC_Solid);
 
-		epi::Hq2x::Setup(what_palette, solid ? -1 : TRANS_PIXEL);
-
 		epi::image_data_c *scaled_img =
-			epi::Hq2x::Convert(tmp_img, solid, false /* invert */);
+			ConvertHq2x(tmp_img, what_palette, solid);
 
 		delete tmp_img;
 		tmp_img = scaled_img;
@@ -1389,6 +1472,43 @@ static GLuint LoadImageOGL(image_c *rim, const colourmap_c *trans2)
 			R_PaletteRemapRGBA(tmp_img, what_palette, (const byte *)&playpal_data[0]);
 	}
 
+	if (what_pal_cached)
+		W_DoneWithLump(what_palette);
+
+	return tmp_img;
+}
+
+static GLuint LoadImageOGL(image_c *rim, const colourmap_c *trans2)
+{
+	bool clamp = IM_ShouldClamp(rim);
+	bool mip = IM_ShouldMipmap(rim);
+	bool smooth = IM_ShouldSmooth(rim);
+
+	int max_pix = IM_PixelLimit(rim);
+
+	const colourmap_c *trans = trans2 == (const colourmap_c *)-1 ? NULL : trans2;
+
+	
+	//I_Printf("LoadImageOGL: Loading \"%.*s\"\n",16,rim->name);
+	
+	if (rim->source_type == IMSRC_User)
+	{
+		if (rim->source.user.def->special & IMGSP_Clamp)
+			clamp = true;
+
+		if (rim->source.user.def->special & IMGSP_Mip)
+			mip = true;
+		else if (rim->source.user.def->special & IMGSP_NoMip)
+			mip = false;
+
+		if (rim->source.user.def->special & IMGSP_Smooth)
+			smooth = true;
+		else if (rim->source.user.def->special & IMGSP_NoSmooth)
+			smooth = false;
+	}
+
+	epi::image_data_c *tmp_img = ProcessImage(rim, trans);
+
 	if (trans2 == (const colourmap_c *)-1)
 		CreateUserBuiltinShadow(tmp_img); // make shadow
 
@@ -1400,10 +1520,6 @@ static GLuint LoadImageOGL(image_c *rim, const colourmap_c *trans2)
 
 	delete tmp_img;
 
-	if (what_pal_cached)
-		W_DoneWithLump(what_palette);
-
-
 	return tex_id;
 }
 
@@ -1905,6 +2021,48 @@ void W_ImagePreCache(const image_c *image)
 	}
 }
 
+//
+// W_ImageReadRGBA
+//
+epi::image_data_c *W_ImageReadRGBA(const image_c *image, bool whiten)
+{
+	// Intentional Const Override
+	image_c *rim = (image_c *)image;
+
+	// these need their own texture
+	if (rim->source_type == IMSRC_User &&
+		(rim->source.user.def->special & (IMGSP_Smooth | IMGSP_NoSmooth)))
+		return NULL;
+
+	epi::image_data_c *tmp_img = ProcessImage(rim, whiten ? font_whiten_map : NULL);
+
+	if (tmp_img->bpp == 3)
+	{
+		epi::image_data_c *rgba_img =
+			new epi::image_data_c(tmp_img->width, tmp_img->height, 4);
+
+		rgba_img->used_w = tmp_img->used_w;
+		rgba_img->used_h = tmp_img->used_h;
+
+		for (int y = 0; y < tmp_img->height; y++)
+		for (int x = 0; x < tmp_img->width;  x++)
+		{
+			const byte *src = tmp_img->PixelAt(x, y);
+			byte *dest = rgba_img->PixelAt(x, y);
+
+			dest[0] = src[0];
+			dest[1] = src[1];
+			dest[2] = src[2];
+			dest[3] = 255;
+		}
+
+		delete tmp_img;
+		tmp_img = rgba_img;
+	}
+
+	return tmp_img;
+}
+
 //----------------------------------------------------------------------------
 
 static void W_CreateDummyImages(void)
@@ -1983,6 +2141,7 @@ void W_DeleteAllImages(void)
 
 	DeleteSkyTextures();
 	DeleteColourmapTextures();
+	DeleteFontTextures();
 }
 
 //
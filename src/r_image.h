@@ -61,7 +61,11 @@ typedef enum
 }
 image_opacity_e;
 
-//class image_data_c;
+namespace epi
+{
+	class image_data_c;
+}
+
 typedef enum
 {
 	LIQ_None = 0,
@@ -263,6 +267,13 @@ GLuint W_ImageCache(const image_c *image, bool anim = true,
 #endif
 void W_ImagePreCache(const image_c *image);
 
+// reads the image into a new RGBA block (no animation), processed
+// the same way as for its own texture (including Hq2x scaling), for
+// packing it into a larger texture.  When 'whiten' is true the colours
+// are converted the same way as for font_whiten_map.  Returns NULL
+// for images which must keep their own texture (DDF smoothing).
+epi::image_data_c *W_ImageReadRGBA(const image_c *image, bool whiten);
+
 
 // -AJA- planned....
 // rgbcol_t W_ImageGetHue(const image_c *c);
@@ -386,6 +386,13 @@ void RGL_LoadExtensions()
 			gl.flags |= RFL_SAMPLER_OBJECTS;
 		}
 
+		// used for asynchronous screen reads (screenshots)
+		if (gl_version >= 2.1f || RGL_CheckExtension("GL_ARB_pixel_buffer_object")) gl.flags |= RFL_PIXEL_BUFFER;
+		if (gl_version >= 3.2f || RGL_CheckExtension("GL_ARB_sync")) gl.flags |= RFL_SYNC;
+
+		// used for building the mipmaps of solid textures
+		if (gl_version >= 3.0f || RGL_CheckExtension("GL_ARB_framebuffer_object")) gl.flags |= RFL_GENERATE_MIPMAP;
+
 		// The minimum requirement for the modern render path are GL 3.0 + uniform buffers.
 		// Also exclude the Linux Mesa driver at GL 3.0 because it errors out on shader compilation.
 		if (gl_version < 3.0f || (gl_version < 3.1f && (!RGL_CheckExtension("GL_ARB_uniform_buffer_object") || strstr(gl.vendorstring, "X.Org") != nullptr)))
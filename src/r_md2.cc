@@ -33,12 +33,16 @@
 #include "system/i_defs.h"
 #include "system/i_defs_gl.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "../epi/types.h"
 #include "../epi/endianess.h"
 
 #include "r_md2.h"
 #include "r_gldefs.h"
 #include "r_colormap.h"
+#include "r_dlight.h"
 #include "r_effects.h"
 #include "r_image.h"
 #include "r_misc.h"
@@ -47,8 +51,18 @@
 #include "r_shader.h"
 #include "r_units.h"
 #include "p_blockmap.h"
+#include "p_local.h"
 #include "m_math.h"
 #include "w_model.h"
+#include "w_modelcache.h"
+
+#include "../epi/file_memory.h"
+#include "../epi/math_crc.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MD2_USE_SSE  1
+#include <xmmintrin.h>
+#endif
 
 extern int r_oldblend;
 
@@ -492,18 +506,33 @@ public:
 
 	int verts_per_frame;
 
+	// when loaded from the model cache, everything lives in here
+	byte *cache_block;
+
 public:
 	md2_model_c(int _nframe, int _npoint, int _nstrip) :
 		num_frames(_nframe), num_points(_npoint),
-		num_strips(_nstrip), verts_per_frame(0)
+		num_strips(_nstrip), verts_per_frame(0), cache_block(NULL)
 	{
 		frames = new mod_frame_c[num_frames];
 		points = new mod_point_c[num_points];
 		strips = new mod_strip_c[num_strips];
 	}
 
+	md2_model_c(byte *block) :
+		num_frames(0), num_points(0), num_strips(0),
+		frames(NULL), points(NULL), strips(NULL),
+		verts_per_frame(0), cache_block(block)
+	{ }
+
 	~md2_model_c()
 	{
+		if (cache_block)
+		{
+			delete[] cache_block;
+			return;
+		}
+
 		delete[] frames;
 		delete[] points;
 		delete[] strips;
@@ -985,6 +1014,199 @@ md2_model_c *MD3_LoadModel(epi::file_c *f)
 }
 
 
+/*============== MODEL CACHE ====================*/
+
+typedef struct
+{
+	int num_frames;
+	int num_points;
+	int num_strips;
+
+	int verts_per_frame;
+
+	mod_frame_c *frames;
+	mod_point_c *points;
+	mod_strip_c *strips;
+}
+md2_cache_header_t;
+
+static u32_t MD2CacheLayout(void)
+{
+	epi::crc32_c crc;
+
+	crc += (s32_t) 1;  // version
+	crc += (s32_t) sizeof(md2_cache_header_t);
+	crc += (s32_t) sizeof(mod_vertex_c);
+	crc += (s32_t) sizeof(mod_frame_c);
+	crc += (s32_t) sizeof(mod_point_c);
+	crc += (s32_t) sizeof(mod_strip_c);
+
+	return crc.crc;
+}
+
+static void WriteMD2Cache(md2_model_c *md, model_cache_writer_c *w)
+{
+	md2_cache_header_t hdr;
+
+	hdr.num_frames = md->num_frames;
+	hdr.num_points = md->num_points;
+	hdr.num_strips = md->num_strips;
+	hdr.verts_per_frame = md->verts_per_frame;
+
+	int hd_ofs = w->Add(&hdr, sizeof(hdr));
+	int fr_ofs = w->Add(md->frames, md->num_frames * sizeof(mod_frame_c));
+	int po_ofs = w->Add(md->points, md->num_points * sizeof(mod_point_c));
+	int st_ofs = w->Add(md->strips, md->num_strips * sizeof(mod_strip_c));
+
+	for (int i = 0; i < md->num_frames; i++)
+	{
+		mod_frame_c *src = &md->frames[i];
+
+		int count = 0;
+
+		while (src->used_normals[count] >= 0)
+			count++;
+
+		int ve_ofs = w->Add(src->vertices, md->verts_per_frame * sizeof(mod_vertex_c));
+		int na_ofs = w->Add(src->name, (int)strlen(src->name) + 1);
+		int un_ofs = w->Add(src->used_normals, (count + 1) * sizeof(short));
+
+		mod_frame_c *dest = (mod_frame_c *) w->At(fr_ofs) + i;
+
+		dest->vertices     = model_cache_writer_c::Offset<mod_vertex_c>(ve_ofs);
+		dest->name         = model_cache_writer_c::Offset<const char>(na_ofs);
+		dest->used_normals = model_cache_writer_c::Offset<short>(un_ofs);
+	}
+
+	md2_cache_header_t *dest = (md2_cache_header_t *) w->At(hd_ofs);
+
+	dest->frames = model_cache_writer_c::Offset<mod_frame_c>(fr_ofs);
+	dest->points = model_cache_writer_c::Offset<mod_point_c>(po_ofs);
+	dest->strips = model_cache_writer_c::Offset<mod_strip_c>(st_ofs);
+}
+
+//
+// CheckMD2Cache
+//
+// Checks the indices stored in the cache, which Fix() knows nothing
+// about, so a damaged cache cannot make the drawing code read past
+// the arrays.
+//
+static bool CheckMD2Cache(const md2_cache_header_t *hdr)
+{
+	for (int i = 0; i < hdr->num_points; i++)
+	{
+		int idx = hdr->points[i].vert_idx;
+
+		if (idx < 0 || idx >= hdr->verts_per_frame)
+			return false;
+	}
+
+	for (int i = 0; i < hdr->num_strips; i++)
+	{
+		const mod_strip_c *strip = &hdr->strips[i];
+
+		if (strip->first < 0 || strip->count < 0 ||
+			strip->first > hdr->num_points - strip->count)
+			return false;
+	}
+
+	for (int i = 0; i < hdr->num_frames; i++)
+	{
+		const mod_frame_c *frame = &hdr->frames[i];
+
+		for (int v = 0; v < hdr->verts_per_frame; v++)
+		{
+			int n = frame->vertices[v].normal_idx;
+
+			if (n < 0 || n >= MD2_NUM_NORMALS)
+				return false;
+		}
+
+		for (const short *n = frame->used_normals; *n >= 0; n++)
+			if (*n >= MD2_NUM_NORMALS)
+				return false;
+	}
+
+	return true;
+}
+
+static md2_model_c *ReadMD2Cache(model_cache_reader_c *rd)
+{
+	if (rd->size < (int)sizeof(md2_cache_header_t))
+		return NULL;
+
+	md2_cache_header_t *hdr = (md2_cache_header_t *) rd->data;
+
+	if (hdr->num_frames <= 0 || hdr->num_points < 0 || hdr->num_strips < 0 ||
+		hdr->verts_per_frame < 0)
+		return NULL;
+
+	rd->Fix(hdr->frames, hdr->num_frames);
+	rd->Fix(hdr->points, hdr->num_points);
+	rd->Fix(hdr->strips, hdr->num_strips);
+
+	for (int i = 0; rd->ok && i < hdr->num_frames; i++)
+	{
+		mod_frame_c *frame = &hdr->frames[i];
+
+		rd->Fix(frame->vertices, hdr->verts_per_frame);
+		rd->FixString(frame->name);
+		rd->FixShortList(frame->used_normals);
+	}
+
+	if (! rd->ok || ! CheckMD2Cache(hdr))
+		return NULL;
+
+	md2_model_c *md = new md2_model_c(rd->Release());
+
+	md->num_frames = hdr->num_frames;
+	md->num_points = hdr->num_points;
+	md->num_strips = hdr->num_strips;
+	md->verts_per_frame = hdr->verts_per_frame;
+
+	md->frames = hdr->frames;
+	md->points = hdr->points;
+	md->strips = hdr->strips;
+
+	return md;
+}
+
+//
+// MD2_LoadCachedModel
+//
+md2_model_c *MD2_LoadCachedModel(byte *lump, int length, bool is_md3)
+{
+	int   kind   = is_md3 ? MDC_MD3 : MDC_MD2;
+	u32_t key    = W_ModelCacheKey(lump, length);
+	u32_t layout = MD2CacheLayout();
+
+	model_cache_reader_c rd;
+
+	if (W_LoadModelCache(kind, key, length, layout, &rd))
+	{
+		md2_model_c *md = ReadMD2Cache(&rd);
+
+		if (md)
+			return md;
+
+		I_Debugf("Model cache is damaged, rebuilding it.\n");
+	}
+
+	epi::mem_file_c f(lump, length, false);
+
+	md2_model_c *md = is_md3 ? MD3_LoadModel(&f) : MD2_LoadModel(&f);
+
+	model_cache_writer_c *w = new model_cache_writer_c();
+
+	WriteMD2Cache(md, w);
+
+	W_SaveModelCache(kind, key, length, layout, w);
+
+	return md;
+}
+
+
 /*============== MODEL RENDERING ====================*/
 
 
@@ -1027,44 +1249,164 @@ typedef struct
 
 	multi_color_c nm_colors[MD2_NUM_NORMALS];
 
+	// normals after mlook and rotation (only the used ones)
+	vec3_t nm_dirs[MD2_NUM_NORMALS];
+
 	short * used_normals;
 
+	// frame which supplies the normals (the nearest one)
+	const mod_frame_c *n_frame;
+
+	// interpolated vertices in world space (see MD2_LerpFrames)
+	const float *lerp_x;
+	const float *lerp_y;
+	const float *lerp_z;
+
 	bool is_additive;
+}
+model_coord_data_t;
 
-public:
-	void CalcPos(vec3_t *pos, float x1, float y1, float z1) const
-	{
-		x1 *= xy_scale;
-		y1 *= xy_scale;
-		z1 *=  z_scale;
 
-		float x2 = x1 * kx_mat.x + z1 * kx_mat.y;
-		float z2 = x1 * kz_mat.x + z1 * kz_mat.y;
-		float y2 = y1;
+// Interpolated vertices of the model being drawn, as separate X, Y
+// and Z arrays (each padded to a multiple of four).  They are computed
+// once per model instance and then shared by every pass and strip,
+// instead of each pass doing the lerp and transform for every point.
+static std::vector<float> md2_lerp_buf;
 
-		pos->x = x + x2 * rx_mat.x + y2 * rx_mat.y;
-		pos->y = y + x2 * ry_mat.x + y2 * ry_mat.y;
-		pos->z = z + z2;
-	}
 
-	void CalcNormal(vec3_t *normal, const mod_vertex_c *vert) const
+static void RotateNormals(model_coord_data_t *data)
+{
+	short *n_list = data->used_normals;
+
+	for (; *n_list >= 0; n_list++)
 	{
-		short n = vert->normal_idx;
+		short n = *n_list;
 
 		float nx1 = md2_normals[n].x;
 		float ny1 = md2_normals[n].y;
 		float nz1 = md2_normals[n].z;
 
-		float nx2 = nx1 * kx_mat.x + nz1 * kx_mat.y;
-		float nz2 = nx1 * kz_mat.x + nz1 * kz_mat.y;
+		float nx2 = nx1 * data->kx_mat.x + nz1 * data->kx_mat.y;
+		float nz2 = nx1 * data->kz_mat.x + nz1 * data->kz_mat.y;
 		float ny2 = ny1;
 
-		normal->x = nx2 * rx_mat.x + ny2 * rx_mat.y;
-		normal->y = nx2 * ry_mat.x + ny2 * ry_mat.y;
-		normal->z = nz2;
+		data->nm_dirs[n].x = nx2 * data->rx_mat.x + ny2 * data->rx_mat.y;
+		data->nm_dirs[n].y = nx2 * data->ry_mat.x + ny2 * data->ry_mat.y;
+		data->nm_dirs[n].z = nz2;
 	}
 }
-model_coord_data_t;
+
+//
+// SetupLerpMatrix
+//
+// Combines the scaling, bias, mirroring, mlook and rotation of a model
+// into one 3x4 matrix, which is applied to the lerped frame vertices.
+//
+static void SetupLerpMatrix(const model_coord_data_t *data, float m[3][4])
+{
+	float sx = data->xy_scale;
+	float sy = MIR_Reflective() ? -data->xy_scale : data->xy_scale;
+	float sz = data->z_scale;
+
+	float ax = data->kx_mat.x * sx;
+	float az = data->kx_mat.y * sz;
+
+	m[0][0] = data->rx_mat.x * ax;
+	m[0][1] = data->rx_mat.y * sy;
+	m[0][2] = data->rx_mat.x * az;
+	m[0][3] = data->x + m[0][2] * data->bias;
+
+	m[1][0] = data->ry_mat.x * ax;
+	m[1][1] = data->ry_mat.y * sy;
+	m[1][2] = data->ry_mat.x * az;
+	m[1][3] = data->y + m[1][2] * data->bias;
+
+	m[2][0] = data->kz_mat.x * sx;
+	m[2][1] = 0;
+	m[2][2] = data->kz_mat.y * sz;
+	m[2][3] = data->z + m[2][2] * data->bias;
+}
+
+static inline void LerpVertex(const float m[3][4],
+		const mod_vertex_c *v1, const mod_vertex_c *v2, float lerp,
+		float *px, float *py, float *pz)
+{
+	float x1 = v1->x + (v2->x - v1->x) * lerp;
+	float y1 = v1->y + (v2->y - v1->y) * lerp;
+	float z1 = v1->z + (v2->z - v1->z) * lerp;
+
+	*px = m[0][0] * x1 + m[0][1] * y1 + m[0][2] * z1 + m[0][3];
+	*py = m[1][0] * x1 + m[1][1] * y1 + m[1][2] * z1 + m[1][3];
+	*pz = m[2][0] * x1 + m[2][1] * y1 + m[2][2] * z1 + m[2][3];
+}
+
+//
+// MD2_LerpFrames
+//
+// Interpolates every vertex of the two frames and transforms it into
+// world space, storing the results in px/py/pz.  The SSE version does
+// four vertices at a time (a mod_vertex_c is exactly four floats wide,
+// the normal index ending up in the unused fourth lane).
+//
+static void MD2_LerpFrames(const model_coord_data_t *data, int count,
+		                   float *px, float *py, float *pz, bool use_sse)
+{
+	float m[3][4];
+
+	SetupLerpMatrix(data, m);
+
+	const mod_vertex_c *v1 = data->frame1->vertices;
+	const mod_vertex_c *v2 = data->frame2->vertices;
+
+	float lerp = data->lerp;
+
+	int i = 0;
+
+#ifdef MD2_USE_SSE
+	if (use_sse && sizeof(mod_vertex_c) == 4 * sizeof(float))
+	{
+		__m128 L = _mm_set1_ps(lerp);
+
+		__m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]);
+		__m128 m02 = _mm_set1_ps(m[0][2]), m03 = _mm_set1_ps(m[0][3]);
+		__m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]);
+		__m128 m12 = _mm_set1_ps(m[1][2]), m13 = _mm_set1_ps(m[1][3]);
+		__m128 m20 = _mm_set1_ps(m[2][0]);
+		__m128 m22 = _mm_set1_ps(m[2][2]), m23 = _mm_set1_ps(m[2][3]);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 a0 = _mm_loadu_ps(&v1[i+0].x);
+			__m128 a1 = _mm_loadu_ps(&v1[i+1].x);
+			__m128 a2 = _mm_loadu_ps(&v1[i+2].x);
+			__m128 a3 = _mm_loadu_ps(&v1[i+3].x);
+
+			__m128 b0 = _mm_loadu_ps(&v2[i+0].x);
+			__m128 b1 = _mm_loadu_ps(&v2[i+1].x);
+			__m128 b2 = _mm_loadu_ps(&v2[i+2].x);
+			__m128 b3 = _mm_loadu_ps(&v2[i+3].x);
+
+			// now a0 = four X values, a1 = four Y, a2 = four Z
+			_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+			_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+			__m128 X = _mm_add_ps(a0, _mm_mul_ps(_mm_sub_ps(b0, a0), L));
+			__m128 Y = _mm_add_ps(a1, _mm_mul_ps(_mm_sub_ps(b1, a1), L));
+			__m128 Z = _mm_add_ps(a2, _mm_mul_ps(_mm_sub_ps(b2, a2), L));
+
+			_mm_storeu_ps(px + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, X), _mm_mul_ps(m01, Y)),
+			                                 _mm_add_ps(_mm_mul_ps(m02, Z), m03)));
+			_mm_storeu_ps(py + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, X), _mm_mul_ps(m11, Y)),
+			                                 _mm_add_ps(_mm_mul_ps(m12, Z), m13)));
+			_mm_storeu_ps(pz + i, _mm_add_ps(_mm_mul_ps(m20, X),
+			                                 _mm_add_ps(_mm_mul_ps(m22, Z), m23)));
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		LerpVertex(m, &v1[i], &v2[i], lerp, px + i, py + i, pz + i);
+}
 
 
 static void InitNormalColors(model_coord_data_t *data)
@@ -1086,23 +1428,9 @@ static void ShadeNormals(abstract_shader_c *shader,
 	{
 		short n = *n_list;
 
-		// FIXME !!!! pre-rotate normals too
-		float nx, ny, nz;
-		{
-			float nx1 = md2_normals[n].x;
-			float ny1 = md2_normals[n].y;
-			float nz1 = md2_normals[n].z;
-
-			float nx2 = nx1 * data->kx_mat.x + nz1 * data->kx_mat.y;
-			float nz2 = nx1 * data->kz_mat.x + nz1 * data->kz_mat.y;
-			float ny2 = ny1;
+		const vec3_t *dir = &data->nm_dirs[n];
 
-			nx = nx2 * data->rx_mat.x + ny2 * data->rx_mat.y;
-			ny = nx2 * data->ry_mat.x + ny2 * data->ry_mat.y;
-			nz = nz2;
-		}
-
-		shader->Corner(data->nm_colors + n, nx, ny, nz, data->mo, data->is_weapon);
+		shader->Corner(data->nm_colors + n, dir->x, dir->y, dir->z, data->mo, data->is_weapon);
 	}
 }
 
@@ -1161,47 +1489,29 @@ static void UpdateMulticols(model_coord_data_t *data)
 	}
 }
 
-static inline float LerpIt(float v1, float v2, float lerp)
-{
-	return v1 * (1.0f - lerp) + v2 * lerp;
-}
-
-
 static inline void ModelCoordFunc(model_coord_data_t *data,
 					 int v_idx, vec3_t *pos,
 					 float *rgb, vec2_t *texc, vec3_t *normal)
 {
 	const md2_model_c *md = data->model;
 
-	const mod_frame_c *frame1 = data->frame1;
-	const mod_frame_c *frame2 = data->frame2;
-	const mod_strip_c *strip  = data->strip;
+	const mod_strip_c *strip = data->strip;
 
 	SYS_ASSERT(strip->first + v_idx >= 0);
 	SYS_ASSERT(strip->first + v_idx < md->num_points);
 
 	const mod_point_c *point = &md->points[strip->first + v_idx];
 
-SYS_ASSERT(point->vert_idx >= 0);
-SYS_ASSERT(point->vert_idx < md->verts_per_frame);
-
-	const mod_vertex_c *vert1 = &frame1->vertices[point->vert_idx];
-	const mod_vertex_c *vert2 = &frame2->vertices[point->vert_idx];
-
-
-	float x1 = LerpIt(vert1->x, vert2->x, data->lerp);
-	float y1 = LerpIt(vert1->y, vert2->y, data->lerp);
-	float z1 = LerpIt(vert1->z, vert2->z, data->lerp) + data->bias;
-
-	if (MIR_Reflective())
-		y1 = -y1;
+	int vi = point->vert_idx;
 
-	data->CalcPos(pos, x1, y1, z1);
+SYS_ASSERT(vi >= 0);
+SYS_ASSERT(vi < md->verts_per_frame);
 
+	pos->Set(data->lerp_x[vi], data->lerp_y[vi], data->lerp_z[vi]);
 
-	const mod_vertex_c *n_vert = (data->lerp < 0.5) ? vert1 : vert2;
+	short n = data->n_frame->vertices[vi].normal_idx;
 
-	data->CalcNormal(normal, n_vert);
+	*normal = data->nm_dirs[n];
 
 
 	if (data->is_fuzzy)
@@ -1216,7 +1526,7 @@ SYS_ASSERT(point->vert_idx < md->verts_per_frame);
 	texc->Set(point->skin_s * data->im_right, point->skin_t * data->im_top);
 
 
-	multi_color_c *col = &data->nm_colors[n_vert->normal_idx];
+	multi_color_c *col = &data->nm_colors[n];
 
 	if (! data->is_additive)
 	{
@@ -1322,9 +1632,11 @@ void MD2_RenderModel(md2_model_c *md, const skindef_c *skin,bool is_weapon,
 	M_Angle2Matrix(~ ang, &data.rx_mat, &data.ry_mat);
 
 
-	data.used_normals = (lerp < 0.5) ? data.frame1->used_normals : data.frame2->used_normals;
+	data.n_frame = (lerp < 0.5) ? data.frame1 : data.frame2;
+	data.used_normals = data.n_frame->used_normals;
 
 	InitNormalColors(&data);
+	RotateNormals(&data);
 
 
 	GLuint skin_tex = 0;
@@ -1380,13 +1692,13 @@ void MD2_RenderModel(md2_model_c *md, const skindef_c *skin,bool is_weapon,
 				short l=CLAMP(0,props->lightlevel+mo->state->bright,255);
 				RGL_SetAmbientLight(l,l,l);
 				RGL_ClearLights();
-				P_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
+				R_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
 									   mo->x + r, mo->y + r, mo->z + mo->height,
 									   DLIT_CollectLights, &data);
 			}
 			else 
 			{
-				P_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
+				R_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
 						               mo->x + r, mo->y + r, mo->z + mo->height,
 									   DLIT_Model, &data);
 
@@ -1399,6 +1711,23 @@ void MD2_RenderModel(md2_model_c *md, const skindef_c *skin,bool is_weapon,
 	}
 
 
+	/* interpolate the vertices once, for all passes */
+
+	int stride = (md->verts_per_frame + 3) & ~3;
+
+	if ((int)md2_lerp_buf.size() < stride * 3 + 4)
+		md2_lerp_buf.resize(stride * 3 + 4);
+
+	float *lerp_x = &md2_lerp_buf[0];
+
+	data.lerp_x = lerp_x;
+	data.lerp_y = lerp_x + stride;
+	data.lerp_z = lerp_x + stride * 2;
+
+	MD2_LerpFrames(&data, md->verts_per_frame,
+	               lerp_x, lerp_x + stride, lerp_x + stride * 2, true);
+
+
 	/* draw the model */
 
 	int num_pass = data.is_fuzzy  ? 1 :
@@ -1537,5 +1866,147 @@ void MD2_RenderModel_2D(md2_model_c *md, const image_c *skin_img, int frame,
 	glDisable(GL_CULL_FACE);
 }
 
+
+//
+// MD2_Benchmark
+//
+// Times the vertex work for every MD2/MD3 model in the level, the old
+// way (each pass lerping and transforming every point) against lerping
+// each vertex once per instance, without drawing anything.
+//
+void MD2_Benchmark(void)
+{
+	std::vector<md2_model_c *> list;
+
+	for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
+	{
+		if (! mo->state || ! (mo->state->flags & SFF_Model))
+			continue;
+
+		modeldef_c *mdef = W_GetModel(mo->state->sprite);
+
+		if (mdef->modeltype != MODEL_MD2 || ! mdef->model)
+			continue;
+
+		if (std::find(list.begin(), list.end(), mdef->model) == list.end())
+			list.push_back(mdef->model);
+	}
+
+	if (list.empty())
+	{
+		I_Printf("No MD2/MD3 models in the level.\n");
+		return;
+	}
+
+	const int runs = 200;
+
+	int num_pass = 2 + detail_level * 2;
+
+	u32_t t_old = 0, t_scalar = 0, t_sse = 0;
+
+	int total_points = 0;
+	int total_verts  = 0;
+
+	std::vector<vec3_t> out;
+
+	for (size_t k = 0; k < list.size(); k++)
+	{
+		md2_model_c *md = list[k];
+
+		model_coord_data_t data;
+
+		data.model  = md;
+		data.frame1 = &md->frames[0];
+		data.frame2 = &md->frames[md->num_frames > 1 ? 1 : 0];
+		data.lerp   = 0.37f;
+
+		data.x = data.y = data.z = 0;
+		data.xy_scale = data.z_scale = 1.0f;
+		data.bias = 0;
+
+		M_Angle2Matrix(0, &data.kx_mat, &data.kz_mat);
+		M_Angle2Matrix(~ ANG45, &data.rx_mat, &data.ry_mat);
+
+		int stride = (md->verts_per_frame + 3) & ~3;
+
+		if ((int)md2_lerp_buf.size() < stride * 3 + 4)
+			md2_lerp_buf.resize(stride * 3 + 4);
+
+		if ((int)out.size() < md->num_points + 1)
+			out.resize(md->num_points + 1);
+
+		float *px = &md2_lerp_buf[0];
+		float *py = px + stride;
+		float *pz = py + stride;
+
+		float m[3][4];
+
+		u32_t t0 = I_ReadMicroSeconds();
+
+		for (int n = 0; n < runs; n++)
+		{
+			SetupLerpMatrix(&data, m);
+
+			for (int pass = 0; pass < num_pass; pass++)
+			for (int i = 0; i < md->num_points; i++)
+			{
+				int vi = md->points[i].vert_idx;
+
+				LerpVertex(m, &data.frame1->vertices[vi], &data.frame2->vertices[vi],
+				           data.lerp, &out[i].x, &out[i].y, &out[i].z);
+			}
+		}
+
+		u32_t t1 = I_ReadMicroSeconds();
+
+		for (int n = 0; n < runs; n++)
+		{
+			MD2_LerpFrames(&data, md->verts_per_frame, px, py, pz, false);
+
+			for (int pass = 0; pass < num_pass; pass++)
+			for (int i = 0; i < md->num_points; i++)
+			{
+				int vi = md->points[i].vert_idx;
+
+				out[i].Set(px[vi], py[vi], pz[vi]);
+			}
+		}
+
+		u32_t t2 = I_ReadMicroSeconds();
+
+		for (int n = 0; n < runs; n++)
+		{
+			MD2_LerpFrames(&data, md->verts_per_frame, px, py, pz, true);
+
+			for (int pass = 0; pass < num_pass; pass++)
+			for (int i = 0; i < md->num_points; i++)
+			{
+				int vi = md->points[i].vert_idx;
+
+				out[i].Set(px[vi], py[vi], pz[vi]);
+			}
+		}
+
+		u32_t t3 = I_ReadMicroSeconds();
+
+		t_old    += t1 - t0;
+		t_scalar += t2 - t1;
+		t_sse    += t3 - t2;
+
+		total_points += md->num_points;
+		total_verts  += md->verts_per_frame;
+	}
+
+	I_Printf("MD2 benchmark (%d models, %d runs, %d passes):\n",
+			 (int)list.size(), runs, num_pass);
+	I_Printf("  size:     %d points, %d vertices per frame\n",
+			 total_points, total_verts);
+	I_Printf("  per pass: %d us per run\n", (int)t_old / runs);
+	I_Printf("  once:     %d us per run\n", (int)t_scalar / runs);
+#ifdef MD2_USE_SSE
+	I_Printf("  once+SSE: %d us per run\n", (int)t_sse / runs);
+#endif
+}
+
 //--- editor settings ---
 // vi:ts=4:sw=4:noexpandtab
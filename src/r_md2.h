@@ -32,6 +32,10 @@ class skindef_c;	//forward declaration
 md2_model_c *MD2_LoadModel(epi::file_c *f); 
 md2_model_c *MD3_LoadModel(epi::file_c *f); 
 
+md2_model_c *MD2_LoadCachedModel(byte *lump, int length, bool is_md3);
+// Loads an MD2 or MD3 model from the model cache, falling back to the
+// lump (which is then added to the cache).
+
 short MD2_FindFrame(md2_model_c *md, const char *name);
 
 void MD2_RenderModel(md2_model_c *md, const skindef_c * skin, bool is_weapon,
@@ -44,6 +48,10 @@ void MD2_RenderModel_2D(md2_model_c *md, const image_c * skin_img, int frame,
 		                float x, float y, float xscale, float yscale,
 		                const mobjtype_c *info);
 
+void MD2_Benchmark(void);
+// Times the per-instance vertex interpolation on the models in the
+// level (console command "md2bench").
+
 #endif /* __R_MD2_H__ */
 
 //--- editor settings ---
@@ -25,8 +25,10 @@
 #include "dm_defs.h"
 #include "dm_state.h"
 #include "p_local.h"
+#include "r_dlight.h"
 #include "r_image.h"
 #include "w_model.h"
+#include "w_modelcache.h"
 #include "r_draw.h"
 //#include "w_model.h"
 #include "r_md5.h"
@@ -48,6 +50,11 @@
 #include "../src/r_shader.h"
 #include "../src/r_units.h"
 
+#include "system/i_thread.h"
+
+#include <map>
+#include <vector>
+
 //64 bit hack!
 #ifdef _M_X64
 #define SSE2 1
@@ -65,10 +72,65 @@ md5_animation_handle_t;
 static int num_animations = 0;
 static md5_animation_handle_t animations[R_MAX_MD5_ANIMATIONS];
 
-static basevert vbuff[10000];
-
 DEF_CVAR(r_md5scale, int, "c", 0);
 
+
+// lerp values are rounded to this many steps, so that instances which
+// are almost in step can share their skinned vertices.
+#define MD5_LERP_STEPS  64
+
+// skinned poses not used for this many views are freed
+#define MD5_POSE_LIFETIME  8
+
+typedef struct md5_pose_key_s
+{
+	MD5umodel *umd5;
+
+	int last_anim, last_frame;
+	int cur_anim,  cur_frame;
+
+	int lerp;  // 0 .. MD5_LERP_STEPS
+
+	bool operator< (const struct md5_pose_key_s& other) const
+	{
+		if (umd5 != other.umd5) return umd5 < other.umd5;
+
+		if (cur_anim   != other.cur_anim)   return cur_anim   < other.cur_anim;
+		if (cur_frame  != other.cur_frame)  return cur_frame  < other.cur_frame;
+		if (lerp       != other.lerp)       return lerp       < other.lerp;
+		if (last_anim  != other.last_anim)  return last_anim  < other.last_anim;
+
+		return last_frame < other.last_frame;
+	}
+}
+md5_pose_key_t;
+
+typedef struct
+{
+	md5_pose_key_t key;
+
+	// resolved on the main thread, for the skinning job
+	MD5animation *last_anim;
+	MD5animation *cur_anim;
+
+	// skinned vertices of every mesh, one after the other
+	std::vector<basevert> verts;
+
+	int last_used;
+
+	// set once the vertices are ready to draw
+	std::atomic<bool> ready;
+}
+md5_pose_t;
+
+static std::map<md5_pose_key_t, md5_pose_t *> md5_poses;
+
+static job_group_c md5_skin_jobs;
+
+static int md5_view_count = 0;
+
+md5_skin_stats_t md5_skin_stats;
+
 short R_LoadMD5AnimationName(const char * lumpname)
 {
 	if (lumpname == NULL)
@@ -94,11 +156,12 @@ short R_LoadMD5AnimationName(const char * lumpname)
 	if (f == NULL)
 		return -1;
 	
+	int length = f->GetLength();
 	byte *animtext = f->LoadIntoMemory();
 	SYS_ASSERT(animtext);
 	
 	strcpy(animations[num_animations].lumpname, lumpname);
-	animations[num_animations].animation = md5_load_anim((char*)animtext);
+	animations[num_animations].animation = MD5_LoadCachedAnim(animtext, length);
 	
 	SYS_ASSERT(animations[num_animations].animation);
 	
@@ -115,9 +178,8 @@ MD5animation * R_GetMD5Animation(short animation_num)
 	return NULL;
 }
 
-static void LoadMD5Animation(MD5model *model, short animfile, int frame, MD5jointposebuff dst)
+static void LoadMD5Animation(MD5model *model, MD5animation *anim, int frame, MD5jointposebuff dst)
 {
-	MD5animation *anim = R_GetMD5Animation(animfile);
 	if (anim != NULL && 0 <= frame && frame < anim->framecnt )
 	{
 		md5_pose_load(anim, frame, dst);
@@ -131,10 +193,170 @@ static void LoadMD5Animation(MD5model *model, short animfile, int frame, MD5join
 }
 
 
-void md5_draw_unified_gl(MD5umodel *umd5, epi::mat4_c *jointmats,const epi::mat4_c& model_mat) 
+static void SkinPose(md5_pose_t *pose)
+{
+	MD5umodel *umd5 = pose->key.umd5;
+	MD5model  *md5  = &umd5->model;
+
+	epi::mat4_c posemats[MD5_MAX_JOINTS+1];
+
+	MD5jointposebuff jpcur, jplast;
+
+	LoadMD5Animation(md5, pose->cur_anim, pose->key.cur_frame, jpcur);
+
+	if (pose->key.lerp < MD5_LERP_STEPS)
+	{
+		LoadMD5Animation(md5, pose->last_anim, pose->key.last_frame, jplast);
+
+		md5_pose_lerp(jplast, jpcur, md5->jointcnt,
+				pose->key.lerp / (float)MD5_LERP_STEPS, jpcur);
+	}
+
+	md5_pose_to_matrix(jpcur, md5->jointcnt, posemats);
+
+	int total = 0;
+
+	for (int i = 0; i < md5->meshcnt; i++)
+		total += md5->meshes[i].vertcnt;
+
+	pose->verts.resize(total);
+
+	basevert *dest = pose->verts.data();
+
+	for (int i = 0; i < md5->meshcnt; i++)
+	{
+		MD5mesh *msh = md5->meshes + i;
+
+		//BUG: md5_transform_Verticies_sse() is not functional and will crash 3DGE.
+#ifndef __SSE2__  // Visual Studio Version: #ifdef __SSE2__
+		md5_transform_vertices(msh, posemats, dest); /// DOES NOT USE SSE
+#else
+		md5_transform_vertices_sse(msh, posemats, dest); /// uses _SSE for quicker transforms
+#endif
+		dest += msh->vertcnt;
+	}
+
+	pose->ready = true;
+}
+
+static void SkinPoseJob(void *data)
+{
+	SkinPose((md5_pose_t *) data);
+}
+
+//
+// Finds the skinned pose for the given frames, creating it when it
+// does not exist.  When 'queue' is true, a new pose is skinned by the
+// worker threads, otherwise it is skinned right now.
+//
+static md5_pose_t *LookupPose(MD5umodel *umd5, int last_anim, int last_frame,
+		int cur_anim, int cur_frame, float lerp, bool queue)
+{
+	md5_pose_key_t key;
+
+	key.umd5 = umd5;
+	key.cur_anim  = cur_anim;
+	key.cur_frame = cur_frame;
+	key.lerp = (int)(CLAMP(0, lerp, 1) * MD5_LERP_STEPS + 0.5f);
+
+	// an uninterpolated model only needs the current frame
+	if (last_anim < 0 || key.lerp >= MD5_LERP_STEPS)
+	{
+		key.lerp = MD5_LERP_STEPS;
+		last_anim = last_frame = -1;
+	}
+
+	key.last_anim  = last_anim;
+	key.last_frame = last_frame;
+
+	std::map<md5_pose_key_t, md5_pose_t *>::iterator it = md5_poses.find(key);
+
+	if (it != md5_poses.end())
+	{
+		md5_pose_t *pose = it->second;
+
+		pose->last_used = md5_view_count;
+		return pose;
+	}
+
+	md5_pose_t *pose = new md5_pose_t;
+
+	pose->key = key;
+	pose->last_anim = R_GetMD5Animation(last_anim);
+	pose->cur_anim  = R_GetMD5Animation(cur_anim);
+	pose->last_used = md5_view_count;
+	pose->ready = false;
+
+	md5_poses[key] = pose;
+
+	for (int i = 0; i < umd5->model.meshcnt; i++)
+		md5_skin_stats.skinned_verts += umd5->model.meshes[i].vertcnt;
+
+	md5_skin_stats.skinned++;
+
+	if (queue)
+		md5_skin_jobs.Add(SkinPoseJob, pose);
+	else
+		SkinPose(pose);
+
+	return pose;
+}
+
+//
+// MD5_BeginView
+//
+void MD5_BeginView(void)
+{
+	// nothing can still be skinning from the previous view, but make sure
+	md5_skin_jobs.Wait();
+
+	md5_view_count++;
+
+	md5_skin_stats.instances = 0;
+	md5_skin_stats.skinned   = 0;
+	md5_skin_stats.skinned_verts = 0;
+
+	std::map<md5_pose_key_t, md5_pose_t *>::iterator it = md5_poses.begin();
+
+	while (it != md5_poses.end())
+	{
+		md5_pose_t *pose = it->second;
+
+		if (md5_view_count - pose->last_used > MD5_POSE_LIFETIME)
+		{
+			delete pose;
+			md5_poses.erase(it++);
+		}
+		else
+			it++;
+	}
+}
+
+//
+// MD5_PrepareModel
+//
+void MD5_PrepareModel(modeldef_c *md, int last_anim, int last_frame,
+	int current_anim, int current_frame, float lerp)
+{
+	SYS_ASSERT(md->modeltype == MODEL_MD5_UNIFIED);
+
+	LookupPose(md->md5u, last_anim, last_frame, current_anim, current_frame, lerp, true);
+}
+
+//
+// MD5_FinishSkinning
+//
+void MD5_FinishSkinning(void)
+{
+	md5_skin_jobs.Wait();
+}
+
+static void md5_draw_unified_gl(MD5umodel *umd5, md5_pose_t *pose, const epi::mat4_c& model_mat)
 {
 	int i;
 	MD5model *md5 = &umd5->model;
+
+	basevert *vbuff = pose->verts.data();
 	
 	for(i = 0; i < md5->meshcnt; i++) 
 	{
@@ -150,15 +372,11 @@ void md5_draw_unified_gl(MD5umodel *umd5, epi::mat4_c *jointmats,const epi::mat4
 			I_Debugf("md5draw: No skin(s) found, subbing for DummySkin!\n");
 			skin_img = W_ImageForDummySkin();
 		}
-		//BUG: md5_transform_Verticies_sse() is not functional and will crash 3DGE.
-#ifndef __SSE2__  // Visual Studio Version: #ifdef __SSE2__
-		md5_transform_vertices(msh, jointmats, vbuff); /// DOES NOT USE SSE
-#else
-		md5_transform_vertices_sse(msh, jointmats, vbuff); /// uses _SSE for quicker transforms
-#endif
+
 		//Lighting render stage. This would be what we would change to render softer lighting on triangles!
-		render_md5_direct_triangle_lighting(msh, vbuff,model_mat);
-		
+		render_md5_direct_triangle_lighting(msh, vbuff, model_mat);
+
+		vbuff += msh->vertcnt;
 	}
 }
 
@@ -180,29 +398,21 @@ void MD5_RenderModel(modeldef_c *md, int last_anim, int last_frame,
 	//When rendering an uninterpolated model, pass -1 for last_anim and pass 1.0f for lerp
 	
 	SYS_ASSERT(md->modeltype == MODEL_MD5_UNIFIED);
-	
-	static epi::mat4_c posemats[MD5_MAX_JOINTS+1];
 
-	static MD5jointposebuff jpcur, jplast;
-	
-	//TODO get previous animfile and make sure previous frame was same model, in case model changes
-	//TODO check model and animation have same number of joints
-	if (mo->state->framerange == 0) 
-	{
-		if (last_anim >= 0)
-		LoadMD5Animation(&md->md5u->model, last_anim, last_frame, jplast);
-
-		LoadMD5Animation(&md->md5u->model, current_anim, current_frame, jpcur);
-	} 
-	else 
+	if (mo->state->framerange != 0)
 	{	//No frames and/or STATIC!
 		SYS_ASSERT(0);
 	}
-	
-	if (lerp < 1.0)
-	md5_pose_lerp(jplast,jpcur,md->md5u->model.jointcnt,lerp,jpcur);
 
-	md5_pose_to_matrix(jpcur, md->md5u->model.jointcnt, posemats);
+	//TODO get previous animfile and make sure previous frame was same model, in case model changes
+	//TODO check model and animation have same number of joints
+	md5_pose_t *pose = LookupPose(md->md5u, last_anim, last_frame,
+			current_anim, current_frame, lerp, false);
+
+	md5_skin_stats.instances++;
+
+	if (! pose->ready)
+		md5_skin_jobs.Wait();
 
 	epi::mat4_c model_mat;
 
@@ -258,12 +468,12 @@ void MD5_RenderModel(modeldef_c *md, int last_anim, int last_frame,
 	// This clamps to sector lighting.
 	RGL_SetAmbientLight(l,l,l);
 
-	P_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
+	R_DynamicLightIterator(mo->x - r, mo->y - r, mo->z,
 						   mo->x + r, mo->y + r, mo->z + mo->height,
 						   DLIT_CollectLights, mo);
 
 
-	md5_draw_unified_gl(md->md5u, posemats,model_mat);
+	md5_draw_unified_gl(md->md5u, pose, model_mat);
 
 	//I_Printf("MD5_Render: %f %f %f\n",mo->x,mo->y,mo->z);
 
@@ -35,6 +35,26 @@ void MD5_RenderModel(modeldef_c *md, int last_anim, int last_frame,
 	int current_anim, int current_frame, float lerp, epi::vec3_c pos,
 	epi::vec3_c scale,epi::vec3_c bias, mobj_t *mo);
 
+// Skinned vertices are shared by every instance in the same pose
+// (model, animations, frames and rounded lerp).  Poses found while
+// walking the BSP are skinned by the worker threads, and anything
+// else (mirrors, the weapon) is skinned when drawn.
+
+typedef struct
+{
+	int instances;      // models drawn
+	int skinned;        // poses which had to be skinned
+	int skinned_verts;  // ... and their total vertices
+}
+md5_skin_stats_t;
+
+extern md5_skin_stats_t md5_skin_stats;
+
+void MD5_BeginView(void);
+void MD5_PrepareModel(modeldef_c *md, int last_anim, int last_frame,
+	int current_anim, int current_frame, float lerp);
+void MD5_FinishSkinning(void);
+
 #endif /* __R_MD2_H__ */
 
 //--- editor settings ---
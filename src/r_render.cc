@@ -28,6 +28,7 @@
 
 #include <math.h>
 
+#include "am_map.h"
 #include "dm_data.h"
 #include "dm_defs.h"
 #include "dm_state.h"
@@ -41,8 +42,10 @@
 #include "r_modes.h"
 #include "r_gldefs.h"
 #include "r_colormap.h"
+#include "r_dlight.h"
 #include "r_effects.h"
 #include "r_image.h"
+#include "r_md5.h"
 #include "r_occlude.h"
 #include "r_shader.h"
 #include "r_sky.h"
@@ -1541,6 +1544,9 @@ static void DLIT_Wall(mobj_t *mo, void *dataptr)
 
 	SYS_ASSERT(mo->dlight.shader);
 
+	if (R_AddToLightBatch(mo->dlight.shader))
+		return;
+
 	int blending = (data->blending & ~BL_Alpha) | BL_Add;
 
 	mo->dlight.shader->WorldMix(GL_POLYGON, data->v_count, data->tex_id,
@@ -1556,6 +1562,9 @@ static void GLOWLIT_Wall(mobj_t *mo, void *dataptr)
 
 	SYS_ASSERT(mo->dlight.shader);
 
+	if (R_AddToLightBatch(mo->dlight.shader))
+		return;
+
 	int blending = (data->blending & ~BL_Alpha) | BL_Add;
 
 	mo->dlight.shader->WorldMix(GL_POLYGON, data->v_count, data->tex_id,
@@ -1580,12 +1589,15 @@ static void DLIT_Plane(mobj_t *mo, void *dataptr)
 			return;
 	}
 
-	// NOTE: distance already checked in P_DynamicLightIterator
+	// NOTE: distance already checked in R_DynamicLightIterator
 
 	R_ColorMapUpdate(NULL, cur_sub->sector->lightcolor, cur_sub->sector->desaturation); // FIXME: shouldn't this use colormaps properly too?
 
 	SYS_ASSERT(mo->dlight.shader);
 
+	if (R_AddToLightBatch(mo->dlight.shader))
+		return;
+
 	int blending = (data->blending & ~BL_Alpha) | BL_Add;
 
 	mo->dlight.shader->WorldMix(GL_POLYGON, data->v_count, data->tex_id,
@@ -1601,6 +1613,9 @@ static void GLOWLIT_Plane(mobj_t *mo, void *dataptr)
 
 	SYS_ASSERT(mo->dlight.shader);
 
+	if (R_AddToLightBatch(mo->dlight.shader))
+		return;
+
 	int blending = (data->blending & ~BL_Alpha) | BL_Add;
 
 	mo->dlight.shader->WorldMix(GL_POLYGON, data->v_count, data->tex_id,
@@ -1910,14 +1925,21 @@ if (surf->image->liquid_type == LIQ_Thick)
 		float bottom = MIN(lz1, rz1);
 		float top    = MAX(lz2, rz2);
 
-		P_DynamicLightIterator(v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], bottom,
-							   v_bbox[BOXRIGHT], v_bbox[BOXTOP],    top,
-							   DLIT_Wall, &data);
+		R_StartLightBatch();
+
+		R_SubsectorLightIterator(cur_sub,
+				                 v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], bottom,
+								 v_bbox[BOXRIGHT], v_bbox[BOXTOP],    top,
+								 DLIT_Wall, &data);
 
 		P_SectorGlowIterator(cur_seg->frontsector,
 				             v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], bottom,
 							 v_bbox[BOXRIGHT], v_bbox[BOXTOP],    top,
 							 GLOWLIT_Wall, &data);
+
+		R_FinishLightBatch(GL_POLYGON, data.v_count, data.tex_id,
+				data.trans, &data.pass, (data.blending & ~BL_Alpha) | BL_Add,
+				data.mid_masked, &data, WallCoordFunc);
 	}
 	swirl_pass = 0;
 }
@@ -2423,7 +2445,7 @@ static void DLIT_Flood(mobj_t *mo, void *dataptr)
 			return;
 	}
 
-	// NOTE: distance already checked in P_DynamicLightIterator
+	// NOTE: distance already checked in R_DynamicLightIterator
 
 	SYS_ASSERT(mo->dlight.shader);
 
@@ -2624,7 +2646,7 @@ static void EmulateFloodPlane(const drawfloor_t *dfloor,
 
 //		I_Debugf("Flood BBox size: %1.0f x %1.0f\n", lx2-lx1, ly2-ly1);
 
-		P_DynamicLightIterator(lx1,ly1,data.plane_h, lx2,ly2,data.plane_h,
+		R_DynamicLightIterator(lx1,ly1,data.plane_h, lx2,ly2,data.plane_h,
 				               DLIT_Flood, &data);
 	}
 }
@@ -2641,7 +2663,11 @@ static void RGL_DrawSeg(drawfloor_t *dfloor, seg_t *seg)
 	SYS_ASSERT(!seg->miniseg && seg->linedef);
 
 	// mark the segment on the automap
-	seg->linedef->flags |= MLF_Mapped;
+	if (! (seg->linedef->flags & MLF_Mapped))
+	{
+		seg->linedef->flags |= MLF_Mapped;
+		am_mapped_count++;
+	}
 
 	frontsector = seg->front_sub->sector;
 	backsector  = NULL;
@@ -3431,14 +3457,21 @@ if (surf->image->liquid_type > LIQ_None && swirling_flats == SWIRL_PARALLAX) //
 	
 	if (use_dlights && ren_extralight < 250)
 	{
-		P_DynamicLightIterator(v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], h,
-				               v_bbox[BOXRIGHT], v_bbox[BOXTOP],    h,
-							   DLIT_Plane, &data);
+		R_StartLightBatch();
+
+		R_SubsectorLightIterator(cur_sub,
+				                 v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], h,
+				                 v_bbox[BOXRIGHT], v_bbox[BOXTOP],    h,
+								 DLIT_Plane, &data);
 
 		P_SectorGlowIterator(cur_sub->sector,
 				             v_bbox[BOXLEFT],  v_bbox[BOXBOTTOM], h,
 				             v_bbox[BOXRIGHT], v_bbox[BOXTOP],    h,
 							 GLOWLIT_Plane, &data);
+
+		R_FinishLightBatch(GL_POLYGON, data.v_count, data.tex_id,
+				data.trans, &data.pass, (data.blending & ~BL_Alpha) | BL_Add,
+				false /* masked */, &data, PlaneCoordFunc);
 	}
 	swirl_pass = 0;
 
@@ -3827,7 +3860,11 @@ static void DrawPortalPolygon(drawmirror_c *mir)
 static void RGL_DrawMirror(drawmirror_c *mir)
 {
 	// mark the segment on the automap
-	mir->seg->linedef->flags |= MLF_Mapped;
+	if (! (mir->seg->linedef->flags & MLF_Mapped))
+	{
+		mir->seg->linedef->flags |= MLF_Mapped;
+		am_mapped_count++;
+	}
 
 	RGL_FinishUnits();
 
@@ -4074,6 +4111,10 @@ static void RGL_RenderTrueBSP(void)
 
 	RGL_SetupMatrices3D();
 
+	R_CullDynamicLights();
+
+	MD5_BeginView();
+
 	glClear(GL_DEPTH_BUFFER_BIT);
 	glEnable(GL_DEPTH_TEST);
 
@@ -4087,6 +4128,8 @@ static void RGL_RenderTrueBSP(void)
 
 	RGL_FinishSky();
 
+	MD5_FinishSkinning();
+
 	RGL_DrawSubList(drawsubs);
 
 	DoWeaponModel();
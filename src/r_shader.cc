@@ -27,6 +27,7 @@
 #include "r_defs.h"
 #include "r_gldefs.h"
 #include "r_image.h"   // W_ImageCache
+#include "r_dlight.h"
 #include "r_misc.h"
 #include "r_shader.h"
 #include "r_state.h"
@@ -49,8 +50,13 @@ public:
 
 	rgbcol_t curve[LIM_CURVE_SIZE];
 
+	// the standard DLIGHT_EXP shape, which the light pass shader
+	// computes itself.  Other shapes need WorldMix().
+	bool std_shape;
+
 public:
-	light_image_c(const char * _name, const image_c *_img) : name(_name), image(_img)
+	light_image_c(const char * _name, const image_c *_img) :
+		name(_name), image(_img), std_shape(false)
 	{ }
 
 	~light_image_c()
@@ -133,6 +139,8 @@ static light_image_c *GetLightImage(const mobjtype_c *info, int DL)
 
 		light_image_c *lim = new light_image_c(shape, image);
 
+		lim->std_shape = (DDF_CompareName(shape, "DLIGHT_EXP") == 0);
+
 		if (true) //!!! (DDF_CompareName(shape, "DLIGHT_EXP") == 0)
 		{
 			lim->MakeStdCurve();
@@ -382,9 +390,56 @@ public:
 			RGL_EndUnit(num_vert);
 
 			(*pass_var) += 1;
+
+			dlight_stats.mix_draws++;
+			dlight_stats.mix_verts += num_vert;
 		}
 	}
 
+	virtual int UnitLights(unit_light_t *lights)
+	{
+		float mx = mo->x;
+		float my = mo->y;
+		float mz = MO_MIDZ(mo);
+
+		MIR_Coordinate(mx, my);
+		MIR_Height(mz);
+
+		float L = mo->state->bright / 255.0;
+
+		int count = 0;
+
+		for (int DL = 0; DL < 2; DL++)
+		{
+			if (detail_level == 0 && DL > 0)
+				continue;
+
+			if (WhatType(DL) == DLITE_None)
+				break;
+
+			if (! lim[DL]->std_shape)
+				return -1;
+
+			rgbcol_t col = WhatColor(DL);
+
+			unit_light_t *U = lights + count++;
+
+			U->pos.x = mx;
+			U->pos.y = my;
+			U->pos.z = mz;
+
+			U->radius = WhatRadius(DL);
+
+			U->r = L * RGB_RED(col) / 255.0;
+			U->g = L * RGB_GRN(col) / 255.0;
+			U->b = L * RGB_BLU(col) / 255.0;
+
+			U->glow = false;
+			U->modulate = (WhatType(DL) != DLITE_Add);
+		}
+
+		return count;
+	}
 };
 
 abstract_shader_c *MakeDLightShader(mobj_t *mo)
@@ -579,7 +634,50 @@ public:
 			RGL_EndUnit(num_vert);
 
 			(*pass_var) += 1;
+
+			dlight_stats.mix_draws++;
+			dlight_stats.mix_verts += num_vert;
+		}
+	}
+
+	virtual int UnitLights(unit_light_t *lights)
+	{
+		const sector_t *sec = mo->subsector->sector;
+
+		float L = mo->state->bright / 255.0;
+
+		int count = 0;
+
+		for (int DL = 0; DL < 2; DL++)
+		{
+			if (detail_level == 0 && DL > 0)
+				continue;
+
+			if (WhatType(DL) == DLITE_None)
+				break;
+
+			if (! lim[DL]->std_shape)
+				return -1;
+
+			rgbcol_t col = WhatColor(DL);
+
+			unit_light_t *U = lights + count++;
+
+			U->pos.x = 0;
+			U->pos.y = 0;
+			U->pos.z = (mo->info->glow_type == GLOW_Floor) ? sec->f_h : sec->c_h;
+
+			U->radius = WhatRadius(DL);
+
+			U->r = L * RGB_RED(col) / 255.0;
+			U->g = L * RGB_GRN(col) / 255.0;
+			U->b = L * RGB_BLU(col) / 255.0;
+
+			U->glow = true;
+			U->modulate = (WhatType(DL) != DLITE_Add);
 		}
+
+		return count;
 	}
 };
 
@@ -590,6 +688,89 @@ abstract_shader_c *MakePlaneGlow(mobj_t *mo)
 
 
 
+//----------------------------------------------------------------------------
+//  SINGLE PASS LIGHTING
+//----------------------------------------------------------------------------
+
+#define MAX_BATCH_LIGHTS  32
+
+static unit_light_t batch_lights[MAX_BATCH_LIGHTS];
+static int num_batch_lights;
+
+
+void R_StartLightBatch(void)
+{
+	num_batch_lights = 0;
+}
+
+bool R_AddToLightBatch(abstract_shader_c *shader)
+{
+	// room for the two lights of a thing?
+	if (num_batch_lights + 2 > MAX_BATCH_LIGHTS)
+		return false;
+
+	if (! RGL_LightPassEnabled())
+		return false;
+
+	int count = shader->UnitLights(batch_lights + num_batch_lights);
+
+	if (count < 0)
+		return false;
+
+	num_batch_lights += count;
+	return true;
+}
+
+//
+// R_FinishLightBatch
+//
+// Draws the polygon with the collected lights.  Unlike WorldMix(),
+// the texture is always bound: the shader works out per fragment
+// what the fixed pipeline did with one pass per light.
+//
+void R_FinishLightBatch(GLuint shape, int num_vert,
+		GLuint tex, float alpha, int *pass_var, int blending,
+		bool masked, void *data, shader_coord_func_t func)
+{
+	if (masked)
+		blending |= BL_Masked;
+
+	for (int first = 0; first < num_batch_lights; first += MAX_UNIT_LIGHTS)
+	{
+		int count = MIN(MAX_UNIT_LIGHTS, num_batch_lights - first);
+
+		local_gl_vert_t *glvert = RGL_BeginUnit(shape, num_vert,
+					GL_MODULATE, tex, ENV_NONE, 0, *pass_var, blending);
+
+		for (int v_idx=0; v_idx < num_vert; v_idx++)
+		{
+			local_gl_vert_t *dest = glvert + v_idx;
+
+			vec3_t lit_pos;
+
+			(*func)(data, v_idx, &dest->pos, dest->rgba,
+					&dest->texc[0], &dest->normal, &lit_pos);
+
+			dest->rgba[0] = 1.0;
+			dest->rgba[1] = 1.0;
+			dest->rgba[2] = 1.0;
+			dest->rgba[3] = alpha;
+		}
+
+		RGL_SetUnitLights(batch_lights + first, count);
+		RGL_EndUnit(num_vert);
+
+		(*pass_var) += 1;
+
+		dlight_stats.pass_draws++;
+		dlight_stats.pass_verts += num_vert;
+	}
+
+	num_batch_lights = 0;
+}
+
+
+
 //----------------------------------------------------------------------------
 //  WALL GLOWS
 //----------------------------------------------------------------------------
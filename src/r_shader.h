@@ -103,11 +103,27 @@ public:
 	virtual void WorldMix(GLuint shape, int num_vert,
 		GLuint tex, float alpha, int *pass_var, int blending,
 		bool masked, void *data, shader_coord_func_t func) = 0;
+
+	// describes the lights for the single pass path (see r_units.h).
+	// Returns how many were stored (at most two), or -1 when only
+	// WorldMix() can draw this shader.
+	virtual int UnitLights(struct unit_light_s *lights) { return -1; }
 };
 
 
 /* FUNCTIONS */
 
+// Single pass lighting of world polygons.  While the lights touching
+// a polygon are visited, R_AddToLightBatch() collects them (returning
+// false when WorldMix must be used instead), then R_FinishLightBatch()
+// draws the polygon once for every MAX_UNIT_LIGHTS of them.
+
+void R_StartLightBatch(void);
+bool R_AddToLightBatch(abstract_shader_c *shader);
+void R_FinishLightBatch(GLuint shape, int num_vert,
+		GLuint tex, float alpha, int *pass_var, int blending,
+		bool masked, void *data, shader_coord_func_t func);
+
 
 #endif /* __R_SHADER_H__ */
 
@@ -28,8 +28,16 @@
 #include "system/i_defs.h"
 #include "system/i_defs_gl.h"
 
+#include "system/i_thread.h"
+
+#include "../epi/endianess.h"
+#include "../epi/file.h"
+#include "../epi/filesystem.h"
+#include "../epi/math_md5.h"
+#include "../epi/path.h"
 #include "../epi/str_format.h"
 
+#include "dm_state.h"
 #include "m_misc.h"
 #include "r_shaderprogram.h"
 #include "w_wad.h"
@@ -37,6 +45,20 @@
 
 //#define DEBUG_GLSHADER_TEXTDUMP
 
+// keep linked program binaries in the cache directory?
+DEF_CVAR(r_shadercache, int, "c", 1);
+
+#define PRG_MAGIC  "EDGEPRG1"
+
+typedef struct
+{
+	char magic[8];
+
+	u32_t format;
+	s32_t length;
+}
+program_cache_header_t;
+
 namespace
 {
 	void I_FatalError(const char *, ...) { }
@@ -110,14 +132,27 @@ void FShaderProgram::Compile(ShaderType type, const char *lumpname, const char *
 }
 
 void FShaderProgram::Compile(ShaderType type, const char *name, const std::string &code, const char *defines, int maxGlslVersion)
+{
+	mSources[type] = PatchShader(type, code, defines, maxGlslVersion);
+	mNames[type] = name;
+}
+
+//==========================================================================
+//
+// Compiles the kept source of a shader and attaches it to the program
+//
+//==========================================================================
+
+void FShaderProgram::CompileShader(ShaderType type)
 {
 	CreateShader(type);
 
 	const auto &handle = mShaders[type];
+	const char *name = mNames[type].c_str();
 
 	//FGLDebug::LabelObject(GL_SHADER, handle, name);
 
-	std::string patchedCode = PatchShader(type, code, defines, maxGlslVersion);
+	const std::string &patchedCode = mSources[type];
 	int lengths[1] = { (int)patchedCode.size() };
 	const char *sources[1] = { patchedCode.c_str() };
 	glShaderSource(handle, 1, sources, lengths);
@@ -154,7 +189,7 @@ void FShaderProgram::Compile(ShaderType type, const char *name, const std::strin
 
 void FShaderProgram::SetFragDataLocation(int index, const char *name)
 {
-	glBindFragDataLocation(mProgram, index, name);
+	mFragDataLocations.push_back(std::make_pair(index, std::string(name)));
 }
 
 //==========================================================================
@@ -165,6 +200,35 @@ void FShaderProgram::SetFragDataLocation(int index, const char *name)
 
 void FShaderProgram::Link(const char *name)
 {
+	std::string cache_name;
+
+	if (r_shadercache > 0 && ogl_ext_ARB_get_program_binary == ogl_LOAD_SUCCEEDED)
+	{
+		cache_name = BinaryCacheName();
+
+		if (LoadBinary(cache_name))
+		{
+			I_Debugf("OpenGL: Loaded GLSL program '%s' from %s\n", name, cache_name.c_str());
+			FreeSources();
+			return;
+		}
+	}
+
+	for (int i = 0; i < NumShaderTypes; i++)
+	{
+		if (! mSources[i].empty())
+			CompileShader((ShaderType)i);
+	}
+
+	for (size_t i = 0; i < mFragDataLocations.size(); i++)
+		glBindFragDataLocation(mProgram, mFragDataLocations[i].first, mFragDataLocations[i].second.c_str());
+
+	for (size_t i = 0; i < mAttribLocations.size(); i++)
+		glBindAttribLocation(mProgram, mAttribLocations[i].first, mAttribLocations[i].second.c_str());
+
+	if (! cache_name.empty())
+		glProgramParameteri(mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	//FGLDebug::LabelObject(GL_PROGRAM, mProgram, name);
 	glLinkProgram(mProgram);
 
@@ -176,6 +240,199 @@ void FShaderProgram::Link(const char *name)
 	}
 	else
 		I_Debugf("OpenGL: Linking GLSL Shader ''%s':\n%s\n", name, GetProgramInfoLog(mProgram).c_str());
+
+	if (! cache_name.empty())
+		SaveBinary(cache_name);
+
+	FreeSources();
+}
+
+//==========================================================================
+//
+// Frees the shader sources, which are not needed after linking
+//
+//==========================================================================
+
+void FShaderProgram::FreeSources()
+{
+	for (int i = 0; i < NumShaderTypes; i++)
+	{
+		std::string().swap(mSources[i]);
+		std::string().swap(mNames[i]);
+	}
+}
+
+//==========================================================================
+//
+// Works out the name of the cache file for this program.  The key
+// covers the patched sources, the bindings and the driver, so a new
+// driver (or any change to a shader) simply misses the cache.
+//
+//==========================================================================
+
+std::string FShaderProgram::BinaryCacheName()
+{
+	static std::string driver;
+
+	if (driver.empty())
+	{
+		const char *vendor   = (const char *)glGetString(GL_VENDOR);
+		const char *renderer = (const char *)glGetString(GL_RENDERER);
+		const char *version  = (const char *)glGetString(GL_VERSION);
+
+		driver = epi::STR_Format("%s|%s|%s", vendor ? vendor : "?",
+			renderer ? renderer : "?", version ? version : "?");
+	}
+
+	std::string key = PRG_MAGIC;
+
+	key += driver;
+
+	for (int i = 0; i < NumShaderTypes; i++)
+	{
+		key += '\0';
+		key += mSources[i];
+	}
+
+	for (size_t i = 0; i < mFragDataLocations.size(); i++)
+		key += epi::STR_Format("|out %d %s", mFragDataLocations[i].first, mFragDataLocations[i].second.c_str());
+
+	for (size_t i = 0; i < mAttribLocations.size(); i++)
+		key += epi::STR_Format("|in %d %s", mAttribLocations[i].first, mAttribLocations[i].second.c_str());
+
+	epi::md5hash_c hash((const byte *)key.data(), (unsigned int)key.size());
+
+	std::string base = "glprog-";
+
+	for (int i = 0; i < 16; i++)
+		base += epi::STR_Format("%02x", hash.hash[i]);
+
+	base += ".bin";
+
+	return epi::PATH_Join(cache_dir.c_str(), base.c_str());
+}
+
+//==========================================================================
+//
+// Tries to create the program from a cached binary.  Any kind of
+// mismatch, or the driver refusing the binary, returns false and
+// the program gets compiled as usual.
+//
+//==========================================================================
+
+bool FShaderProgram::LoadBinary(const std::string &filename)
+{
+	epi::file_c *fp = epi::FS_Open(filename.c_str(), epi::file_c::ACCESS_READ | epi::file_c::ACCESS_BINARY);
+
+	if (! fp)
+		return false;
+
+	program_cache_header_t hdr;
+
+	bool ok = (fp->Read(&hdr, sizeof(hdr)) == sizeof(hdr)) &&
+	          (memcmp(hdr.magic, PRG_MAGIC, 8) == 0);
+
+	int length = EPI_LE_S32(hdr.length);
+
+	if (ok && (length <= 0 || (int)sizeof(hdr) + length != fp->GetLength()))
+		ok = false;
+
+	std::vector<byte> binary;
+
+	if (ok)
+	{
+		binary.resize(length);
+
+		if (fp->Read(binary.data(), length) != (unsigned int)length)
+			ok = false;
+	}
+
+	delete fp;
+
+	if (! ok)
+		return false;
+
+	mProgram = glCreateProgram();
+
+	glProgramBinary(mProgram, EPI_LE_U32(hdr.format), binary.data(), length);
+
+	GLint status = 0;
+	glGetProgramiv(mProgram, GL_LINK_STATUS, &status);
+
+	if (status == GL_FALSE)
+	{
+		I_Debugf("OpenGL: Cached program %s was rejected\n", filename.c_str());
+
+		glDeleteProgram(mProgram);
+		mProgram = 0;
+
+		return false;
+	}
+
+	return true;
+}
+
+
+typedef struct
+{
+	std::string filename;
+
+	// cache header followed by the program binary
+	std::vector<byte> data;
+}
+program_save_t;
+
+static void SaveBinaryJob(void *data)
+{
+	program_save_t *sv = (program_save_t *) data;
+
+	M_SaveCacheFile(sv->filename, sv->data.data(), (int)sv->data.size());
+
+	delete sv;
+}
+
+//==========================================================================
+//
+// Reads back the binary of a freshly linked program, and writes it to
+// the cache directory on a worker thread.
+//
+//==========================================================================
+
+void FShaderProgram::SaveBinary(const std::string &filename)
+{
+	GLint length = 0;
+	glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+		return;
+
+	program_save_t *sv = new program_save_t;
+
+	sv->filename = filename;
+	sv->data.resize(sizeof(program_cache_header_t) + length);
+
+	GLenum format = 0;
+	glGetProgramBinary(mProgram, length, &length, &format, sv->data.data() + sizeof(program_cache_header_t));
+
+	if (length <= 0)
+	{
+		delete sv;
+		return;
+	}
+
+	sv->data.resize(sizeof(program_cache_header_t) + length);
+
+	program_cache_header_t hdr;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, PRG_MAGIC, 8);
+
+	hdr.format = EPI_LE_U32((u32_t)format);
+	hdr.length = EPI_LE_S32((s32_t)length);
+
+	memcpy(sv->data.data(), &hdr, sizeof(hdr));
+
+	I_QueueJob(SaveBinaryJob, sv);
 }
 
 //==========================================================================
@@ -186,7 +443,11 @@ void FShaderProgram::Link(const char *name)
 
 void FShaderProgram::SetAttribLocation(int index, const char *name)
 {
-	glBindAttribLocation(mProgram, index, name);
+	// after linking, this only has an effect if the program is linked again
+	if (mProgram != 0)
+		glBindAttribLocation(mProgram, index, name);
+	else
+		mAttribLocations.push_back(std::make_pair(index, std::string(name)));
 }
 
 //==========================================================================
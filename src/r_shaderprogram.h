@@ -2,6 +2,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 class FShaderProgram
 {
@@ -33,11 +34,26 @@ private:
 	static std::string PatchShader(ShaderType type, const std::string &code, const char *defines, int maxGlslVersion);
 
 	void CreateShader(ShaderType type);
+	void CompileShader(ShaderType type);
 	std::string GetShaderInfoLog(GLuint handle);
 	std::string GetProgramInfoLog(GLuint handle);
 
+	std::string BinaryCacheName();
+	bool LoadBinary(const std::string &filename);
+	void SaveBinary(const std::string &filename);
+	void FreeSources();
+
 	GLuint mProgram = 0;
 	GLuint mShaders[NumShaderTypes];
+
+	// the patched sources are kept until Link(), which may be able to
+	// load a binary of the program instead of compiling them.  They
+	// are freed once the program is made.
+	std::string mSources[NumShaderTypes];
+	std::string mNames[NumShaderTypes];
+
+	std::vector<std::pair<int, std::string>> mFragDataLocations;
+	std::vector<std::pair<int, std::string>> mAttribLocations;
 };
 
 class FUniform1i
@@ -21,10 +21,17 @@
 
 #include <math.h>
 
+#include "../epi/endianess.h"
+#include "../epi/file.h"
+#include "../epi/filesystem.h"
 #include "../epi/image_data.h"
+#include "../epi/math_crc.h"
+#include "../epi/path.h"
+#include "../epi/str_format.h"
 
 #include "dm_state.h"
 #include "m_math.h"
+#include "m_misc.h"
 #include "r_misc.h"
 #include "w_flat.h"
 #include "r_sky.h"
@@ -38,6 +45,10 @@
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include "system/i_thread.h"
+
+#include <vector>
+
 #define DEBUG  0
 
 
@@ -218,26 +229,73 @@ static fake_skybox_t fake_box[2] =
 };
 
 
-static void DeleteSkyTexGroup(int SK)
+//
+// Pseudo sky boxes are kept in a small cache, keyed by the sky image,
+// the colourmap and the face size, so that switching colourmaps (e.g.
+// the invulnerability effect) is just a texture swap.  The generated
+// faces are also saved in the cache directory.
+//
+#define SKY_CACHE_MAX  4
+
+typedef struct
+{
+	const image_c *sky;
+	const colourmap_c *colmap;
+
+	int face_size;
+
+	// textures for each face (narrow skies share some)
+	GLuint tex[6];
+
+	int last_used;
+}
+sky_cache_entry_t;
+
+static std::vector<sky_cache_entry_t> sky_cache;
+
+static int sky_cache_time = 0;
+
+
+static void FreeSkyCacheEntry(sky_cache_entry_t& ent)
 {
 	for (int i = 0; i < 6; i++)
 	{
-		if (fake_box[SK].tex[i] != 0)
-		{
-			glDeleteTextures(1, &fake_box[SK].tex[i]);
-			fake_box[SK].tex[i] = 0;
-		}
+		if (ent.tex[i] == 0)
+			continue;
+
+		GLuint id = ent.tex[i];
+
+		glDeleteTextures(1, &id);
+
+		// clear shared copies too
+		for (int k = i; k < 6; k++)
+			if (ent.tex[k] == id)
+				ent.tex[k] = 0;
+	}
+
+	// make sure no sky box keeps using these textures
+	for (int SK = 0; SK < 2; SK++)
+	{
+		if (fake_box[SK].base_sky == ent.sky && fake_box[SK].fx_colmap == ent.colmap)
+			fake_box[SK].base_sky = NULL;
 	}
 }
 
 void DeleteSkyTextures(void)
 {
+	for (size_t i = 0; i < sky_cache.size(); i++)
+		FreeSkyCacheEntry(sky_cache[i]);
+
+	sky_cache.clear();
+
 	for (int SK = 0; SK < 2; SK++)
 	{
 		fake_box[SK].base_sky  = NULL;
 		fake_box[SK].fx_colmap = NULL;
 
-		DeleteSkyTexGroup(SK);
+		// textures of custom sky boxes belong to the image system
+		for (int i = 0; i < 6; i++)
+			fake_box[SK].tex[i] = 0;
 	}
 }
 
@@ -707,21 +765,23 @@ static void CalcSkyCoord(int px, int py, int pw, int ph, int face,
 }
 
 
-static void BlurCentre(epi::image_data_c& img)
+typedef struct
 {
-	// Blurs the center of the image (the top face of the
-	// pseudo sky box).  The amount of blur is different at
-	// different places: from none at all at the edges upto
-	// maximum blur in the middle.
+	epi::image_data_c *img;
 
-	SYS_ASSERT(img.bpp == 3);
+	// copy to work from (as we cannot blur in-place)
+	const epi::image_data_c *orig;
+}
+sky_blur_t;
 
-	// create a copy to work from (as we cannot blur in-place)
-	epi::image_data_c orig(img.width, img.height, 3);
+static void BlurCentreRow(int index, void *data)
+{
+	sky_blur_t *bl = (sky_blur_t *) data;
 
-	memcpy(orig.pixels, img.pixels, orig.width*orig.height*3);
+	epi::image_data_c& img = *bl->img;
+
+	int y = 1 + img.height/4 + index;
 
-	for (int y = 1+img.height/4; y < img.height*3/4; y++)
 	for (int x = 1+img.width /4; x < img.width *3/4; x++)
 	{
 		int x_pos = 31 - ABS(x - img.width /2) * 127 / img.width;
@@ -745,7 +805,7 @@ static void BlurCentre(epi::image_data_c& img)
 		for (int dy = -d_size; dy <= +d_size; dy++)
 		for (int dx = -d_size; dx <= +d_size; dx++)
 		{
-			u8_t *src = orig.PixelAt(x+dx, y+dy);
+			const u8_t *src = bl->orig->PixelAt(x+dx, y+dy);
 
 			int qty = ( (ABS(dx) < d_size) ? 16 : (size & 15) ) *
 			          ( (ABS(dy) < d_size) ? 16 : (size & 15) );
@@ -767,151 +827,412 @@ static void BlurCentre(epi::image_data_c& img)
 	}
 }
 
-static GLuint BuildFace(const epi::image_data_c *sky, int face,
-				  	    fake_skybox_t *info, const byte *what_palette)
-			
+static void BlurCentre(epi::image_data_c& img)
+{
+	// Blurs the center of the image (the top face of the
+	// pseudo sky box).  The amount of blur is different at
+	// different places: from none at all at the edges upto
+	// maximum blur in the middle.
+
+	SYS_ASSERT(img.bpp == 3);
+
+	epi::image_data_c orig(img.width, img.height, 3);
+
+	memcpy(orig.pixels, img.pixels, orig.width*orig.height*3);
+
+	sky_blur_t bl;
+
+	bl.img  = &img;
+	bl.orig = &orig;
+
+	// rows are independent, so do them in parallel
+	int rows = img.height*3/4 - (1 + img.height/4);
+
+	I_ParallelFor(rows, BlurCentreRow, &bl);
+}
+
+
+//
+// The projection from a face pixel to sky image coordinates only
+// depends on the face size and whether the sky is narrow, so it is
+// worked out once and shared by every sky and colourmap.
+//
+static std::vector<float> sky_proj;  // (tx, ty) pairs, face by face
+
+static int  sky_proj_size   = 0;
+static bool sky_proj_narrow = false;
+
+static void CalcSkyProjRow(int index, void *data)
 {
-	int img_size = info->face_size;
+	int size = sky_proj_size;
+
+	int face = index / size;
+	int y    = index % size;
 
-	epi::image_data_c img(img_size, img_size, 3);
+	float *out = &sky_proj[(face * size + y) * size * 2];
+
+	for (int x = 0; x < size; x++, out += 2)
+		CalcSkyCoord(x, y, size, size, face, sky_proj_narrow, out, out + 1);
+}
+
+static void PrepareSkyProjection(int size, bool narrow)
+{
+	if (sky_proj_size == size && sky_proj_narrow == narrow)
+		return;
+
+	sky_proj_size   = size;
+	sky_proj_narrow = narrow;
+
+	sky_proj.resize(6 * size * size * 2);
+
+	I_ParallelFor(6 * size, CalcSkyProjRow, NULL);
+}
+
+
+typedef struct
+{
+	// sky image converted to RGB
+	const byte *rgb;
 
+	int sky_w, sky_h;
+
+	int size;
+
+	// the faces to build
+	int num_faces;
+	int face_list[6];
+
+	epi::image_data_c *faces[6];
+}
+sky_build_t;
+
+static void SampleSkyRow(int index, void *data)
+{
+	sky_build_t *sb = (sky_build_t *) data;
+
+	int size = sb->size;
+
+	int face = sb->face_list[index / size];
+	int y    = index % size;
+
+	const float *proj = &sky_proj[(face * size + y) * size * 2];
+
+	const byte *src = sb->rgb;
+
+	int sky_w = sb->sky_w;
+	int sky_h = sb->sky_h;
+
+	u8_t *dest = sb->faces[face]->PixelAt(0, y);
+
+	for (int x = 0; x < size; x++, dest += 3, proj += 2)
+	{
+		// Bilinear Filtering
+
+		int TX = (int)(proj[0] * sky_w * 16);
+		int TY = (int)(proj[1] * sky_h * 16);
+
+		// negative values shouldn't occur, but just in case...
+		TX = (TX + sky_w * 64) % (sky_w * 16);
+		TY = (TY + sky_h * 64) % (sky_h * 16);
+
+		int FX = TX % 16; TX >>= 4;
+		int FY = TY % 16; TY >>= 4;
+
+		int TX2 = (TX + 1) % sky_w;
+		int TY2 = (TY < sky_h-1) ? (TY+1) : TY;
+
+		const byte *A = src + (TY  * sky_w + TX ) * 3;
+		const byte *B = src + (TY  * sky_w + TX2) * 3;
+		const byte *C = src + (TY2 * sky_w + TX ) * 3;
+		const byte *D = src + (TY2 * sky_w + TX2) * 3;
+
+		int wA = (FX^15) * (FY^15);
+		int wB = (FX   ) * (FY^15);
+		int wC = (FX^15) * (FY   );
+		int wD = (FX   ) * (FY   );
+
+		for (int c = 0; c < 3; c++)
+			dest[c] = (A[c] * wA + B[c] * wB + C[c] * wC + D[c] * wD) / 225;
+	}
+}
+
+//
+// Converts the sky image to plain RGB, so the face builder only has
+// one kind of pixel to deal with.
+//
+static byte *SkyToRGB(const epi::image_data_c *sky, const byte *what_palette)
+{
+	int total = sky->width * sky->height;
 
-	bool narrow = SkyIsNarrow(info->base_sky);
+	byte *rgb = new byte[total * 3];
 
 	const byte *src = sky->pixels;
 
-	int sky_w = sky->width;
-	int sky_h = sky->height;
+	for (int i = 0; i < total; i++)
+	{
+		switch (sky->bpp)
+		{
+			case 1:
+				rgb[i*3 + 0] = PIXEL_RED(src[i]);
+				rgb[i*3 + 1] = PIXEL_GRN(src[i]);
+				rgb[i*3 + 2] = PIXEL_BLU(src[i]);
+				break;
+
+			case 3:
+			case 4:
+				rgb[i*3 + 0] = src[i * sky->bpp + 0];
+				rgb[i*3 + 1] = src[i * sky->bpp + 1];
+				rgb[i*3 + 2] = src[i * sky->bpp + 2];
+				break;
+
+			default:
+				rgb[i*3 + 0] = rgb[i*3 + 1] = rgb[i*3 + 2] = 0;
+				break;
+		}
+	}
+
+	return rgb;
+}
+
+
+#define SKY_CACHE_MAGIC  "EDGESKY1"
 
-	for (int y=0; y < img_size; y++)
+static std::string SkyCacheFilename(u32_t crc, int size)
+{
+	std::string base = epi::STR_Format("sky-%08X-%d.dat", crc, size);
+
+	return epi::PATH_Join(cache_dir.c_str(), base.c_str());
+}
+
+static bool LoadSkyCacheFile(const std::string& fn, int size, epi::image_data_c **faces)
+{
+	epi::file_c *fp = epi::FS_Open(fn.c_str(), epi::file_c::ACCESS_READ | epi::file_c::ACCESS_BINARY);
+
+	if (! fp)
+		return false;
+
+	int face_bytes = size * size * 3;
+
+	char magic[8];
+	s32_t file_size = 0;
+
+	bool ok = (fp->GetLength() == 8 + 4 + 6 * face_bytes) &&
+	          (fp->Read(magic, 8) == 8) &&
+	          (memcmp(magic, SKY_CACHE_MAGIC, 8) == 0) &&
+	          (fp->Read(&file_size, 4) == 4) &&
+	          (EPI_LE_S32(file_size) == size);
+
+	for (int i = 0; ok && i < 6; i++)
 	{
-		u8_t *dest = img.PixelAt(0, y);
+		faces[i] = new epi::image_data_c(size, size, 3);
+
+		if (fp->Read(faces[i]->pixels, face_bytes) != (unsigned int)face_bytes)
+			ok = false;
+	}
+
+	delete fp;
 
-		for (int x=0; x < img_size; x++, dest += 3)
+	if (! ok)
+	{
+		I_Debugf("Sky cache file %s is bad, ignoring it.\n", fn.c_str());
+
+		for (int i = 0; i < 6; i++)
 		{
-			float tx, ty;
+			delete faces[i];
+			faces[i] = NULL;
+		}
+	}
 
-			CalcSkyCoord(x, y, img_size, img_size, face, narrow, &tx, &ty);
+	return ok;
+}
 
-			// Bilinear Filtering
+typedef struct
+{
+	std::string filename;
 
-			int TX = (int)(tx * sky_w * 16);
-			int TY = (int)(ty * sky_h * 16);
+	int size;
 
-			// negative values shouldn't occur, but just in case...
-			TX = (TX + sky_w * 64) % (sky_w * 16);
-			TY = (TY + sky_h * 64) % (sky_h * 16);
+	epi::image_data_c *faces[6];
+}
+sky_save_t;
 
-			// SYS_ASSERT(TX >= 0 && TY >= 0);
+static void SaveSkyCacheJob(void *data)
+{
+	sky_save_t *sv = (sky_save_t *) data;
 
-			int FX = TX % 16; TX >>= 4;
-			int FY = TY % 16; TY >>= 4;
+	int face_bytes = sv->size * sv->size * 3;
 
-			// SYS_ASSERT(TX < sky_w && TY < sky_h);
+	std::vector<byte> buffer(12 + 6 * face_bytes);
 
+	s32_t size_le = EPI_LE_S32(sv->size);
 
-			int TX2 = (TX + 1) % sky_w;
-			int TY2 = (TY < sky_h-1) ? (TY+1) : TY;
+	memcpy(buffer.data(), SKY_CACHE_MAGIC, 8);
+	memcpy(buffer.data() + 8, &size_le, 4);
 
-			byte rA, rB, rC, rD;
-			byte gA, gB, gC, gD;
-			byte bA, bB, bC, bD;
+	for (int i = 0; i < 6; i++)
+		memcpy(buffer.data() + 12 + i * face_bytes, sv->faces[i]->pixels, face_bytes);
 
-			switch (sky->bpp)
-			{
-				case 1:
-				{
-					byte src_A = src[TY  * sky_w + TX];
-					byte src_B = src[TY  * sky_w + TX2];
-					byte src_C = src[TY2 * sky_w + TX];
-					byte src_D = src[TY2 * sky_w + TX2];
+	M_SaveCacheFile(sv->filename, buffer.data(), (int)buffer.size());
 
-					rA = PIXEL_RED(src_A); rB = PIXEL_RED(src_B);
-					rC = PIXEL_RED(src_C); rD = PIXEL_RED(src_D);
+	for (int i = 0; i < 6; i++)
+		delete sv->faces[i];
 
-					gA = PIXEL_GRN(src_A); gB = PIXEL_GRN(src_B);
-					gC = PIXEL_GRN(src_C); gD = PIXEL_GRN(src_D);
+	delete sv;
+}
 
-					bA = PIXEL_BLU(src_A); bB = PIXEL_BLU(src_B);
-					bC = PIXEL_BLU(src_C); bD = PIXEL_BLU(src_D);
-				}
-				break;
 
-				case 3:
-				{
-					rA = src[(TY * sky_w + TX) * 3 + 0];
-					gA = src[(TY * sky_w + TX) * 3 + 1];
-					bA = src[(TY * sky_w + TX) * 3 + 2];
+//
+// Builds (or loads from the cache directory) the six faces of a
+// pseudo sky box and uploads them.
+//
+static void BuildPseudoSkyBox(sky_cache_entry_t *ent, const byte *what_palette)
+{
+	int size = ent->face_size;
 
-					rB = src[(TY * sky_w + TX2) * 3 + 0];
-					gB = src[(TY * sky_w + TX2) * 3 + 1];
-					bB = src[(TY * sky_w + TX2) * 3 + 2];
+	bool narrow = SkyIsNarrow(ent->sky);
 
-					rC = src[(TY2 * sky_w + TX) * 3 + 0];
-					gC = src[(TY2 * sky_w + TX) * 3 + 1];
-					bC = src[(TY2 * sky_w + TX) * 3 + 2];
+	// Intentional Const Override
+	epi::image_data_c *block = ReadAsEpiBlock((image_c*)ent->sky);
+	SYS_ASSERT(block);
 
-					rD = src[(TY2 * sky_w + TX2) * 3 + 0];
-					gD = src[(TY2 * sky_w + TX2) * 3 + 1];
-					bD = src[(TY2 * sky_w + TX2) * 3 + 2];
-				}
-				break;
+	sky_build_t sb;
 
-				case 4:
-				{
-					rA = src[(TY * sky_w + TX) * 4 + 0];
-					gA = src[(TY * sky_w + TX) * 4 + 1];
-					bA = src[(TY * sky_w + TX) * 4 + 2];
+	sb.rgb   = SkyToRGB(block, what_palette);
+	sb.sky_w = block->width;
+	sb.sky_h = block->height;
+	sb.size  = size;
 
-					rB = src[(TY * sky_w + TX2) * 4 + 0];
-					gB = src[(TY * sky_w + TX2) * 4 + 1];
-					bB = src[(TY * sky_w + TX2) * 4 + 2];
+	delete block;
 
-					rC = src[(TY2 * sky_w + TX) * 4 + 0];
-					gC = src[(TY2 * sky_w + TX) * 4 + 1];
-					bC = src[(TY2 * sky_w + TX) * 4 + 2];
+	// the cache file name comes from what actually goes into the faces
+	epi::crc32_c crc;
 
-					rD = src[(TY2 * sky_w + TX2) * 4 + 0];
-					gD = src[(TY2 * sky_w + TX2) * 4 + 1];
-					bD = src[(TY2 * sky_w + TX2) * 4 + 2];
-				}
-				break;
+	crc.AddBlock(sb.rgb, sb.sky_w * sb.sky_h * 3);
+	crc += (s32_t) sb.sky_w;
+	crc += (s32_t) sb.sky_h;
+	crc += (s32_t) (narrow ? 1 : 0);
+
+	std::string cache_name = SkyCacheFilename(crc.crc, size);
+
+	epi::image_data_c *faces[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+
+	bool from_cache = LoadSkyCacheFile(cache_name, size, faces);
+
+	if (! from_cache)
+	{
+		PrepareSkyProjection(size, narrow);
 
-				default:  // remove compiler warning
-					rA = rB = rC = rD = 0;
-					gA = gB = gC = gD = 0;
-					bA = bB = bC = bD = 0;
-					break;
-			}
-
-			int r = (int)rA * (FX^15) * (FY^15) +
-					(int)rB * (FX   ) * (FY^15) +
-					(int)rC * (FX^15) * (FY   ) +
-					(int)rD * (FX   ) * (FY   );
-
-			int g = (int)gA * (FX^15) * (FY^15) +
-					(int)gB * (FX   ) * (FY^15) +
-					(int)gC * (FX^15) * (FY   ) +
-					(int)gD * (FX   ) * (FY   );
-
-			int b = (int)bA * (FX^15) * (FY^15) +
-					(int)bB * (FX   ) * (FY^15) +
-					(int)bC * (FX^15) * (FY   ) +
-					(int)bD * (FX   ) * (FY   );
-
-			dest[0] = r / 225;
-			dest[1] = g / 225;
-			dest[2] = b / 225;
+		sb.num_faces = 0;
+
+		for (int i = 0; i < 6; i++)
+		{
+			// optimisation: can share side textures when narrow
+			if (narrow && (i == WSKY_South || i == WSKY_West))
+				continue;
+
+			faces[i] = new epi::image_data_c(size, size, 3);
+
+			sb.faces[i] = faces[i];
+			sb.face_list[sb.num_faces++] = i;
+		}
+
+		I_ParallelFor(sb.num_faces * size, SampleSkyRow, &sb);
+
+		// make the top surface look less bad
+		BlurCentre(*faces[WSKY_Top]);
+
+		if (narrow)
+		{
+			faces[WSKY_South] = new epi::image_data_c(size, size, 3);
+			faces[WSKY_West]  = new epi::image_data_c(size, size, 3);
+
+			memcpy(faces[WSKY_South]->pixels, faces[WSKY_North]->pixels, size * size * 3);
+			memcpy(faces[WSKY_West] ->pixels, faces[WSKY_East] ->pixels, size * size * 3);
 		}
 	}
 
-	// make the top surface look less bad
-	if (face == WSKY_Top)
+	delete[] sb.rgb;
+
+	// North and East come first, so shared faces can be copied
+	static const int upload_order[6] =
 	{
-		BlurCentre(img);
+		WSKY_North, WSKY_East, WSKY_South, WSKY_West, WSKY_Top, WSKY_Bottom
+	};
+
+	for (int k = 0; k < 6; k++)
+	{
+		int i = upload_order[k];
+
+		if (narrow && i == WSKY_South)
+			ent->tex[i] = ent->tex[WSKY_North];
+		else if (narrow && i == WSKY_West)
+			ent->tex[i] = ent->tex[WSKY_East];
+		else
+			ent->tex[i] = R_UploadTexture(faces[i], UPL_Smooth|UPL_Clamp);
 	}
 
-	return R_UploadTexture(&img, UPL_Smooth|UPL_Clamp);
+	if (from_cache)
+	{
+		for (int i = 0; i < 6; i++)
+			delete faces[i];
+
+		return;
+	}
+
+	// save the faces in the background, the job frees them
+	sky_save_t *sv = new sky_save_t;
+
+	sv->filename = cache_name;
+	sv->size = size;
+
+	for (int i = 0; i < 6; i++)
+		sv->faces[i] = faces[i];
+
+	I_QueueJob(SaveSkyCacheJob, sv);
+}
+
+static sky_cache_entry_t *LookupSkyCache(const image_c *sky, const colourmap_c *colmap,
+                                         int face_size, const byte *what_palette)
+{
+	sky_cache_time++;
+
+	for (size_t i = 0; i < sky_cache.size(); i++)
+	{
+		sky_cache_entry_t& ent = sky_cache[i];
+
+		if (ent.sky == sky && ent.colmap == colmap && ent.face_size == face_size)
+		{
+			ent.last_used = sky_cache_time;
+			return &ent;
+		}
+	}
+
+	// throw out the least recently used one if full
+	if ((int)sky_cache.size() >= SKY_CACHE_MAX)
+	{
+		size_t oldest = 0;
+
+		for (size_t i = 1; i < sky_cache.size(); i++)
+			if (sky_cache[i].last_used < sky_cache[oldest].last_used)
+				oldest = i;
+
+		FreeSkyCacheEntry(sky_cache[oldest]);
+
+		sky_cache.erase(sky_cache.begin() + oldest);
+	}
+
+	sky_cache_entry_t ent;
+
+	ent.sky       = sky;
+	ent.colmap    = colmap;
+	ent.face_size = face_size;
+	ent.last_used = sky_cache_time;
+
+	BuildPseudoSkyBox(&ent, what_palette);
+
+	sky_cache.push_back(ent);
+
+	return &sky_cache.back();
 }
 
 
@@ -978,11 +1299,6 @@ int RGL_UpdateSkyBoxTextures(void)
 
 	custom_sky_box = false;
 
-	
-	// Intentional Const Override
-	const epi::image_data_c *block = ReadAsEpiBlock((image_c*)sky_image);
-	SYS_ASSERT(block);
-
 	// get correct palette
 	const byte *what_pal = (const byte *) &playpal_data[0];
 	bool what_pal_cached = false;
@@ -1000,22 +1316,11 @@ int RGL_UpdateSkyBoxTextures(void)
 		what_pal_cached = true;
 	}
 
-	DeleteSkyTexGroup(SK);
-
-	info->tex[WSKY_North]  = BuildFace(block, WSKY_North,  info, what_pal);
-	info->tex[WSKY_East]   = BuildFace(block, WSKY_East,   info, what_pal);
-	info->tex[WSKY_Top]    = BuildFace(block, WSKY_Top,    info, what_pal);
-	info->tex[WSKY_Bottom] = BuildFace(block, WSKY_Bottom, info, what_pal);
-
-	// optimisation: can share side textures when narrow
+	sky_cache_entry_t *ent = LookupSkyCache(sky_image, ren_fx_colmap,
+	                                        info->face_size, what_pal);
 
-	info->tex[WSKY_South] = SkyIsNarrow(sky_image) ? info->tex[WSKY_North] :
-						 BuildFace(block, WSKY_South, info, what_pal );
-
-	info->tex[WSKY_West]  = SkyIsNarrow(sky_image) ? info->tex[WSKY_East] :
-						 BuildFace(block, WSKY_West, info, what_pal );
-
-	delete block;
+	for (int k = 0; k < 6; k++)
+		info->tex[k] = ent->tex[k];
 
 	if (what_pal_cached)
 		W_DoneWithLump(what_pal);
@@ -38,6 +38,8 @@
 #include "w_texture.h"
 #include "w_wad.h"
 
+#include "system/i_thread.h"
+
 int W_MakeValidSize(int value)
 {
 	SYS_ASSERT(value > 0);
@@ -98,6 +100,78 @@ epi::image_data_c *R_PalettisedToRGB(epi::image_data_c *src,
 	return dest;
 }
 
+static void UploadLevel(epi::image_data_c *img, int mip)
+{
+	GLenum format = (img->bpp == 3) ? GL_RGB : GL_RGBA;
+
+	glTexImage2D(GL_TEXTURE_2D, mip, format, img->width, img->height,
+		0 /* border */, format, GL_UNSIGNED_BYTE, img->PixelAt(0, 0));
+}
+
+typedef struct
+{
+	const epi::image_data_c *src;
+	epi::image_data_c *dest;
+
+	int rows_per_job;
+}
+halve_level_t;
+
+static void HalveLevelJob(int index, void *data)
+{
+	halve_level_t *H = (halve_level_t *) data;
+
+	int y1 = index * H->rows_per_job;
+	int y2 = MIN(y1 + H->rows_per_job, H->dest->height);
+
+	H->src->HalveMaskedRows(H->dest, y1, y2);
+}
+
+//
+// HalveLevel
+//
+// Returns a new image with the next mipmap level of 'src', which
+// stays unchanged.
+//
+static epi::image_data_c *HalveLevel(const epi::image_data_c *src)
+{
+	int new_w = MAX(1, src->width  / 2);
+	int new_h = MAX(1, src->height / 2);
+
+	epi::image_data_c *dest;
+
+	// a side of 3 becomes 1, which the fast path does not handle
+	if ((src->width > 1 && src->width / new_w != 2) ||
+		(src->height > 1 && src->height / new_h != 2))
+	{
+		dest = new epi::image_data_c(src->width, src->height, src->bpp);
+
+		memcpy(dest->pixels, src->pixels, src->width * src->height * src->bpp);
+
+		dest->ShrinkMasked(new_w, new_h);
+		return dest;
+	}
+
+	dest = new epi::image_data_c(new_w, new_h, src->bpp);
+
+	// only worth spreading over the workers for big levels
+	if (new_w * new_h < 128 * 128)
+	{
+		src->HalveMaskedRows(dest, 0, new_h);
+		return dest;
+	}
+
+	halve_level_t H;
+
+	H.src  = src;
+	H.dest = dest;
+	H.rows_per_job = MAX(1, 16384 / new_w);
+
+	I_ParallelFor((new_h + H.rows_per_job - 1) / H.rows_per_job, HalveLevelJob, &H);
+
+	return dest;
+}
+
 GLuint R_UploadTexture(epi::image_data_c *img, int flags, int max_pix)
 {
 	/* Send the texture data to the GL, and returns the texture ID
@@ -182,25 +256,45 @@ GLuint R_UploadTexture(epi::image_data_c *img, int flags, int max_pix)
 		minif_modes[(smooth ? 3 : 0) +
 		(nomip ? 0 : mip_level)]);
 
-	for (int mip = 0; ; mip++)
+	if (img->width != new_w || img->height != new_h)
 	{
-		if (img->width != new_w || img->height != new_h)
-		{
-			img->ShrinkMasked(new_w, new_h);
+		img->ShrinkMasked(new_w, new_h);
 
-			if (flags & UPL_Thresh)
-				img->ThresholdAlpha((mip & 1) ? 96 : 144);
+		if (flags & UPL_Thresh)
+			img->ThresholdAlpha(144);
+	}
+
+	UploadLevel(img, 0);
+
+	if (nomip || !var_mipmapping || (new_w == 1 && new_h == 1))
+		return id;
+
+	// solid textures can let the GL build the mipmaps.  Masked ones
+	// cannot, the GL would not weight the colours by their alpha and
+	// the thresholding would be lost.
+	if (img->bpp == 3 && ! (flags & UPL_Thresh) &&
+		(gl.flags & RFL_GENERATE_MIPMAP))
+	{
+#if !(defined WIN32 || defined DREAMCAST)
+		// same workaround as below
+		int last = 0;
+
+		for (int w = new_w, h = new_h; w > 1 || h > 1; last++)
+		{
+			w = MAX(1, w / 2);
+			h = MAX(1, h / 2);
 		}
 
-		glTexImage2D(GL_TEXTURE_2D, mip, (img->bpp == 3) ? GL_RGB : GL_RGBA,
-			new_w, new_h, 0 /* border */,
-			(img->bpp == 3) ? GL_RGB : GL_RGBA,
-			GL_UNSIGNED_BYTE, img->PixelAt(0, 0));
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last - 1);
+#endif
+		glGenerateMipmap(GL_TEXTURE_2D);
+		return id;
+	}
 
-		// stop if mipmapping disabled or we have reached the end
-		if (nomip || !var_mipmapping || (new_w == 1 && new_h == 1))
-			break;
+	epi::image_data_c *level = img;
 
+	for (int mip = 1; ; mip++)
+	{
 		new_w = MAX(1, new_w / 2);
 		new_h = MAX(1, new_h / 2);
 
@@ -209,114 +303,216 @@ GLuint R_UploadTexture(epi::image_data_c *img, int flags, int max_pix)
 		//       incorrectly draws the 1x1 mip texture as black.
 		// -CA-  Also used for DREAMCAST.
 		if (new_w == 1 && new_h == 1)
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mip);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mip - 1);
 #endif
+
+		epi::image_data_c *next = HalveLevel(level);
+
+		if (level != img)
+			delete level;
+
+		level = next;
+
+		if (flags & UPL_Thresh)
+			level->ThresholdAlpha((mip & 1) ? 96 : 144);
+
+		UploadLevel(level, mip);
+
+		if (new_w == 1 && new_h == 1)
+			break;
 	}
 
+	if (level != img)
+		delete level;
+
 	return id;
 }
 
-//----------------------------------------------------------------------------
-
-void R_PaletteRemapRGBA(epi::image_data_c *img,
-	const byte *new_pal, const byte *old_pal)
+//
+// R_TextureUploadBenchmark
+//
+// Builds the mipmap chains of some big noisy textures the old way
+// (ShrinkMasked on each level) and the new way, checking that they
+// match, then times whole uploads.
+//
+void R_TextureUploadBenchmark(void)
 {
-	const int max_prev = 16;
+	const int size  = 1024;
+	const int count = 4;
 
-	// cache of previously looked-up colours (in pairs)
-	u8_t previous[max_prev * 6];
-	int num_prev = 0;
+	epi::image_data_c *images[count * 2];
 
-	for (int y = 0; y < img->height; y++)
-		for (int x = 0; x < img->width; x++)
+	unsigned int seed = 12345;
+
+	for (int k = 0; k < count * 2; k++)
+	{
+		int bpp = (k < count) ? 4 : 3;
+
+		epi::image_data_c *img = new epi::image_data_c(size, size, bpp);
+
+		for (int i = 0; i < size * size * bpp; i++)
 		{
-			u8_t *cur = img->PixelAt(x, y);
+			seed = seed * 1103515245 + 12345;
 
-			// skip completely transparent pixels
-			if (img->bpp == 4 && cur[3] == 0)
-				continue;
+			img->pixels[i] = (byte)(seed >> 16);
 
-			// optimisation: if colour matches previous one, don't need
-			// to compute the remapping again.
-			int i;
-			for (i = 0; i < num_prev; i++)
-			{
-				if (previous[i * 6 + 0] == cur[0] &&
-					previous[i * 6 + 1] == cur[1] &&
-					previous[i * 6 + 2] == cur[2])
-				{
-					break;
-				}
-			}
+			// give the RGBA ones some clear areas
+			if (bpp == 4 && (i & 3) == 3 && (seed >> 24) < 64)
+				img->pixels[i] = 0;
+		}
 
-			if (i < num_prev)
-			{
-				// move to front (Most Recently Used)
-#if 1
-				if (i != 0)
-				{
-					u8_t tmp[6];
-
-					memcpy(tmp, previous, 6);
-					memcpy(previous, previous + i * 6, 6);
-					memcpy(previous + i * 6, tmp, 6);
-				}
-#endif
-				cur[0] = previous[3];
-				cur[1] = previous[4];
-				cur[2] = previous[5];
+		images[k] = img;
+	}
 
-				continue;
-			}
+	int mismatches = 0;
 
-			if (num_prev < max_prev)
-			{
-				memmove(previous + 6, previous, num_prev * 6);
-				num_prev++;
-			}
+	u32_t old_us = 0;
+	u32_t new_us = 0;
 
-			// most recent lookup is at the head
-			previous[0] = cur[0];
-			previous[1] = cur[1];
-			previous[2] = cur[2];
+	for (int k = 0; k < count * 2; k++)
+	{
+		const epi::image_data_c *src = images[k];
 
-			int best = 0;
-			int best_dist = (1 << 30);
+		epi::image_data_c *a = new epi::image_data_c(size, size, src->bpp);
+		const epi::image_data_c *b = src;
 
-			int R = int(cur[0]);
-			int G = int(cur[1]);
-			int B = int(cur[2]);
+		memcpy(a->pixels, src->pixels, size * size * src->bpp);
 
-			for (int p = 0; p < 256; p++)
-			{
-				int dR = int(old_pal[p * 3 + 0]) - R;
-				int dG = int(old_pal[p * 3 + 1]) - G;
-				int dB = int(old_pal[p * 3 + 2]) - B;
+		for (int w = size / 2; w >= 1; w /= 2)
+		{
+			u32_t t0 = I_ReadMicroSeconds();
 
-				int dist = dR * dR + dG * dG + dB * dB;
+			a->ShrinkMasked(w, w);
 
-				if (dist < best_dist)
-				{
-					best_dist = dist;
-					best = p;
-				}
-			}
+			u32_t t1 = I_ReadMicroSeconds();
+
+			epi::image_data_c *next = HalveLevel(b);
+
+			u32_t t2 = I_ReadMicroSeconds();
+
+			if (b != src)
+				delete b;
+
+			b = next;
+
+			old_us += t1 - t0;
+			new_us += t2 - t1;
+
+			if (memcmp(a->pixels, b->pixels, w * w * src->bpp) != 0)
+				mismatches++;
+		}
+
+		if (b != src)
+			delete b;
+
+		delete a;
+	}
+
+	// whole uploads, including the mipmaps and the GL's own work
+	u32_t t3 = I_ReadMicroSeconds();
+
+	for (int k = 0; k < count * 2; k++)
+	{
+		GLuint tex = R_UploadTexture(images[k], UPL_MipMap | UPL_Smooth |
+			((k < count) ? UPL_Thresh : 0));
+
+		glDeleteTextures(1, &tex);
+	}
+
+	glFinish();
+
+	u32_t t4 = I_ReadMicroSeconds();
+
+	for (int k = 0; k < count * 2; k++)
+		delete images[k];
+
+	float megs = count * size * size * (4 + 3) / (1024.0f * 1024.0f);
+
+	I_Printf("Mipmap chains: %d RGBA + %d RGB textures, %dx%d\n", count, count, size, size);
+	I_Printf("  ShrinkMasked : %7.1f ms\n", old_us / 1000.0f);
+	I_Printf("  HalveLevel   : %7.1f ms (%d workers)\n", new_us / 1000.0f, I_NumWorkers());
+	I_Printf("  mismatches   : %d\n", mismatches);
+	I_Printf("  uploads      : %7.1f MB/sec (mipmapping %d, %s)\n",
+		megs / MAX(1, (int)(t4 - t3)) * 1000000.0f, var_mipmapping,
+		(gl.flags & RFL_GENERATE_MIPMAP) ? "glGenerateMipmap" : "no glGenerateMipmap");
+}
+
+//----------------------------------------------------------------------------
+
+typedef struct
+{
+	epi::image_data_c *img;
+
+	const byte *new_pal;
+	const byte *old_pal;
+
+	// which palette entries are changed by the remap
+	bool changed[256];
+}
+palette_remap_t;
+
+static void PaletteRemapRow(int y, void *data)
+{
+	palette_remap_t *rm = (palette_remap_t *) data;
+
+	epi::image_data_c *img = rm->img;
+
+	byte best[4096];
+
+	for (int x = 0; x < img->width; x += 4096)
+	{
+		int count = MIN(4096, img->width - x);
+
+		u8_t *cur = img->PixelAt(x, y);
+
+		V_FindColours(rm->old_pal, cur, img->bpp, count, best);
+
+		for (int i = 0; i < count; i++, cur += img->bpp)
+		{
+			// skip completely transparent pixels
+			if (img->bpp == 4 && cur[3] == 0)
+				continue;
 
 			// if this colour is not affected by the colourmap, then
 			// keep the original colour (which has more precision).
-			if (old_pal[best * 3 + 0] != new_pal[best * 3 + 0] ||
-				old_pal[best * 3 + 1] != new_pal[best * 3 + 1] ||
-				old_pal[best * 3 + 2] != new_pal[best * 3 + 2])
+			int p = best[i];
+
+			if (rm->changed[p])
 			{
-				cur[0] = new_pal[best * 3 + 0];
-				cur[1] = new_pal[best * 3 + 1];
-				cur[2] = new_pal[best * 3 + 2];
+				cur[0] = rm->new_pal[p * 3 + 0];
+				cur[1] = rm->new_pal[p * 3 + 1];
+				cur[2] = rm->new_pal[p * 3 + 2];
 			}
-
-			previous[3] = cur[0];
-			previous[4] = cur[1];
-			previous[5] = cur[2];
 		}
+	}
+}
+
+void R_PaletteRemapRGBA(epi::image_data_c *img,
+	const byte *new_pal, const byte *old_pal)
+{
+	palette_remap_t rm;
+
+	rm.img = img;
+	rm.new_pal = new_pal;
+	rm.old_pal = old_pal;
+
+	for (int p = 0; p < 256; p++)
+	{
+		rm.changed[p] = (old_pal[p * 3 + 0] != new_pal[p * 3 + 0] ||
+		                 old_pal[p * 3 + 1] != new_pal[p * 3 + 1] ||
+		                 old_pal[p * 3 + 2] != new_pal[p * 3 + 2]);
+	}
+
+	V_PrepareColourCube(old_pal);
+
+	// only worth spreading over the workers for big images
+	if (img->width * img->height >= 128 * 128)
+		I_ParallelFor(img->height, PaletteRemapRow, &rm);
+	else
+	{
+		for (int y = 0; y < img->height; y++)
+			PaletteRemapRow(y, &rm);
+	}
 }
 
 int R_DetermineOpacity(epi::image_data_c *img)
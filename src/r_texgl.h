@@ -48,6 +48,8 @@ void R_BlackenClearAreas(epi::image_data_c *img);
 
 void R_DumpImage(epi::image_data_c *img);
 
+void R_TextureUploadBenchmark(void);
+
 #endif /* __RGL_TEXGL_H__ */
 
 //--- editor settings ---
@@ -41,6 +41,7 @@
 #include "m_random.h"
 #include "r_colormap.h"
 #include "r_defs.h"
+#include "r_dlight.h"
 #include "r_draw.h"
 #include "r_effects.h"
 #include "r_gldefs.h"
@@ -282,7 +283,7 @@ static void RGL_DrawPSprite(pspdef_t * psp, int which,
 
 			float r = 96;
 
-			P_DynamicLightIterator(
+			R_DynamicLightIterator(
 				data.lit_pos.x - r, data.lit_pos.y - r, player->mo->z,
 				data.lit_pos.x + r, data.lit_pos.y + r, player->mo->z + player->mo->height,
 				DLIT_PSprite, &data);
@@ -958,6 +959,44 @@ static void R2_ClipSpriteVertically(drawsub_c *dsub, drawthing_t *dthing)
 }
 
 
+static void GetModelLerp(mobj_t *mo, int *last_frame, float *lerp)
+{
+	*last_frame = mo->state->frame;
+	*lerp = 0.0;
+
+	if (mo->model_last_frame >= 0)
+	{
+		*last_frame = mo->model_last_frame;
+
+		SYS_ASSERT(mo->state->tics > 1);
+
+
+		*lerp = (mo->state->tics - mo->tics + /* 1 + */ N_GetInterpolater()) / (float)(mo->state->tics);
+		*lerp = CLAMP(0, *lerp, 1);
+	}
+}
+
+//
+// Gets the worker threads skinning an MD5 model while the rest of the
+// BSP is walked, so it is ready by the time the model is drawn.
+//
+static void RGL_PrepareModel(mobj_t *mo)
+{
+	modeldef_c *md = W_GetModel(mo->state->sprite);
+
+	if (md->modeltype != MODEL_MD5_UNIFIED || mo->state->framerange != 0)
+		return;
+
+	int last_frame;
+	float lerp;
+
+	GetModelLerp(mo, &last_frame, &lerp);
+
+	MD5_PrepareModel(md,
+		mo->model_last_animfile, last_frame,
+		mo->state->animfile, mo->state->frame, lerp);
+}
+
 void RGL_WalkThing(drawsub_c *dsub, mobj_t *mo)
 {
 	/* Visit a single thing that exists in the current subsector */
@@ -1124,6 +1163,9 @@ void RGL_WalkThing(drawsub_c *dsub, mobj_t *mo)
 	dthing->y_clipping = y_clipping;
 	dthing->is_model = is_model;
 
+	if (is_model)
+		RGL_PrepareModel(mo);
+
 	dthing->image = image;
 	dthing->flip  = spr_flip;
 
@@ -1164,19 +1206,10 @@ static void RGL_DrawModel(drawthing_t *dthing)
 	if (mo->hyperflags & HF_HOVER)
 		z += GetHoverDZ(mo);
 
-	int last_frame = mo->state->frame;
-	float lerp = 0.0;
-
-	if (mo->model_last_frame >= 0)
-	{
-		last_frame = mo->model_last_frame;
-
-		SYS_ASSERT(mo->state->tics > 1);
-
+	int last_frame;
+	float lerp;
 
-		lerp = (mo->state->tics - mo->tics + /* 1 + */ N_GetInterpolater()) / (float)(mo->state->tics);
-		lerp = CLAMP(0, lerp, 1);
-	}
+	GetModelLerp(mo, &last_frame, &lerp);
 
 	if (md->modeltype == MODEL_MD2)
 	{
@@ -1475,7 +1508,7 @@ skip_shadow:
 		{
 			float r = mo->radius + 32;
 
-			P_DynamicLightIterator(
+			R_DynamicLightIterator(
 					mo->x - r, mo->y - r, mo->z,
 					mo->x + r, mo->y + r, mo->z + mo->height,
 					DLIT_Thing, &data);
@@ -40,6 +40,7 @@
 #include "r_shader.h"
 #include "r_bumpmap.h"
 #include "r_colormap.h"
+#include "r_shaderprogram.h"
 
 // define to enable light color and fog per sector code
 #define USE_FOG
@@ -61,6 +62,9 @@ DEF_CVAR(r_anisotropy, int, "c", 0);
 
 DEF_CVAR(r_gl3_path, int, "c", 0);
 
+// draw dynamic lights and sector glows in a single pass with GLSL
+DEF_CVAR(r_lightpass, int, "c", 1);
+
 static bump_map_shader bmap_shader;
 
 //XXX
@@ -79,6 +83,8 @@ static int bmap_light_count = 0;
 
 #define MAX_L_UNIT  (MAX_L_VERT / 4)
 
+#define MAX_L_LIGHT  4096
+
 #define DUMMY_CLAMP  789
 
 
@@ -106,17 +112,22 @@ typedef struct local_gl_unit_s
 
 	// range of local vertices
 	int first, count;
+
+	// range of local lights (single pass lighting)
+	int first_light, num_lights;
 }
 local_gl_unit_t;
 
 
 static local_gl_vert_t local_verts[MAX_L_VERT];
 static local_gl_unit_t local_units[MAX_L_UNIT];
+static unit_light_t    local_lights[MAX_L_LIGHT];
 
 static std::vector<local_gl_unit_t*> local_unit_map;
 
 static int cur_vert;
 static int cur_unit;
+static int cur_light;
 
 static bool batch_sort;
 
@@ -164,6 +175,132 @@ void RGL_CaptureCameraMatrix()
 }
 
 
+//----------------------------------------------------------------------------
+//  SINGLE PASS LIGHTING
+//----------------------------------------------------------------------------
+
+static FShaderProgram *light_prog;
+static bool light_prog_failed;
+static bool light_prog_bound;
+
+static GLint light_u_masked;
+static GLint light_u_count;
+static GLint light_u_pos;
+static GLint light_u_color;
+static GLint light_u_radius;
+
+static bool InitLightProgram(void)
+{
+	if (light_prog)
+		return true;
+
+	if (light_prog_failed)
+		return false;
+
+	// the shaders use the fixed function inputs (gl_Vertex etc) together
+	// with in/out, which needs GLSL 1.30 in a compatibility context.
+	if (gl.glslversion < 1.3f)
+	{
+		I_Printf("OpenGL: GLSL 1.30 not available, single pass lighting disabled.\n");
+		light_prog_failed = true;
+		return false;
+	}
+
+	char defines[64];
+	sprintf(defines, "#define MAX_LIGHTS %d\n", MAX_UNIT_LIGHTS);
+
+	light_prog = new FShaderProgram;
+
+	light_prog->Compile(FShaderProgram::Vertex,   "/pack0/shaders/glsl/dynlight.vp", defines, 130);
+	light_prog->Compile(FShaderProgram::Fragment, "/pack0/shaders/glsl/dynlight.fp", defines, 130);
+	light_prog->SetFragDataLocation(0, "FragColor");
+	light_prog->Link("/pack0/shaders/glsl/dynlight");
+
+	GLuint prog = *light_prog;
+
+	glUseProgram(prog);
+	glUniform1i(glGetUniformLocation(prog, "Texture"), 0);
+	glUseProgram(0);
+
+	light_u_masked = glGetUniformLocation(prog, "Masked");
+	light_u_count  = glGetUniformLocation(prog, "NumLights");
+	light_u_pos    = glGetUniformLocation(prog, "LightPos");
+	light_u_color  = glGetUniformLocation(prog, "LightColor");
+	light_u_radius = glGetUniformLocation(prog, "LightRadius");
+
+	return true;
+}
+
+bool RGL_LightPassEnabled(void)
+{
+	if (r_lightpass <= 0)
+		return false;
+
+	return InitLightProgram();
+}
+
+static void BindLightProgram(const local_gl_unit_t *unit)
+{
+	if (! light_prog_bound)
+	{
+		glUseProgram(*light_prog);
+		light_prog_bound = true;
+	}
+
+	float pos   [MAX_UNIT_LIGHTS * 4];
+	float color [MAX_UNIT_LIGHTS * 4];
+	float radius[MAX_UNIT_LIGHTS];
+
+	for (int i = 0; i < unit->num_lights; i++)
+	{
+		const unit_light_t *L = local_lights + unit->first_light + i;
+
+		pos[i*4 + 0] = L->pos.x;
+		pos[i*4 + 1] = L->pos.y;
+		pos[i*4 + 2] = L->pos.z;
+		pos[i*4 + 3] = L->glow ? 1.0f : 0.0f;
+
+		color[i*4 + 0] = L->r;
+		color[i*4 + 1] = L->g;
+		color[i*4 + 2] = L->b;
+		color[i*4 + 3] = L->modulate ? 1.0f : 0.0f;
+
+		radius[i] = L->radius;
+	}
+
+	glUniform1i(light_u_masked, (unit->blending & BL_Masked) ? 1 : 0);
+	glUniform1i(light_u_count,  unit->num_lights);
+
+	glUniform4fv(light_u_pos,    unit->num_lights, pos);
+	glUniform4fv(light_u_color,  unit->num_lights, color);
+	glUniform1fv(light_u_radius, unit->num_lights, radius);
+}
+
+static void UnbindLightProgram(void)
+{
+	if (light_prog_bound)
+	{
+		glUseProgram(0);
+		light_prog_bound = false;
+	}
+}
+
+void RGL_SetUnitLights(const unit_light_t *lights, int count)
+{
+	SYS_ASSERT(count > 0 && count <= MAX_UNIT_LIGHTS);
+	SYS_ASSERT(cur_light + count <= MAX_L_LIGHT);
+
+	local_gl_unit_t* unit = local_units + cur_unit;
+
+	memcpy(local_lights + cur_light, lights, count * sizeof(unit_light_t));
+
+	unit->first_light = cur_light;
+	unit->num_lights  = count;
+
+	cur_light += count;
+}
+
+
 //
 // RGL_InitUnits
 //
@@ -196,7 +333,7 @@ void RGL_SoftInitUnits()
 //
 void RGL_StartUnits(bool sort_em)
 {
-	cur_vert = cur_unit = 0;
+	cur_vert = cur_unit = cur_light = 0;
 
 	batch_sort = sort_em;
 
@@ -256,7 +393,8 @@ local_gl_vert_t* RGL_BeginUnit(GLuint shape, int max_vert,
 	SYS_ASSERT((blending & BL_CULL_BOTH) != BL_CULL_BOTH);
 
 	// check we have enough space left
-	if (cur_vert + max_vert > MAX_L_VERT || cur_unit >= MAX_L_UNIT)
+	if (cur_vert + max_vert > MAX_L_VERT || cur_unit >= MAX_L_UNIT ||
+		cur_light + MAX_UNIT_LIGHTS > MAX_L_LIGHT)
 	{
 		RGL_DrawUnits();
 	}
@@ -274,6 +412,9 @@ local_gl_vert_t* RGL_BeginUnit(GLuint shape, int max_vert,
 	unit->tex_normal = 0;
 	unit->tex_specular = 0;
 
+	unit->first_light = cur_light;
+	unit->num_lights = 0;
+
 	unit->pass = pass;
 	unit->blending = blending;
 	unit->first = cur_vert;  // count set later
@@ -340,6 +481,9 @@ struct Compare_Unit_pred
 		if (A->env[1] != B->env[1])
 			return A->env[1] < B->env[1];
 
+		if ((A->num_lights > 0) != (B->num_lights > 0))
+			return B->num_lights > 0;
+
 		return A->blending < B->blending;
 	}
 };
@@ -657,8 +801,20 @@ void RGL_DrawUnits(void)
 		}
 
 
+		// uniforms change with each lit unit, so the batch must end
+		if (unit->num_lights > 0)
+		{
+			RGL_BatchShape(0);
+			BindLightProgram(unit);
+		}
+		else if (light_prog_bound)
+		{
+			RGL_BatchShape(0);
+			UnbindLightProgram();
+		}
+
 		//disable if unit has multiple textures (level geometry lightmap for instance)
-		if (RGL_GL3Enabled() && unit->tex[1] == 0)
+		if (RGL_GL3Enabled() && unit->tex[1] == 0 && unit->num_lights == 0)
 		{
 			RGL_BatchShape(0);
 
@@ -785,8 +941,10 @@ void RGL_DrawUnits(void)
 
 	RGL_BatchShape(0);
 
+	UnbindLightProgram();
+
 	// all done
-	cur_vert = cur_unit = 0;
+	cur_vert = cur_unit = cur_light = 0;
 
 	glPolygonOffset(0, 0);
 
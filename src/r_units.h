@@ -124,6 +124,32 @@ local_gl_vert_t *RGL_BeginUnit(GLuint shape, int max_vert,
 void RGL_SetUnitMaps(GLuint tex_normal,GLuint tex_specular);
 void RGL_EndUnit(int actual_vert);
 
+// single pass lighting of world polygons (r_lightpass)
+
+#define MAX_UNIT_LIGHTS  8
+
+typedef struct unit_light_s
+{
+	vec3_t pos;     // centre of the light (only z is used for glows)
+	float radius;
+
+	// colour, already scaled by the light's brightness
+	float r, g, b;
+
+	bool glow;      // distance is measured vertically, from pos.z
+	bool modulate;  // colour is multiplied by the surface texture
+}
+unit_light_t;
+
+bool RGL_LightPassEnabled(void);
+// Returns true when r_lightpass is on and the GLSL program is usable.
+
+void RGL_SetUnitLights(const unit_light_t *lights, int count);
+// Draws the current unit with the light shader instead of the fixed
+// pipeline, adding all the given lights in one go.  The unit should
+// have the surface texture in tex1, and white vertex colours (with
+// the surface's alpha).  Call between RGL_BeginUnit and RGL_EndUnit.
+
 #endif /* __R_UNITS_H__ */
 //--- editor settings ---
 // vi:ts=4:sw=4:noexpandtab
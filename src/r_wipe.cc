@@ -62,45 +62,84 @@ static inline byte SpookyAlpha(int x, int y)
 	return (x*x + y * y) / 2;
 }
 
-static void CaptureScreenAsTexture(bool speckly, bool spooky)
-{
-	int total_w = W_MakeValidSize(SCREENWIDTH);
-	int total_h = W_MakeValidSize(SCREENHEIGHT);
+//
+// The pixel fade and spooky wipes get their alpha from a small tiled
+// texture on the second texture unit, instead of the screen capture
+// itself.  The spooky pattern repeats every 64x32 pixels.
+//
+#define SPOOKY_W  64
+#define SPOOKY_H  32
 
-	epi::image_data_c img(total_w, total_h, 4);
+#define SPECKLE_SIZE  256
 
-	img.Clear();
+static GLuint cur_wipe_pattern = 0;
+static int cur_pattern_w;
+static int cur_pattern_h;
 
-	cur_wipe_right = SCREENWIDTH / (float)total_w;
-	cur_wipe_top = SCREENHEIGHT / (float)total_h;
+static void CreatePattern(bool spooky)
+{
+	int w = spooky ? SPOOKY_W : SPECKLE_SIZE;
+	int h = spooky ? SPOOKY_H : SPECKLE_SIZE;
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	epi::image_data_c img(w, h, 4);
 
-	for (int y = 0; y < SCREENHEIGHT; y++)
+	for (int y = 0; y < h; y++)
 	{
-		u8_t *dest = img.PixelAt(0, y); //
-
-		glReadPixels(0, y, SCREENWIDTH, 1, GL_RGBA, GL_UNSIGNED_BYTE, dest);
+		u8_t *dest = img.PixelAt(0, y);
 
 		int rnd_val = y;
 
-		if (spooky)
-		{
-			for (int x = 0; x < total_w; x++)
-				dest[4 * x + 3] = SpookyAlpha(x, y);
-		}
-		else if (speckly)
+		for (int x = 0; x < w; x++, dest += 4)
 		{
-			for (int x = 0; x < total_w; x++)
+			dest[0] = dest[1] = dest[2] = 255;
+
+			if (spooky)
+				dest[3] = SpookyAlpha(x, y);
+			else
 			{
 				rnd_val = rnd_val * 1103515245 + 12345;
 
-				dest[4 * x + 3] = (rnd_val >> 16);
+				dest[3] = (rnd_val >> 16);
 			}
 		}
 	}
 
-	cur_wipe_tex = R_UploadTexture(&img);
+	// not clamped, so it repeats across the screen
+	cur_wipe_pattern = R_UploadTexture(&img);
+
+	cur_pattern_w = w;
+	cur_pattern_h = h;
+}
+
+//
+// Copies the screen into a texture, entirely on the GPU.
+//
+static void CaptureScreenAsTexture(bool speckly, bool spooky)
+{
+	int total_w = W_MakeValidSize(SCREENWIDTH);
+	int total_h = W_MakeValidSize(SCREENHEIGHT);
+
+	cur_wipe_right = SCREENWIDTH / (float)total_w;
+	cur_wipe_top = SCREENHEIGHT / (float)total_h;
+
+	glGenTextures(1, &cur_wipe_tex);
+	glBindTexture(GL_TEXTURE_2D, cur_wipe_tex);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	// RGB, so the alpha is always 1.0
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, total_w, total_h, 0,
+				 GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, SCREENWIDTH, SCREENHEIGHT);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (speckly || spooky)
+		CreatePattern(spooky);
 }
 
 static void RGL_Init_Melt(void)
@@ -167,6 +206,12 @@ void RGL_StopWipe(void)
 		glDeleteTextures(1, &cur_wipe_tex);
 		cur_wipe_tex = 0;
 	}
+
+	if (cur_wipe_pattern != 0)
+	{
+		glDeleteTextures(1, &cur_wipe_pattern);
+		cur_wipe_pattern = 0;
+	}
 }
 
 
@@ -211,22 +256,44 @@ static void RGL_Wipe_Pixelfade(float how_far)
 	glBindTexture(GL_TEXTURE_2D, cur_wipe_tex);
 	glColor3f(1.0f, 1.0f, 1.0f);
 
+	// colour from the screen, alpha from the pattern
+	glActiveTexture(GL_TEXTURE1);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, cur_wipe_pattern);
+
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+	glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_REPLACE);
+	glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_PREVIOUS);
+	glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+	glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_TEXTURE);
+
+	float pat_x = SCREENWIDTH  / (float)cur_pattern_w;
+	float pat_y = SCREENHEIGHT / (float)cur_pattern_h;
+
 	glBegin(GL_QUADS);
 
-	glTexCoord2f(0.0f, 0.0f);
+	glMultiTexCoord2f(GL_TEXTURE0, 0.0f, 0.0f);
+	glMultiTexCoord2f(GL_TEXTURE1, 0.0f, 0.0f);
 	glVertex2i(0, 0);
 
-	glTexCoord2f(0.0f, cur_wipe_top);
+	glMultiTexCoord2f(GL_TEXTURE0, 0.0f, cur_wipe_top);
+	glMultiTexCoord2f(GL_TEXTURE1, 0.0f, pat_y);
 	glVertex2i(0, SCREENHEIGHT);
 
-	glTexCoord2f(cur_wipe_right, cur_wipe_top);
+	glMultiTexCoord2f(GL_TEXTURE0, cur_wipe_right, cur_wipe_top);
+	glMultiTexCoord2f(GL_TEXTURE1, pat_x, pat_y);
 	glVertex2i(SCREENWIDTH, SCREENHEIGHT);
 
-	glTexCoord2f(cur_wipe_right, 0.0f);
+	glMultiTexCoord2f(GL_TEXTURE0, cur_wipe_right, 0.0f);
+	glMultiTexCoord2f(GL_TEXTURE1, pat_x, 0.0f);
 	glVertex2i(SCREENWIDTH, 0);
 
 	glEnd();
 
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glDisable(GL_TEXTURE_2D);
+	glActiveTexture(GL_TEXTURE0);
+
 	glDisable(GL_ALPHA_TEST);
 	glDisable(GL_BLEND);
 	glDisable(GL_TEXTURE_2D);
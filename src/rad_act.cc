@@ -537,12 +537,14 @@ void RAD_ActDamageMonsters(rad_trigger_t *R, void *param)
 
 	player_t *player = GetWhoDunnit(R);
 
-	for (mo = mobjlisthead; mo != NULL; mo = next)
-	{
-		next = mo->next;
+	// only look at the monsters of the right type (or all of them)
+	mobj_registry_e reg = info ? MREG_Type : MREG_Alive;
 
-		if (info && mo->info != info)
-			continue;
+	mo = info ? P_TypeRegistryHead(info) : P_RegistryHead(MREG_Alive);
+
+	for (; mo != NULL; mo = next)
+	{
+		next = mo->reg_next[reg];
 
 		if (tag && (mo->tag != tag))
 			continue;
@@ -585,12 +587,12 @@ void RAD_ActThingEvent(rad_trigger_t *R, void *param)
 	mobj_t *mo;
 	mobj_t *next;
 
-	for (mo = mobjlisthead; mo != NULL; mo = next)
-	{
-		next = mo->next;
+	// with a thing type, only that type's registry needs scanning
+	mo = info ? P_TypeRegistryHead(info) : mobjlisthead;
 
-		if (info && (mo->info != info))
-			continue;
+	for (; mo != NULL; mo = next)
+	{
+		next = info ? mo->reg_next[MREG_Type] : mo->next;
 
 		if (tag && (mo->tag != tag))
 			continue;
@@ -607,6 +607,11 @@ typedef struct rad_trigger_s
 
 	// prevent repeating scripts from clogging the console
 	const char *last_con_message;
+
+	// spatial index info (not saved, rebuilt by RAD_IndexTriggers).
+	// index_order is the position in the active_triggers list.
+	int index_order;
+	int index_stamp;
 }
 rad_trigger_t;
 
@@ -60,9 +60,19 @@
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include <vector>
+#include <algorithm>
+
 
 #define MAXRTSLINE  2048
 
+// Radius trigger spatial index: cell size (in map units) and maximum
+// number of cells along either axis.  Triggers whose box covers more
+// than RTS_MAX_TRIG_CELLS cells are simply placed on the always list.
+#define RTS_CELL_SIZE       128.0f
+#define RTS_MAX_GRID_DIM    256
+#define RTS_MAX_TRIG_CELLS  1024
+
 
 // Static Scripts.  Never change once all scripts have been read in.
 rad_script_t *r_scripts = NULL;
@@ -422,9 +432,10 @@ static bool RAD_CheckBossTrig(rad_trigger_t *trig, s_ondeath_t *cond)
 	}
 
 	// scan the remaining mobjs to see if all bosses are dead
-	for (mo=mobjlisthead; mo != NULL; mo=mo->next)
+	for (mo=P_TypeRegistryHead(cond->cached_info); mo != NULL;
+		 mo=mo->reg_next[MREG_Type])
 	{
-		if (mo->info == cond->cached_info && mo->health > 0)
+		if (mo->health > 0)
 		{
 			count++;
 
@@ -523,8 +534,257 @@ bool RAD_CheckReachedTrigger(mobj_t * thing)
 	return true;
 }
 
+//----------------------------------------------------------------------------
+//  TRIGGER SPATIAL INDEX
+//----------------------------------------------------------------------------
+//
+// Triggers which need a player within their radius are bucketed into a
+// uniform grid keyed by their radius box, so each tic only the triggers
+// in cells touched by a player get evaluated.  Immediate and whole-map
+// triggers live on the always list, and triggers which must run
+// regardless of players (repeat delay counting down, activated
+// independent triggers) are carried over from tic to tic on the busy
+// list.
+//
+// Candidates are run in active_triggers order (index_order), so the
+// behaviour is identical to walking the whole list.
+//
+
+static float rts_grid_x, rts_grid_y;
+static float rts_grid_cell;
+static int   rts_grid_w, rts_grid_h;
+
+static std::vector< std::vector<rad_trigger_t *> > rts_grid;
+
+static std::vector<rad_trigger_t *> rts_always_trigs;
+static std::vector<rad_trigger_t *> rts_busy_trigs;
+static std::vector<rad_trigger_t *> rts_candidates;
+
+static int rts_index_stamp;
+
+
+static inline bool TriggerIsAlways(const rad_script_t *scr)
+{
+	return scr->tagged_immediate || scr->rad_x < 0 || scr->rad_y < 0;
+}
+
+static inline bool TriggerIsBusy(const rad_trigger_t *trig)
+{
+	return (trig->repeat_delay > 0) ||
+		(trig->info->tagged_independent && trig->activated);
+}
+
+static inline int GridCellX(float x)
+{
+	int cx = (int)floor((x - rts_grid_x) / rts_grid_cell);
+
+	return MAX(0, MIN(rts_grid_w - 1, cx));
+}
+
+static inline int GridCellY(float y)
+{
+	int cy = (int)floor((y - rts_grid_y) / rts_grid_cell);
+
+	return MAX(0, MIN(rts_grid_h - 1, cy));
+}
+
+static bool GridTriggerCells(const rad_script_t *scr,
+		int *cx1, int *cy1, int *cx2, int *cy2)
+{
+	if (rts_grid.empty() || TriggerIsAlways(scr))
+		return false;
+
+	*cx1 = GridCellX(scr->x - scr->rad_x);
+	*cx2 = GridCellX(scr->x + scr->rad_x);
+	*cy1 = GridCellY(scr->y - scr->rad_y);
+	*cy2 = GridCellY(scr->y + scr->rad_y);
+
+	return (*cx2 - *cx1 + 1) * (*cy2 - *cy1 + 1) <= RTS_MAX_TRIG_CELLS;
+}
+
+static void RemoveFromList(std::vector<rad_trigger_t *>& list,
+		rad_trigger_t *trig)
+{
+	std::vector<rad_trigger_t *>::iterator it =
+		std::find(list.begin(), list.end(), trig);
+
+	if (it != list.end())
+		list.erase(it);
+}
+
+static void RAD_ClearIndex(void)
+{
+	rts_grid.clear();
+	rts_grid_w = rts_grid_h = 0;
+
+	rts_always_trigs.clear();
+	rts_busy_trigs.clear();
+	rts_candidates.clear();
+}
+
+static void RAD_UnindexTrigger(rad_trigger_t *trig)
+{
+	int cx1, cy1, cx2, cy2;
+
+	if (GridTriggerCells(trig->info, &cx1, &cy1, &cx2, &cy2))
+	{
+		for (int cy = cy1; cy <= cy2; cy++)
+		for (int cx = cx1; cx <= cx2; cx++)
+			RemoveFromList(rts_grid[cy * rts_grid_w + cx], trig);
+	}
+	else
+		RemoveFromList(rts_always_trigs, trig);
+
+	RemoveFromList(rts_busy_trigs, trig);
+}
+
+//
+// RAD_IndexTriggers
+//
+// (Re)builds the spatial index from the active_triggers list.  Must be
+// called whenever the list is created from scratch (level start and
+// loading a savegame).
+//
+void RAD_IndexTriggers(void)
+{
+	rad_trigger_t *trig;
+	int order = 0;
+
+	RAD_ClearIndex();
+
+	// compute grid bounds from the radius boxes
+	float x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+	bool any = false;
+
+	for (trig = active_triggers; trig; trig = trig->next)
+	{
+		const rad_script_t *scr = trig->info;
+
+		trig->index_order = order++;
+		trig->index_stamp = rts_index_stamp;
+
+		if (TriggerIsAlways(scr))
+			continue;
+
+		if (! any)
+		{
+			x1 = scr->x - scr->rad_x;  x2 = scr->x + scr->rad_x;
+			y1 = scr->y - scr->rad_y;  y2 = scr->y + scr->rad_y;
+			any = true;
+			continue;
+		}
+
+		x1 = MIN(x1, scr->x - scr->rad_x);
+		x2 = MAX(x2, scr->x + scr->rad_x);
+		y1 = MIN(y1, scr->y - scr->rad_y);
+		y2 = MAX(y2, scr->y + scr->rad_y);
+	}
+
+	if (any)
+	{
+		rts_grid_cell = RTS_CELL_SIZE;
+
+		while ((x2 - x1) / rts_grid_cell >= RTS_MAX_GRID_DIM ||
+		       (y2 - y1) / rts_grid_cell >= RTS_MAX_GRID_DIM)
+		{
+			rts_grid_cell *= 2.0f;
+		}
+
+		rts_grid_x = x1;
+		rts_grid_y = y1;
+		rts_grid_w = 1 + (int)((x2 - x1) / rts_grid_cell);
+		rts_grid_h = 1 + (int)((y2 - y1) / rts_grid_cell);
+
+		rts_grid.resize(rts_grid_w * rts_grid_h);
+	}
+
+	for (trig = active_triggers; trig; trig = trig->next)
+	{
+		int cx1, cy1, cx2, cy2;
+
+		if (GridTriggerCells(trig->info, &cx1, &cy1, &cx2, &cy2))
+		{
+			for (int cy = cy1; cy <= cy2; cy++)
+			for (int cx = cx1; cx <= cx2; cx++)
+				rts_grid[cy * rts_grid_w + cx].push_back(trig);
+		}
+		else
+			rts_always_trigs.push_back(trig);
+
+		if (TriggerIsBusy(trig))
+			rts_busy_trigs.push_back(trig);
+	}
+
+	L_WriteDebug("RTS: indexed %d triggers (%dx%d grid, %d always)\n",
+			order, rts_grid_w, rts_grid_h, (int)rts_always_trigs.size());
+}
+
+static inline void AddCandidate(rad_trigger_t *trig)
+{
+	if (trig->index_stamp == rts_index_stamp)
+		return;
+
+	trig->index_stamp = rts_index_stamp;
+	rts_candidates.push_back(trig);
+}
+
+static bool CandidateOrder(const rad_trigger_t *A, const rad_trigger_t *B)
+{
+	return A->index_order < B->index_order;
+}
+
+//
+// Collects every trigger which could possibly do something this tic,
+// sorted into active_triggers order.
+//
+static void RAD_CollectCandidates(void)
+{
+	rts_index_stamp++;
+	rts_candidates.clear();
+
+	for (size_t i = 0; i < rts_always_trigs.size(); i++)
+		AddCandidate(rts_always_trigs[i]);
+
+	for (size_t i = 0; i < rts_busy_trigs.size(); i++)
+		AddCandidate(rts_busy_trigs[i]);
+
+	rts_busy_trigs.clear();
+
+	if (! rts_grid.empty())
+	{
+		for (int pnum = 0; pnum < MAXPLAYERS; pnum++)
+		{
+			player_t *p = players[pnum];
+
+			if (! p || p->playerstate == PST_DEAD || ! p->mo)
+				continue;
+
+			mobj_t *mo = p->mo;
+
+			int cx1 = GridCellX(mo->x - mo->radius);
+			int cx2 = GridCellX(mo->x + mo->radius);
+			int cy1 = GridCellY(mo->y - mo->radius);
+			int cy2 = GridCellY(mo->y + mo->radius);
+
+			for (int cy = cy1; cy <= cy2; cy++)
+			for (int cx = cx1; cx <= cx2; cx++)
+			{
+				std::vector<rad_trigger_t *>& cell = rts_grid[cy * rts_grid_w + cx];
+
+				for (size_t i = 0; i < cell.size(); i++)
+					AddCandidate(cell[i]);
+			}
+		}
+	}
+
+	std::sort(rts_candidates.begin(), rts_candidates.end(), CandidateOrder);
+}
+
+
 static void DoRemoveTrigger(rad_trigger_t *trig)
 {
+	RAD_UnindexTrigger(trig);
+
 	// handle tag linkage
 	if (trig->tag_next)
 		trig->tag_next->tag_prev = trig->tag_prev;
@@ -548,151 +808,170 @@ static void DoRemoveTrigger(rad_trigger_t *trig)
 }
 
 //
-// Radius Trigger Event handler.
+// Runs a single trigger for this tic.  Returns false if the trigger
+// finished and was removed.
 //
-void RAD_RunTriggers(void)
+static bool RAD_RunOneTrigger(rad_trigger_t *trig)
 {
-	rad_trigger_t *trig, *next;
+	// Don't process, if disabled
+	if (trig->disabled)
+		return true;
 
-	// Start looking through the trigger list.
-	for (trig=active_triggers; trig; trig=next)
+	// Handle repeat delay (from TAGGED_REPEATABLE).  This must be
+	// done *before* all the condition checks, and that's what makes
+	// it different from `wait_tics'.
+	//
+	if (trig->repeat_delay > 0)
 	{
-		next = trig->next;
+		trig->repeat_delay--;
+		return true;
+	}
 
-		// stop running all triggers when an RTS menu becomes active
-		if (rts_menuactive)
-			break;
+	// Independent, means you don't have to stay within the trigger
+	// radius for it to operate, It will operate on it's own.
 
-		// Don't process, if disabled
-		if (trig->disabled)
-			continue;
+	if (! (trig->info->tagged_independent && trig->activated))
+	{
+		int mask = RAD_AlivePlayers();
 
-		// Handle repeat delay (from TAGGED_REPEATABLE).  This must be
-		// done *before* all the condition checks, and that's what makes
-		// it different from `wait_tics'.
+		// Immediate triggers are just that. Immediate.
+		// Not within range so skip it.
 		//
-		if (trig->repeat_delay > 0)
+		if (!trig->info->tagged_immediate)
 		{
-			trig->repeat_delay--;
-			continue;
+			mask = RAD_AllPlayersInRadius(trig->info, mask);
+			if (mask == 0)
+				return true;
 		}
 
-		// Independent, means you don't have to stay within the trigger
-		// radius for it to operate, It will operate on it's own.
-
-		if (! (trig->info->tagged_independent && trig->activated))
+		// Check for use key trigger.
+		if (trig->info->tagged_use)
 		{
-			int mask = RAD_AlivePlayers();
-
-			// Immediate triggers are just that. Immediate.
-			// Not within range so skip it.
-			//
-            if (!trig->info->tagged_immediate)
-            {
-                mask = RAD_AllPlayersInRadius(trig->info, mask);
-                if (mask == 0)
-                    continue;
-            }
-
-            // Check for use key trigger.
-            if (trig->info->tagged_use)
-            {
-                mask = RAD_AllPlayersUsing(mask);
-                if (mask == 0)
-                    continue;
-            }
-
-			// height check...
-			if (trig->info->height_trig)
-			{
-				s_onheight_t *cur;
-
-				for (cur=trig->info->height_trig; cur; cur=cur->next)
-					if (! RAD_CheckHeightTrig(trig, cur))
-						break;
+			mask = RAD_AllPlayersUsing(mask);
+			if (mask == 0)
+				return true;
+		}
 
-				// if they all succeeded, then cur will be NULL...
-				if (cur)
-					continue;
-			}
+		// height check...
+		if (trig->info->height_trig)
+		{
+			s_onheight_t *cur;
 
-			// ondeath check...
-			if (trig->info->boss_trig)
-			{
-				s_ondeath_t *cur;
+			for (cur=trig->info->height_trig; cur; cur=cur->next)
+				if (! RAD_CheckHeightTrig(trig, cur))
+					break;
 
-				for (cur=trig->info->boss_trig; cur; cur=cur->next)
-					if (! RAD_CheckBossTrig(trig, cur))
-						break;
+			// if they all succeeded, then cur will be NULL...
+			if (cur)
+				return true;
+		}
 
-				// if they all succeeded, then cur will be NULL...
-				if (cur)
-					continue;
-			}
+		// ondeath check...
+		if (trig->info->boss_trig)
+		{
+			s_ondeath_t *cur;
 
-			// condition check...
-			if (trig->info->cond_trig)
-			{
-                mask = RAD_AllPlayersCheckCond(trig->info, mask);
-                if (mask == 0)
-                    continue;
-			}
+			for (cur=trig->info->boss_trig; cur; cur=cur->next)
+				if (! RAD_CheckBossTrig(trig, cur))
+					break;
 
-			trig->activated = true;
-			trig->acti_players = mask;
+			// if they all succeeded, then cur will be NULL...
+			if (cur)
+				return true;
 		}
 
-		// If we are waiting, decrement count and skip it.
-		// Note that we must do this *after* all the condition checks.
-		//
-		if (trig->wait_tics > 0)
+		// condition check...
+		if (trig->info->cond_trig)
 		{
-			trig->wait_tics--;
-			continue;
+			mask = RAD_AllPlayersCheckCond(trig->info, mask);
+			if (mask == 0)
+				return true;
 		}
 
-		// Waiting until monsters are dead?
-		while (trig->wait_tics == 0 && trig->wud_count <= 0)
-		{
-			// Execute current command
-			rts_state_t *state = trig->state;
-			SYS_ASSERT(state);
+		trig->activated = true;
+		trig->acti_players = mask;
+	}
 
-			// move to next state.  We do this NOW since the action itself
-			// may want to change the trigger's state (to support GOTO type
-			// actions and other possibilities).
-			//
-			trig->state = trig->state->next;
+	// If we are waiting, decrement count and skip it.
+	// Note that we must do this *after* all the condition checks.
+	//
+	if (trig->wait_tics > 0)
+	{
+		trig->wait_tics--;
+		return true;
+	}
 
-			(*state->action)(trig, state->param);
+	// Waiting until monsters are dead?
+	while (trig->wait_tics == 0 && trig->wud_count <= 0)
+	{
+		// Execute current command
+		rts_state_t *state = trig->state;
+		SYS_ASSERT(state);
 
-			if (! trig->state)
-				break;
+		// move to next state.  We do this NOW since the action itself
+		// may want to change the trigger's state (to support GOTO type
+		// actions and other possibilities).
+		//
+		trig->state = trig->state->next;
 
-			trig->wait_tics += trig->state->tics;
-			
-			if (trig->disabled || rts_menuactive)
-				break;
-		}
+		(*state->action)(trig, state->param);
 
-		if (trig->state)
-			continue;
+		if (! trig->state)
+			break;
 
-		// we've reached the end of the states.  Delete the trigger unless
-		// it is Tagged_Repeatable and has some more repeats left.
-		//
-		if (trig->info->repeat_count != REPEAT_FOREVER)
-			trig->repeats_left--;
+		trig->wait_tics += trig->state->tics;
+		
+		if (trig->disabled || rts_menuactive)
+			break;
+	}
+
+	if (trig->state)
+		return true;
 
-		if (trig->repeats_left > 0)
+	// we've reached the end of the states.  Delete the trigger unless
+	// it is Tagged_Repeatable and has some more repeats left.
+	//
+	if (trig->info->repeat_count != REPEAT_FOREVER)
+		trig->repeats_left--;
+
+	if (trig->repeats_left > 0)
+	{
+		trig->state = trig->info->first_state;
+		trig->wait_tics = trig->state->tics;
+		trig->repeat_delay = trig->info->repeat_delay;
+		return true;
+	}
+
+	DoRemoveTrigger(trig);
+	return false;
+}
+
+//
+// Radius Trigger Event handler.
+//
+// Only the candidates from the spatial index are looked at, the rest
+// cannot do anything this tic (see RAD_IndexTriggers).
+//
+void RAD_RunTriggers(void)
+{
+	RAD_CollectCandidates();
+
+	for (size_t i = 0; i < rts_candidates.size(); i++)
+	{
+		rad_trigger_t *trig = rts_candidates[i];
+
+		// stop running all triggers when an RTS menu becomes active
+		if (rts_menuactive)
 		{
-			trig->state = trig->info->first_state;
-			trig->wait_tics = trig->state->tics;
-			trig->repeat_delay = trig->info->repeat_delay;
-			continue;
+			// keep the busy triggers we did not get to
+			for (; i < rts_candidates.size(); i++)
+				if (TriggerIsBusy(rts_candidates[i]))
+					rts_busy_trigs.push_back(rts_candidates[i]);
+			break;
 		}
 
-		DoRemoveTrigger(trig);
+		if (RAD_RunOneTrigger(trig) && TriggerIsBusy(trig))
+			rts_busy_trigs.push_back(trig);
 	}
 }
 
@@ -807,6 +1086,8 @@ void RAD_SpawnTriggers(const char *map_name)
 
 		active_triggers = trig;
 	}
+
+	RAD_IndexTriggers();
 }
 
 
@@ -844,6 +1125,7 @@ void RAD_ClearTriggers(void)
 		Z_Free(trig);
 	}
 
+	RAD_ClearIndex();
 	RAD_ClearCachedInfo();
 	RAD_ResetTips();
 }
@@ -39,6 +39,7 @@ void RAD_LoadFile(const char *name);
 void RAD_SpawnTriggers(const char *map_name);
 void RAD_ClearTriggers(void);
 void RAD_GroupTriggerTags(rad_trigger_t *trig);
+void RAD_IndexTriggers(void);
 
 void RAD_RunTriggers(void);
 void RAD_Ticker(void);
@@ -24,7 +24,11 @@
 //----------------------------------------------------------------------------
 
 #include "system/i_defs.h"
+#include "system/i_thread.h"
 
+#include <algorithm>
+#include <list>
+#include <unordered_map>
 #include <vector>
 
 #include "../epi/file.h"
@@ -45,6 +49,8 @@
 #include "m_argv.h"
 #include "m_misc.h"
 #include "m_random.h"
+#include "p_action.h"
+#include "p_local.h"
 #include "p_mobj.h"
 #include "r_defs.h"
 #include "w_wad.h"
@@ -53,7 +59,57 @@
 extern int dev_freq;
 
 
-static std::vector<epi::sound_data_c *> fx_cache;
+// memory for decoded sound effects (in megabytes).  Effects which are
+// not playing are freed, least recently used first, above this.
+DEF_CVAR(s_cachemem, int, "c", 32);
+
+
+typedef enum
+{
+	FXS_Ready = 0,
+	FXS_Decoding,   // a worker is decoding the raw data
+	FXS_Decoded     // ... and has finished, see FinishDecode()
+}
+fx_state_e;
+
+typedef struct fx_entry_s
+{
+	sfxdef_c *def;
+
+	epi::sound_data_c *buf;
+
+	std::atomic<int> state;
+
+	// raw file data, only kept while decoding
+	byte *raw;
+	int raw_len;
+
+	bool decoded_ok;
+
+	// started by S_CachePreload(), size not yet charged
+	bool preload;
+
+	int bytes;
+
+	// position in fx_lru
+	std::list<struct fx_entry_s *>::iterator lru;
+}
+fx_entry_t;
+
+static std::unordered_map<const sfxdef_c *, fx_entry_t *> fx_cache;
+
+// all entries, least recently used first
+static std::list<fx_entry_t *> fx_lru;
+
+// entries which are being decoded
+static std::vector<fx_entry_t *> fx_decoding;
+
+static job_group_c *fx_jobs;
+
+static int fx_bytes;
+
+// decoded size of preloaded sounds, see S_CachePreloadDone()
+static int fx_preload_bytes;
 
 
 static void Load_Silence(epi::sound_data_c *buf)
@@ -132,16 +188,36 @@ void S_FlushData(epi::sound_data_c *fx)
 	fx->Free();
 }
 
+static void FreeEntry(fx_entry_t *E)
+{
+	fx_bytes -= E->bytes;
+
+	delete[] E->raw;
+	delete E->buf;
+	delete E;
+}
+
 void S_CacheClearAll(void)
 {
-	for (int i = 0; i < (int)fx_cache.size(); i++)
-		delete fx_cache[i];
+	// workers may still be writing into the buffers
+	if (fx_jobs)
+		fx_jobs->Wait();
+
+	std::unordered_map<const sfxdef_c *, fx_entry_t *>::iterator it;
+
+	for (it = fx_cache.begin(); it != fx_cache.end(); it++)
+		FreeEntry(it->second);
+
+	fx_cache.clear();
+	fx_lru.clear();
+	fx_decoding.clear();
 
-	fx_cache.erase(fx_cache.begin(), fx_cache.end());
+	fx_bytes = 0;
+	fx_preload_bytes = 0;
 }
 
 
-static bool DoCacheLoad(sfxdef_c *def, epi::sound_data_c *buf)
+static byte *ReadSoundData(sfxdef_c *def, int *length)
 {
 	I_Debugf("S_CacheLoad: [%s]\n", def->name.c_str());
 
@@ -157,7 +233,7 @@ static bool DoCacheLoad(sfxdef_c *def, epi::sound_data_c *buf)
 		if (! F)
 		{
 			M_WarnError("SFX Loader: Can't Find File '%s'\n", fn.c_str());
-			return false;
+			return NULL;
 		}
 	}
 	else 
@@ -166,26 +242,39 @@ static bool DoCacheLoad(sfxdef_c *def, epi::sound_data_c *buf)
 		if (lump < 0)
 		{
 			M_WarnError("SFX Loader: Missing sound lump: %s\n", def->lump_name.c_str());
-			return false;
+			return NULL;
 		}
 
 		F = W_OpenLump(lump);
 		SYS_ASSERT(F);
 	}
 	
-	int length = F->GetLength();
+	*length = F->GetLength();
 
 	byte *data = F->LoadIntoMemory();
 
 	// no longer need the epi::file_c
 	delete F; F = NULL;
 
-	if (! data || length < 4)
+	if (! data || *length < 4)
 	{
 		M_WarnError("SFX Loader: Error loading data.\n");
-		return false;
+
+		delete[] data;
+		return NULL;
 	}
 
+	return data;
+}
+
+static inline bool NeedsDecoding(byte *data, int length)
+{
+	// only the compressed formats are worth sending to a worker
+	return (memcmp(data, "Ogg", 3) == 0) || S_CheckMP3(data, length);
+}
+
+static bool DecodeSound(epi::sound_data_c *buf, byte *data, int length)
+{
 	// Load the data into the buffer
 
 	bool OK = false;
@@ -200,36 +289,221 @@ static bool DoCacheLoad(sfxdef_c *def, epi::sound_data_c *buf)
 		OK = Load_MP3(buf, data, length);
 	else
 		OK = Load_DOOM(buf, data, length);
-		// Tag sound as SFX for environmental effects - Dasho
-	if (OK)
-		buf->is_sfx = true;
 
 	return OK;
 }
 
-epi::sound_data_c *S_CacheLoad(sfxdef_c *def)
+static void DecodeJob(void *data)
+{
+	fx_entry_t *E = (fx_entry_t *)data;
+
+	E->decoded_ok = DecodeSound(E->buf, E->raw, E->raw_len);
+
+	E->state.store(FXS_Decoded);
+}
+
+static inline int BufferBytes(const epi::sound_data_c *buf)
+{
+	int bytes = buf->length * sizeof(s16_t);
+
+	if (buf->mode != epi::SBUF_Mono)
+		bytes *= 2;
+
+	// the copy made by Mix_Reverb() and friends is the same size
+	return bytes * 2;
+}
+
+static void TrimCache(const fx_entry_t *keep)
+{
+	int budget = MAX(1, s_cachemem) * 1024 * 1024;
+
+	// free the least recently used effects which are not playing
+	std::list<fx_entry_t *>::iterator it = fx_lru.begin();
+
+	while (fx_bytes > budget && it != fx_lru.end())
+	{
+		fx_entry_t *E = *it;
+
+		if (E == keep || E->buf->ref_count > 0 || E->state.load() != FXS_Ready)
+		{
+			it++;
+			continue;
+		}
+
+		it = fx_lru.erase(it);
+
+		fx_cache.erase(E->def);
+
+		FreeEntry(E);
+	}
+}
+
+static void FinishLoad(fx_entry_t *E, bool OK)
+{
+	if (! OK)
+		Load_Silence(E->buf);
+
+	// Tag sound as SFX for environmental effects - Dasho
+	E->buf->is_sfx = true;
+
+	E->bytes = BufferBytes(E->buf);
+	fx_bytes += E->bytes;
+
+	if (E->preload)
+		fx_preload_bytes += E->bytes;
+
+	E->state.store(FXS_Ready);
+
+	TrimCache(E);
+}
+
+static void FinishDecode(fx_entry_t *E)
+{
+	delete[] E->raw;
+
+	E->raw = NULL;
+	E->raw_len = 0;
+
+	if (! E->decoded_ok)
+		M_WarnError("SFX Loader: Error decoding sound: %s\n", E->def->name.c_str());
+
+	FinishLoad(E, E->decoded_ok);
+}
+
+//
+// S_CacheUpdate
+//
+void S_CacheUpdate(void)
 {
-	for (int i = 0; i < (int)fx_cache.size(); i++)
+	for (size_t i = 0; i < fx_decoding.size(); )
 	{
-		if (fx_cache[i]->priv_data == (void*)def)
+		fx_entry_t *E = fx_decoding[i];
+
+		if (E->state.load() != FXS_Decoded)
 		{
-			fx_cache[i]->ref_count++;
-			return fx_cache[i];
+			i++;
+			continue;
 		}
+
+		FinishDecode(E);
+
+		fx_decoding.erase(fx_decoding.begin() + i);
 	}
+}
+
+static fx_entry_t *StartLoad(sfxdef_c *def, bool async)
+{
+	fx_entry_t *E = new fx_entry_t;
 
 	// create data structure
-	epi::sound_data_c *buf = new epi::sound_data_c();
+	E->def = def;
+	E->buf = new epi::sound_data_c();
+	E->buf->priv_data = def;
+
+	E->state.store(FXS_Ready);
+
+	E->raw = NULL;
+	E->raw_len = 0;
+	E->decoded_ok = false;
+	E->preload = false;
+	E->bytes = 0;
 
-	fx_cache.push_back(buf);
+	fx_cache[def] = E;
 
-	buf->priv_data = def;
-	buf->ref_count = 1;
+	E->lru = fx_lru.insert(fx_lru.end(), E);
 
-	if (! DoCacheLoad(def, buf))
-		Load_Silence(buf);	
+	int length;
+	byte *data = ReadSoundData(def, &length);
 
-	return buf;
+	if (! data)
+	{
+		FinishLoad(E, false);
+		return E;
+	}
+
+	if (async && I_NumWorkers() > 0 && NeedsDecoding(data, length))
+	{
+		E->raw = data;
+		E->raw_len = length;
+
+		E->state.store(FXS_Decoding);
+
+		fx_decoding.push_back(E);
+
+		if (! fx_jobs)
+			fx_jobs = new job_group_c;
+
+		fx_jobs->Add(DecodeJob, E);
+		return E;
+	}
+
+	bool OK = DecodeSound(E->buf, data, length);
+
+	delete[] data;
+
+	FinishLoad(E, OK);
+	return E;
+}
+
+static fx_entry_t *LookupEntry(const sfxdef_c *def)
+{
+	std::unordered_map<const sfxdef_c *, fx_entry_t *>::iterator it;
+
+	it = fx_cache.find(def);
+
+	if (it == fx_cache.end())
+		return NULL;
+
+	return it->second;
+}
+
+epi::sound_data_c *S_CacheLoad(sfxdef_c *def)
+{
+	fx_entry_t *E = LookupEntry(def);
+
+	if (! E)
+		E = StartLoad(def, true);
+	else
+		fx_lru.splice(fx_lru.end(), fx_lru, E->lru);
+
+	E->buf->ref_count++;
+
+	return E->buf;
+}
+
+bool S_CacheReady(epi::sound_data_c *data)
+{
+	fx_entry_t *E = LookupEntry((const sfxdef_c *) data->priv_data);
+
+	SYS_ASSERT(E && E->buf == data);
+
+	if (E->state.load() == FXS_Decoded)
+		S_CacheUpdate();
+
+	return E->state.load() == FXS_Ready;
+}
+
+int S_CachePreload(sfxdef_c *def)
+{
+	if (LookupEntry(def))
+		return 0;
+
+	fx_entry_t *E = StartLoad(def, true);
+
+	if (E->state.load() == FXS_Ready)
+		return E->bytes;
+
+	// charged by S_CachePreloadDone() once the decode has finished
+	E->preload = true;
+	return 0;
+}
+
+int S_CachePreloadDone(void)
+{
+	int bytes = fx_preload_bytes;
+
+	fx_preload_bytes = 0;
+	return bytes;
 }
 
 void S_CacheRelease(epi::sound_data_c *data)
@@ -239,5 +513,117 @@ void S_CacheRelease(epi::sound_data_c *data)
 	data->ref_count--;
 }
 
+
+static void AddLevelSound(std::vector<sfxdef_c *>& list, const struct sfx_s *sfx)
+{
+	if (! sfx)
+		return;
+
+	for (int i = 0; i < sfx->num; i++)
+		list.push_back(sfxdefs[sfx->sounds[i]]);
+}
+
+static void AddAttackSounds(std::vector<sfxdef_c *>& list, const atkdef_c *atk)
+{
+	if (! atk)
+		return;
+
+	AddLevelSound(list, atk->initsound);
+	AddLevelSound(list, atk->sound);
+}
+
+//
+// S_PrecacheLevel
+//
+// Starts loading the sounds which the things of the level can make:
+// their own sounds, their attacks, and the PLAYSOUND actions of their
+// states.  The compressed ones are decoded on the worker threads.
+//
+void S_PrecacheLevel(void)
+{
+	if (nosound)
+		return;
+
+	std::vector<const mobjtype_c *> types;
+
+	for (mobj_t *mo = mobjlisthead; mo; mo = mo->next)
+		types.push_back(mo->info);
+
+	std::sort(types.begin(), types.end());
+	types.erase(std::unique(types.begin(), types.end()), types.end());
+
+	std::vector<sfxdef_c *> list;
+
+	for (size_t i = 0; i < types.size(); i++)
+	{
+		const mobjtype_c *info = types[i];
+
+		AddLevelSound(list, info->seesound);
+		AddLevelSound(list, info->attacksound);
+		AddLevelSound(list, info->painsound);
+		AddLevelSound(list, info->deathsound);
+		AddLevelSound(list, info->overkill_sound);
+		AddLevelSound(list, info->activesound);
+		AddLevelSound(list, info->walksound);
+		AddLevelSound(list, info->jump_sound);
+		AddLevelSound(list, info->noway_sound);
+		AddLevelSound(list, info->oof_sound);
+		AddLevelSound(list, info->gasp_sound);
+		AddLevelSound(list, info->falling_sound);
+
+		AddAttackSounds(list, info->closecombat);
+		AddAttackSounds(list, info->rangeattack);
+		AddAttackSounds(list, info->spareattack);
+
+		for (size_t g = 0; g < info->state_grp.size(); g++)
+		{
+			const state_range_t& range = info->state_grp[g];
+
+			for (int st = range.first; st <= range.last; st++)
+			{
+				if (states[st].action == P_ActPlaySound)
+					AddLevelSound(list, (const struct sfx_s *) states[st].action_par);
+			}
+		}
+	}
+
+	std::sort(list.begin(), list.end());
+	list.erase(std::unique(list.begin(), list.end()), list.end());
+
+	int count = 0;
+
+	for (size_t i = 0; i < list.size(); i++)
+	{
+		if (! LookupEntry(list[i]))
+		{
+			StartLoad(list[i], true);
+			count++;
+		}
+	}
+
+	I_Debugf("S_PrecacheLevel: %d sounds used, %d loading, %d KB cached\n",
+			 (int)list.size(), count, fx_bytes / 1024);
+}
+
+//
+// S_ShowCacheInfo
+//
+void S_ShowCacheInfo(void)
+{
+	int playing = 0;
+
+	std::unordered_map<const sfxdef_c *, fx_entry_t *>::iterator it;
+
+	for (it = fx_cache.begin(); it != fx_cache.end(); it++)
+	{
+		if (it->second->buf->ref_count > 0)
+			playing++;
+	}
+
+	I_Printf("Sound cache: %d effects (%d in use, %d decoding), %d KB of %d MB\n",
+			 (int)fx_cache.size(), playing, (int)fx_decoding.size(),
+			 fx_bytes / 1024, s_cachemem);
+}
+
 //--- editor settings ---
 // vi:ts=4:sw=4:noexpandtab
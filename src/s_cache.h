@@ -43,11 +43,38 @@ epi::sound_data_c *S_CacheLoad(sfxdef_c *def);
 // been loaded, then it is simply returned (increasing the
 // reference count).  Returns NULL if the lump doesn't exist.
 
+// Compressed sounds (OGG and MP3) are decoded on a worker thread.
+// Until S_CacheReady() returns true the buffer must not be used.
+
+bool S_CacheReady(epi::sound_data_c *data);
+// check whether a sound returned by S_CacheLoad has been decoded.
+
+void S_CacheUpdate(void);
+// finish off sounds which the workers have decoded.  Called every
+// tic by the sound ticker.
+
 void S_CacheRelease(epi::sound_data_c *data);
 // we are finished with this data.  The cache system may
 // free the memory when the number of references drops to 0.
 // Typically though the sound is kept, as it will likely
-// be needed again shortly.
+// be needed again shortly.  Sounds which are not playing are
+// freed (least recently used first) when the cache grows beyond
+// s_cachemem megabytes.
+
+int S_CachePreload(sfxdef_c *def);
+// start loading a sound without using it.  Returns the number of
+// bytes it costs, or 0 if it was already in the cache or is still
+// being decoded.
+
+int S_CachePreloadDone(void);
+// returns the decoded size of the preloaded sounds which have
+// finished decoding since the last call.
+
+void S_PrecacheLevel(void);
+// start loading the sounds used by the things in the level.
+
+void S_ShowCacheInfo(void);
+// print the size of the cache to the console.
 
 #endif /* __S_CACHE_H__ */
 
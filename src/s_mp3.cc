@@ -24,6 +24,7 @@
 //
 
 #include "system/i_defs.h"
+#include "system/i_thread.h"
 
 #include "epi/endianess.h"
 #include "epi/file.h"
@@ -379,17 +380,21 @@ bool S_LoadMP3Sound(epi::sound_data_c *buf, const byte *data, int length)
 
     if (mp3dec_load_buf(&mp3_sound, data, length, &sound_info, NULL, NULL) != 0)
     {
-		I_Warning("Failed to load MP3 sound (corrupt mp3?)\n");
+		if (I_IsMainThread())
+			I_Warning("Failed to load MP3 sound (corrupt mp3?)\n");
  
 		return false;
     }
 
-	I_Debugf("MP3 SFX Loader: freq %d Hz, %d channels\n",
-			 sound_info.hz, sound_info.channels);
+	// (decoding may happen on a worker, which must not print)
+	if (I_IsMainThread())
+		I_Debugf("MP3 SFX Loader: freq %d Hz, %d channels\n",
+				 sound_info.hz, sound_info.channels);
 
 	if (sound_info.channels > 2)
 	{
-		I_Warning("MP3 SFX Loader: too many channels: %d\n", sound_info.channels);
+		if (I_IsMainThread())
+			I_Warning("MP3 SFX Loader: too many channels: %d\n", sound_info.channels);
 
 		free(sound_info.buffer);
 
@@ -398,7 +403,10 @@ bool S_LoadMP3Sound(epi::sound_data_c *buf, const byte *data, int length)
 
 	if (sound_info.samples <= 0) // I think the initial loading would fail if this were the case, but just as a sanity check - Dasho
 	{
-		I_Error("MP3 SFX Loader: no samples!\n");
+		if (I_IsMainThread())
+			I_Error("MP3 SFX Loader: no samples!\n");
+
+		free(sound_info.buffer);
 		return false;
 	}
 
@@ -414,12 +422,14 @@ bool S_LoadMP3Sound(epi::sound_data_c *buf, const byte *data, int length)
 
 	gather.CommitChunk(sound_info.samples);
 
-	if (! gather.Finalise(buf, false /* want_stereo */))
+	bool OK = gather.Finalise(buf, false /* want_stereo */);
+
+	if (! OK && I_IsMainThread())
 		I_Error("MP3 SFX Loader: no samples!\n");
 
 	free(sound_info.buffer);
 
-	return true;
+	return OK;
 }
 
 //--- editor settings ---
@@ -23,6 +23,7 @@
 //
 
 #include "system/i_defs.h"
+#include "system/i_thread.h"
 
 #include "../epi/endianess.h"
 #include "../epi/file.h"
@@ -584,7 +585,8 @@ bool S_LoadOGGSound(epi::sound_data_c *buf, const byte *data, int length)
 
     if (result < 0)
     {
-		I_Warning("Failed to load OGG sound (corrupt ogg?) error=%d\n", result);
+		if (I_IsMainThread())
+			I_Warning("Failed to load OGG sound (corrupt ogg?) error=%d\n", result);
 
 		// Only time we have to kill this since OGG will deal with
 		// the handle when ov_open_callbacks() succeeds
@@ -596,12 +598,15 @@ bool S_LoadOGGSound(epi::sound_data_c *buf, const byte *data, int length)
 	vorbis_info *vorbis_inf = ov_info(&ogg_stream, -1);
 	SYS_ASSERT(vorbis_inf);
 
-	I_Debugf("OGG SFX Loader: freq %d Hz, %d channels\n",
-			 (int)vorbis_inf->rate, (int)vorbis_inf->channels);
+	// (decoding may happen on a worker, which must not print)
+	if (I_IsMainThread())
+		I_Debugf("OGG SFX Loader: freq %d Hz, %d channels\n",
+				 (int)vorbis_inf->rate, (int)vorbis_inf->channels);
 
 	if (vorbis_inf->channels > 2)
 	{
-		I_Warning("OGG Sfx Loader: too many channels: %d\n", vorbis_inf->channels);
+		if (I_IsMainThread())
+			I_Warning("OGG Sfx Loader: too many channels: %d\n", vorbis_inf->channels);
 
 		ogg_lump.size = 0;
 		ov_clear(&ogg_stream);
@@ -644,7 +649,8 @@ bool S_LoadOGGSound(epi::sound_data_c *buf, const byte *data, int length)
 		{
 			gather.DiscardChunk();
 
-			I_Warning("Problem occurred while loading OGG (%d)\n", got_size);
+			if (I_IsMainThread())
+				I_Warning("Problem occurred while loading OGG (%d)\n", got_size);
 			break;
 		}
 
@@ -653,7 +659,9 @@ bool S_LoadOGGSound(epi::sound_data_c *buf, const byte *data, int length)
 		gather.CommitChunk(got_size);
 	}
 
-	if (! gather.Finalise(buf, false /* want_stereo */))
+	bool OK = gather.Finalise(buf, false /* want_stereo */);
+
+	if (! OK && I_IsMainThread())
 		I_Error("OGG SFX Loader: no samples!\n");
 
 	// HACK: we must not free the data (in oggplayer_memclose)
@@ -661,7 +669,7 @@ bool S_LoadOGGSound(epi::sound_data_c *buf, const byte *data, int length)
 
 	ov_clear(&ogg_stream);
 
-	return true;
+	return OK;
 }
 
 //--- editor settings ---
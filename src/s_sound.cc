@@ -20,6 +20,8 @@
 #include "system/i_sdlinc.h"
 #include "system/i_sound.h"
 
+#include <vector>
+
 #include "dm_state.h"
 #include "m_argv.h"
 #include "m_misc.h"
@@ -364,7 +366,13 @@ static void S_PlaySound(int idx, sfxdef_c *def, int category, position_c *pos, i
 //I_Printf("FINISHED: delta=0x%lx\n", chan->delta);
 }
 
-static void DoStartFX(sfxdef_c *def, int category, position_c *pos, int flags, epi::sound_data_c *buf)
+//
+// DoStartFX
+//
+// Returns false when the sound was not played (the caller must then
+// release the buffer).
+//
+static bool DoStartFX(sfxdef_c *def, int category, position_c *pos, int flags, epi::sound_data_c *buf)
 {
 	CountPlayingCats();
 
@@ -379,17 +387,17 @@ static void DoStartFX(sfxdef_c *def, int category, position_c *pos, int flags, e
 		{
 //I_Printf("@@ RE-LOOPING\n");
 			chan->loop = true;
-			return;
+			return false;
 		}
 		else if (flags & FX_Single)
 		{
 			if (flags & FX_Precious)
-				return;
+				return false;
 
 //I_Printf("@@ Killing sound for SINGULAR\n");
 			S_KillChannel(k);
 			S_PlaySound(k, def, category, pos, flags, buf);
-			return;
+			return true;
 		}
 	}
 
@@ -426,13 +434,127 @@ static void DoStartFX(sfxdef_c *def, int category, position_c *pos, int flags, e
 
 //if (k<0) I_Printf("- new score too low\n");
 		if (k < 0)
-			return;
+			return false;
 
 //I_Printf("- killing channel %d (kill_cat:%d)  my_cat:%d\n", k, kill_cat, category);
 		S_KillChannel(k);
 	}
 
 	S_PlaySound(k, def, category, pos, flags, buf);
+	return true;
+}
+
+static void StartLoadedFX(sfxdef_c *def, int category, position_c *pos, int flags, epi::sound_data_c *buf)
+{
+	if (vacuum_sfx)
+		buf->Mix_Vacuum();
+	else if (submerged_sfx)
+		buf->Mix_Submerged();
+	else
+	{
+		if (ddf_reverb)
+			buf->Mix_Reverb(dynamic_reverb, room_area, outdoor_reverb, ddf_reverb_type, ddf_reverb_ratio, ddf_reverb_delay);
+		else
+			buf->Mix_Reverb(dynamic_reverb, room_area, outdoor_reverb, 0, 0, 0);
+	}
+
+	bool played;
+
+	I_LockAudio();
+	{
+		played = DoStartFX(def, category, pos, flags, buf);
+	}
+	I_UnlockAudio();
+
+	if (! played)
+		S_CacheRelease(buf);
+}
+
+
+// sounds waiting for a worker to decode them.  They are started by
+// the sound ticker once ready, or dropped if that takes too long.
+typedef struct
+{
+	sfxdef_c *def;
+	int category;
+	position_c *pos;
+	int flags;
+
+	epi::sound_data_c *buf;
+
+	u32_t queued;  // I_ReadMicroSeconds() when S_StartFX was called
+}
+pending_fx_t;
+
+static std::vector<pending_fx_t> pending_fx;
+
+#define PENDING_FX_MAX_US  250000
+
+static void QueuePendingFX(sfxdef_c *def, int category, position_c *pos, int flags, epi::sound_data_c *buf)
+{
+	for (size_t i = 0; i < pending_fx.size(); i++)
+	{
+		if (pending_fx[i].def == def && pending_fx[i].pos == pos)
+		{
+			S_CacheRelease(buf);
+			return;
+		}
+	}
+
+	pending_fx_t P;
+
+	P.def = def;
+	P.category = category;
+	P.pos = pos;
+	P.flags = flags;
+	P.buf = buf;
+	P.queued = I_ReadMicroSeconds();
+
+	pending_fx.push_back(P);
+}
+
+static void StartPendingFX(void)
+{
+	S_CacheUpdate();
+
+	u32_t now = I_ReadMicroSeconds();
+
+	for (size_t i = 0; i < pending_fx.size(); )
+	{
+		pending_fx_t P = pending_fx[i];
+
+		if (S_CacheReady(P.buf))
+		{
+			pending_fx.erase(pending_fx.begin() + i);
+
+			StartLoadedFX(P.def, P.category, P.pos, P.flags, P.buf);
+		}
+		else if (now - P.queued > PENDING_FX_MAX_US)
+		{
+			pending_fx.erase(pending_fx.begin() + i);
+
+			S_CacheRelease(P.buf);
+		}
+		else
+			i++;
+	}
+}
+
+static void DropPendingFX(position_c *pos, bool all_level)
+{
+	for (size_t i = 0; i < pending_fx.size(); )
+	{
+		pending_fx_t& P = pending_fx[i];
+
+		if (all_level ? (P.category != SNCAT_UI) : (P.pos == pos))
+		{
+			S_CacheRelease(P.buf);
+
+			pending_fx.erase(pending_fx.begin() + i);
+		}
+		else
+			i++;
+	}
 }
 
 
@@ -474,22 +596,14 @@ void S_StartFX(sfx_t *sfx, int category, position_c *pos, int flags)
 	if (! buf)
 		return;	
 
-	if (vacuum_sfx)
-		buf->Mix_Vacuum();
-	else if (submerged_sfx)
-		buf->Mix_Submerged();
-	else
-	{
-		if (ddf_reverb)
-			buf->Mix_Reverb(dynamic_reverb, room_area, outdoor_reverb, ddf_reverb_type, ddf_reverb_ratio, ddf_reverb_delay);
-		else
-			buf->Mix_Reverb(dynamic_reverb, room_area, outdoor_reverb, 0, 0, 0);
-	}
-	I_LockAudio();
+	// still being decoded?  Start it on a later tic instead of waiting.
+	if (! S_CacheReady(buf))
 	{
-		DoStartFX(def, category, pos, flags, buf);
+		QueuePendingFX(def, category, pos, flags, buf);
+		return;
 	}
-	I_UnlockAudio();
+
+	StartLoadedFX(def, category, pos, flags, buf);
 }
 
 
@@ -497,6 +611,8 @@ void S_StopFX(position_c *pos)
 {
 	if (nosound) return;
 
+	DropPendingFX(pos, false);
+
 	I_LockAudio();
 	{
 		for (int i = 0; i < num_chan; i++)
@@ -517,6 +633,8 @@ void S_StopLevelFX(void)
 {
 	if (nosound) return;
 
+	DropPendingFX(NULL, true);
+
 	I_LockAudio();
 	{
 		for (int i = 0; i < num_chan; i++)
@@ -537,6 +655,8 @@ void S_SoundTicker(void)
 {
 	if (nosound) return;
 
+	StartPendingFX();
+
 	I_LockAudio();
 	{
 		if (gamestate == GS_LEVEL)
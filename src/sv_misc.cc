@@ -653,6 +653,8 @@ void SV_TriggerFinaliseElems(void)
 	{
 		RAD_GroupTriggerTags(cur);
 	}
+
+	RAD_IndexTriggers();
 }
 
 
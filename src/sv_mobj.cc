@@ -373,6 +373,8 @@ void SV_MobjFinaliseElems(void)
 		
 		// sanity checks
 	}
+
+	P_RebuildMobjRegistries();
 }
 
 
@@ -112,6 +112,7 @@ int ogl_ext_EXT_texture_sRGB = ogl_LOAD_FAILED;
 int ogl_ext_KHR_debug = ogl_LOAD_FAILED;
 int ogl_ext_ARB_invalidate_subdata = ogl_LOAD_FAILED;
 int ogl_ext_EXT_abgr = ogl_LOAD_FAILED;
+int ogl_ext_ARB_get_program_binary = ogl_LOAD_FAILED;
 
 void (CODEGEN_FUNCPTR *_ptrc_glBufferStorage)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags) = NULL;
 
@@ -284,6 +285,22 @@ static int Load_ARB_invalidate_subdata(void)
 	return numFailed;
 }
 
+void (CODEGEN_FUNCPTR *_ptrc_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei * length, GLenum * binaryFormat, void * binary) = NULL;
+void (CODEGEN_FUNCPTR *_ptrc_glProgramBinary)(GLuint program, GLenum binaryFormat, const void * binary, GLsizei length) = NULL;
+void (CODEGEN_FUNCPTR *_ptrc_glProgramParameteri)(GLuint program, GLenum pname, GLint value) = NULL;
+
+static int Load_ARB_get_program_binary(void)
+{
+	int numFailed = 0;
+	_ptrc_glGetProgramBinary = (void (CODEGEN_FUNCPTR *)(GLuint, GLsizei, GLsizei *, GLenum *, void *))IntGetProcAddress("glGetProgramBinary");
+	if(!_ptrc_glGetProgramBinary) numFailed++;
+	_ptrc_glProgramBinary = (void (CODEGEN_FUNCPTR *)(GLuint, GLenum, const void *, GLsizei))IntGetProcAddress("glProgramBinary");
+	if(!_ptrc_glProgramBinary) numFailed++;
+	_ptrc_glProgramParameteri = (void (CODEGEN_FUNCPTR *)(GLuint, GLenum, GLint))IntGetProcAddress("glProgramParameteri");
+	if(!_ptrc_glProgramParameteri) numFailed++;
+	return numFailed;
+}
+
 void (CODEGEN_FUNCPTR *_ptrc_glAccum)(GLenum op, GLfloat value) = NULL;
 void (CODEGEN_FUNCPTR *_ptrc_glAlphaFunc)(GLenum func, GLfloat ref) = NULL;
 void (CODEGEN_FUNCPTR *_ptrc_glBegin)(GLenum mode) = NULL;
@@ -2391,7 +2408,7 @@ typedef struct ogl_StrToExtMap_s
 	PFN_LOADFUNCPOINTERS LoadExtension;
 } ogl_StrToExtMap;
 
-static ogl_StrToExtMap ExtensionMap[12] = {
+static ogl_StrToExtMap ExtensionMap[13] = {
 	{"GL_APPLE_client_storage", &ogl_ext_APPLE_client_storage, NULL},
 	{"GL_ARB_buffer_storage", &ogl_ext_ARB_buffer_storage, Load_ARB_buffer_storage},
 	{"GL_ARB_shader_storage_buffer_object", &ogl_ext_ARB_shader_storage_buffer_object, Load_ARB_shader_storage_buffer_object},
@@ -2404,9 +2421,10 @@ static ogl_StrToExtMap ExtensionMap[12] = {
 	{"GL_KHR_debug", &ogl_ext_KHR_debug, Load_KHR_debug},
 	{"GL_ARB_invalidate_subdata", &ogl_ext_ARB_invalidate_subdata, Load_ARB_invalidate_subdata},
 	{"GL_EXT_abgr", &ogl_ext_EXT_abgr, NULL},
+	{"GL_ARB_get_program_binary", &ogl_ext_ARB_get_program_binary, Load_ARB_get_program_binary},
 };
 
-static int g_extensionMapSize = 12;
+static int g_extensionMapSize = 13;
 
 static ogl_StrToExtMap *FindExtEntry(const char *extensionName)
 {
@@ -2435,6 +2453,7 @@ static void ClearExtensionVars(void)
 	ogl_ext_KHR_debug = ogl_LOAD_FAILED;
 	ogl_ext_ARB_invalidate_subdata = ogl_LOAD_FAILED;
 	ogl_ext_EXT_abgr = ogl_LOAD_FAILED;
+	ogl_ext_ARB_get_program_binary = ogl_LOAD_FAILED;
 }
 
 
@@ -119,6 +119,7 @@ extern int ogl_ext_EXT_texture_sRGB;
 extern int ogl_ext_KHR_debug;
 extern int ogl_ext_ARB_invalidate_subdata;
 extern int ogl_ext_EXT_abgr;
+extern int ogl_ext_ARB_get_program_binary;
 
 #define GL_UNPACK_CLIENT_STORAGE_APPLE 0x85B2
 
@@ -288,6 +289,11 @@ extern int ogl_ext_EXT_abgr;
 
 #define GL_ABGR_EXT 0x8000
 
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+
 #define GL_2D 0x0600
 #define GL_2_BYTES 0x1407
 #define GL_3D 0x0601
@@ -1660,6 +1666,16 @@ extern void (CODEGEN_FUNCPTR *_ptrc_glInvalidateTexSubImage)(GLuint texture, GLi
 #define glInvalidateTexSubImage _ptrc_glInvalidateTexSubImage
 #endif /*GL_ARB_invalidate_subdata*/ 
 
+#ifndef GL_ARB_get_program_binary
+#define GL_ARB_get_program_binary 1
+extern void (CODEGEN_FUNCPTR *_ptrc_glGetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei * length, GLenum * binaryFormat, void * binary);
+#define glGetProgramBinary _ptrc_glGetProgramBinary
+extern void (CODEGEN_FUNCPTR *_ptrc_glProgramBinary)(GLuint program, GLenum binaryFormat, const void * binary, GLsizei length);
+#define glProgramBinary _ptrc_glProgramBinary
+extern void (CODEGEN_FUNCPTR *_ptrc_glProgramParameteri)(GLuint program, GLenum pname, GLint value);
+#define glProgramParameteri _ptrc_glProgramParameteri
+#endif /*GL_ARB_get_program_binary*/ 
+
 
 extern void (CODEGEN_FUNCPTR *_ptrc_glAccum)(GLenum op, GLfloat value);
 #define glAccum _ptrc_glAccum
@@ -76,7 +76,12 @@ enum RenderFlags
 	RFL_NO_CLIP_PLANES = 32,
 
 	RFL_INVALIDATE_BUFFER = 64,
-	RFL_DEBUG = 128
+	RFL_DEBUG = 128,
+
+	RFL_PIXEL_BUFFER = 256,
+	RFL_SYNC = 512,
+
+	RFL_GENERATE_MIPMAP = 1024
 };
 
 struct RenderContext
@@ -0,0 +1,305 @@
+//----------------------------------------------------------------------------
+//  EDGE Buffered Log Writer (SDL)
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  The ring is a bounded multi-producer queue of fixed size slots.
+//  Each slot has a 'turn' counter: for position P (lap L = P / size)
+//  the slot is free when turn == 2L, holds text when turn == 2L+1,
+//  and the reader moves it on to 2L+2 once written out.  A message
+//  longer than one slot claims several consecutive slots in one go,
+//  so messages from different threads never get mixed up.
+//
+//  Only one thread empties the ring at a time (drain_lock), which is
+//  usually the writer thread.
+//
+//----------------------------------------------------------------------------
+
+#include "i_defs.h"
+#include "i_sdlinc.h"
+#include "i_log.h"
+
+#include <atomic>
+
+
+#define LOG_RING_BITS  12
+#define LOG_RING_SIZE  (1 << LOG_RING_BITS)
+#define LOG_RING_MASK  (LOG_RING_SIZE - 1)
+
+#define LOG_SLOT_TEXT  244
+
+// longest message (in slots), anything more is cut off
+#define LOG_MAX_SLOTS  (LOG_RING_SIZE / 4)
+
+// how often the writer thread wakes up by itself (in milliseconds)
+#define LOG_WRITE_DELAY  50
+
+
+typedef struct
+{
+	std::atomic<uint64_t> turn;
+
+	int channel;
+	int len;
+
+	char text[LOG_SLOT_TEXT];
+}
+log_slot_t;
+
+static log_slot_t log_ring[LOG_RING_SIZE];
+
+static std::atomic<uint64_t> write_pos;
+static std::atomic<uint64_t> read_pos;
+
+static SDL_mutex  *drain_lock;
+static SDL_sem    *log_wake;
+static SDL_Thread *log_thread;
+
+static std::atomic<bool> log_quit;
+
+
+extern FILE *logfile;
+extern FILE *debugfile;
+extern FILE *openglfile;
+extern FILE *shadercompilefile;
+
+static FILE *ChannelFile(int channel)
+{
+	switch (channel)
+	{
+		case LOG_Main:   return logfile;
+		case LOG_Debug:  return debugfile;
+		case LOG_OpenGL: return openglfile;
+		case LOG_GLSL:   return shadercompilefile;
+
+		default: return NULL;
+	}
+}
+
+//
+// Writes out every complete message in the ring.
+// drain_lock must be held.
+//
+static void DrainRing(void)
+{
+	bool touched[NUM_LOG_CHANNELS] = { false };
+
+	uint64_t pos = read_pos.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		log_slot_t *slot = &log_ring[pos & LOG_RING_MASK];
+
+		uint64_t full = 2 * (pos >> LOG_RING_BITS) + 1;
+
+		if (slot->turn.load(std::memory_order_acquire) != full)
+			break;
+
+		FILE *fp = ChannelFile(slot->channel);
+
+		if (fp)
+		{
+			fwrite(slot->text, 1, slot->len, fp);
+			touched[slot->channel] = true;
+		}
+
+		slot->turn.store(full + 1, std::memory_order_release);
+
+		pos++;
+	}
+
+	read_pos.store(pos, std::memory_order_release);
+
+	for (int ch = 0; ch < NUM_LOG_CHANNELS; ch++)
+	{
+		FILE *fp = ChannelFile(ch);
+
+		if (touched[ch] && fp)
+			fflush(fp);
+	}
+}
+
+static void Drain(void)
+{
+	if (! drain_lock)
+		drain_lock = SDL_CreateMutex();
+
+	SDL_LockMutex(drain_lock);
+	DrainRing();
+	SDL_UnlockMutex(drain_lock);
+}
+
+static int LogWriterLoop(void *unused)
+{
+	while (! log_quit)
+	{
+		SDL_SemWaitTimeout(log_wake, LOG_WRITE_DELAY);
+
+		Drain();
+	}
+
+	return 0;
+}
+
+//
+// I_StartupLog
+//
+void I_StartupLog(void)
+{
+	if (log_thread)
+		return;
+
+	if (! drain_lock)
+		drain_lock = SDL_CreateMutex();
+
+	log_wake = SDL_CreateSemaphore(0);
+	log_quit = false;
+
+	log_thread = SDL_CreateThread(LogWriterLoop, "edge_log", NULL);
+
+	if (! log_thread)
+	{
+		SDL_DestroySemaphore(log_wake);
+		log_wake = NULL;
+	}
+}
+
+//
+// I_ShutdownLog
+//
+void I_ShutdownLog(void)
+{
+	if (log_thread)
+	{
+		log_quit = true;
+		SDL_SemPost(log_wake);
+
+		SDL_WaitThread(log_thread, NULL);
+		log_thread = NULL;
+
+		SDL_DestroySemaphore(log_wake);
+		log_wake = NULL;
+	}
+
+	Drain();
+}
+
+//
+// I_FlushLog
+//
+void I_FlushLog(void)
+{
+	if (! drain_lock)
+		return;
+
+	// we may have crashed while some thread held the lock, so only
+	// wait for it a little while, then write what we can anyway.
+	bool locked = false;
+
+	for (int tries = 0; tries < 250; tries++)
+	{
+		if (SDL_TryLockMutex(drain_lock) == 0)
+		{
+			locked = true;
+			break;
+		}
+
+		SDL_Delay(1);
+	}
+
+	DrainRing();
+
+	if (locked)
+		SDL_UnlockMutex(drain_lock);
+}
+
+//
+// I_LogWrite
+//
+void I_LogWrite(int channel, const char *text, int len)
+{
+	if (len <= 0)
+		return;
+
+	int count = (len + LOG_SLOT_TEXT - 1) / LOG_SLOT_TEXT;
+
+	if (count > LOG_MAX_SLOTS)
+	{
+		count = LOG_MAX_SLOTS;
+		len   = count * LOG_SLOT_TEXT;
+	}
+
+	// claim 'count' slots.  The reader frees slots in order, so when
+	// the last one is free, all of them are.
+	uint64_t pos;
+
+	for (;;)
+	{
+		pos = write_pos.load(std::memory_order_relaxed);
+
+		uint64_t last = pos + count - 1;
+		uint64_t free_turn = 2 * (last >> LOG_RING_BITS);
+
+		uint64_t turn = log_ring[last & LOG_RING_MASK].turn.load(std::memory_order_acquire);
+
+		if (turn == free_turn)
+		{
+			if (write_pos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+				break;
+
+			continue;
+		}
+
+		if (turn < free_turn)
+		{
+			// ring is full, make some room ourselves
+			Drain();
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		log_slot_t *slot = &log_ring[(pos + i) & LOG_RING_MASK];
+
+		int part = MIN(len, LOG_SLOT_TEXT);
+
+		memcpy(slot->text, text, part);
+
+		slot->channel = channel;
+		slot->len = part;
+
+		slot->turn.store(2 * ((pos + i) >> LOG_RING_BITS) + 1, std::memory_order_release);
+
+		text += part;
+		len  -= part;
+	}
+
+	if (! log_thread)
+	{
+		// not running in the background (yet), write it now
+		Drain();
+		return;
+	}
+
+	// wake the writer early when the ring is getting full
+	uint64_t used = pos + count - read_pos.load(std::memory_order_relaxed);
+
+	if (used > LOG_RING_SIZE / 2)
+		SDL_SemPost(log_wake);
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -0,0 +1,60 @@
+//----------------------------------------------------------------------------
+//  EDGE Buffered Log Writer
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  Messages for the log files (edge2.log, debug.txt, etc) are put into
+//  a ring buffer, which any thread may add to without locking, and a
+//  background thread writes them out.  I_Error() flushes the ring so
+//  nothing is lost when things go wrong.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __I_LOG_H__
+#define __I_LOG_H__
+
+typedef enum
+{
+	LOG_Main = 0,  // logfile
+	LOG_Debug,     // debugfile
+	LOG_OpenGL,    // openglfile
+	LOG_GLSL,      // shadercompilefile
+
+	NUM_LOG_CHANNELS
+}
+log_channel_e;
+
+#define LOG_MASK_ALL  ((1 << NUM_LOG_CHANNELS) - 1)
+
+void I_StartupLog(void);
+// Starts the writer thread.  Until then (and after I_ShutdownLog)
+// messages are written straight away.
+
+void I_ShutdownLog(void);
+// Writes out everything pending and stops the writer thread.  Must be
+// called before the log files are closed.
+
+void I_FlushLog(void);
+// Writes out everything pending right now.  Safe to call when the
+// engine is dying (e.g. from I_Error).
+
+void I_LogWrite(int channel, const char *text, int len);
+// Adds some text to the given channel.  Can be called from any thread.
+
+#endif /* __I_LOG_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
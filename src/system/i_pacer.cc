@@ -0,0 +1,152 @@
+//----------------------------------------------------------------------------
+//  EDGE Frame Pacing (SDL)
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+
+#include "i_defs.h"
+#include "i_sdlinc.h"
+#include "i_pacer.h"
+
+#include <math.h>
+
+
+// how long to spin at the end of a wait (in microseconds).  Sleeping
+// is only accurate to a millisecond or so, more on some systems.
+DEF_CVAR(r_pacespin, int, "c", 1500);
+
+pacer_stats_t pacer_stats;
+
+
+// how late SDL_Delay(1) has been waking up, beyond the millisecond
+static u64_t sleep_slop = 500;
+
+#define PACER_FRAMES  64
+
+static float frame_times[PACER_FRAMES];
+static int   frame_pos;
+static int   frame_count;
+
+static u64_t last_frame;
+
+static u64_t slept_us;
+static u64_t spun_us;
+static u64_t stats_time;
+
+
+u64_t I_PreciseMicroSeconds(void)
+{
+	static u64_t freq = 0;
+	static u64_t base = 0;
+
+	if (freq == 0)
+	{
+		freq = SDL_GetPerformanceFrequency();
+		base = SDL_GetPerformanceCounter();
+	}
+
+	u64_t t = SDL_GetPerformanceCounter() - base;
+
+	// split up to avoid overflowing with high frequency counters
+	return (t / freq) * 1000000 + (t % freq) * 1000000 / freq;
+}
+
+//
+// I_WaitUntil
+//
+void I_WaitUntil(u64_t target)
+{
+	u64_t spin = MAX(0, r_pacespin);
+
+	u64_t now = I_PreciseMicroSeconds();
+
+	// sleep a millisecond at a time, keeping track of how badly the
+	// system oversleeps so we can stop early enough.
+	while (now < target && target - now > spin + sleep_slop + 1000)
+	{
+		SDL_Delay(1);
+
+		u64_t after = I_PreciseMicroSeconds();
+		u64_t over  = (after - now > 1000) ? (after - now - 1000) : 0;
+
+		// rise quickly, drop slowly
+		if (over > sleep_slop)
+			sleep_slop = over;
+		else
+			sleep_slop = (sleep_slop * 15 + over) / 16;
+
+		slept_us += after - now;
+
+		now = after;
+	}
+
+	u64_t spin_start = now;
+
+	while (now < target)
+		now = I_PreciseMicroSeconds();
+
+	spun_us += now - spin_start;
+}
+
+//
+// I_PacerFrame
+//
+void I_PacerFrame(void)
+{
+	u64_t now = I_PreciseMicroSeconds();
+
+	if (last_frame > 0)
+	{
+		frame_times[frame_pos] = (now - last_frame) / 1000.0f;
+
+		frame_pos = (frame_pos + 1) % PACER_FRAMES;
+		frame_count = MIN(frame_count + 1, PACER_FRAMES);
+	}
+
+	last_frame = now;
+
+	if (frame_count > 0)
+	{
+		float sum = 0, max = 0;
+
+		for (int i = 0; i < frame_count; i++)
+		{
+			sum += frame_times[i];
+			max  = MAX(max, frame_times[i]);
+		}
+
+		float avg = sum / frame_count;
+		float var = 0;
+
+		for (int i = 0; i < frame_count; i++)
+			var += (frame_times[i] - avg) * (frame_times[i] - avg);
+
+		pacer_stats.frame_ms = avg;
+		pacer_stats.dev_ms   = sqrtf(var / frame_count);
+		pacer_stats.max_ms   = max;
+	}
+
+	if (now - stats_time >= 1000000)
+	{
+		pacer_stats.sleep_us = (int)slept_us;
+		pacer_stats.spin_us  = (int)spun_us;
+
+		slept_us = spun_us = 0;
+		stats_time = now;
+	}
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
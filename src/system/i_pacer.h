@@ -0,0 +1,55 @@
+//----------------------------------------------------------------------------
+//  EDGE Frame Pacing
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  Waiting for a deadline (the next frame when r_maxfps is set, or the
+//  next game tic) is done by sleeping while there is plenty of time
+//  left, then spinning for the last part (r_pacespin microseconds) so
+//  the wake up is exact without burning a whole core.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __I_PACER_H__
+#define __I_PACER_H__
+
+typedef struct
+{
+	float frame_ms;   // average time between frames
+	float dev_ms;     // standard deviation of that
+	float max_ms;     // longest frame
+
+	int sleep_us;     // time spent sleeping (last second)
+	int spin_us;      // time spent spinning (last second)
+}
+pacer_stats_t;
+
+extern pacer_stats_t pacer_stats;
+
+u64_t I_PreciseMicroSeconds(void);
+// Returns a high resolution, monotonic time in microseconds.  Unlike
+// I_ReadMicroSeconds(), it does not wrap around.
+
+void I_WaitUntil(u64_t target);
+// Sleeps, then spins, until I_PreciseMicroSeconds() reaches 'target'.
+
+void I_PacerFrame(void);
+// Called at the start of every rendered frame, for the statistics.
+
+#endif /* __I_PACER_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -0,0 +1,619 @@
+//----------------------------------------------------------------------------
+//  EDGE Worker Threads (SDL)
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+
+#include "i_defs.h"
+#include "i_sdlinc.h"
+#include "i_thread.h"
+
+#include "../m_argv.h"
+
+#include <deque>
+#include <vector>
+
+
+#define MAX_WORKERS  16
+
+
+typedef struct
+{
+	job_func_t func;
+	void *data;
+
+	// group to notify, or NULL
+	job_group_c *group;
+}
+job_t;
+
+static std::deque<job_t> job_queue;
+
+static SDL_mutex *job_lock;
+
+// signalled when a job is queued
+static SDL_cond *job_added;
+
+// signalled when a job finishes
+static SDL_cond *job_done;
+
+static std::vector<SDL_Thread *> workers;
+
+static bool threads_started = false;
+static bool workers_quit = false;
+
+static SDL_threadID main_thread_id;
+
+// set (under the lock) when a job has called I_Error()
+static bool worker_failed = false;
+static char worker_error[2048];
+
+
+static void RunJob(const job_t& job)
+{
+	job.func(job.data);
+
+	SDL_LockMutex(job_lock);
+
+	if (job.group)
+		job.group->Finished();
+
+	SDL_CondBroadcast(job_done);
+	SDL_UnlockMutex(job_lock);
+}
+
+static int WorkerLoop(void *unused)
+{
+	for (;;)
+	{
+		SDL_LockMutex(job_lock);
+
+		while (job_queue.empty() && ! workers_quit)
+			SDL_CondWait(job_added, job_lock);
+
+		if (job_queue.empty())
+		{
+			// quitting and nothing left to do
+			SDL_UnlockMutex(job_lock);
+			return 0;
+		}
+
+		job_t job = job_queue.front();
+		job_queue.pop_front();
+
+		SDL_UnlockMutex(job_lock);
+
+		RunJob(job);
+	}
+}
+
+//
+// I_StartupThreads
+//
+void I_StartupThreads(void)
+{
+	if (threads_started)
+		return;
+
+	threads_started = true;
+	workers_quit = false;
+
+	main_thread_id = SDL_ThreadID();
+
+	job_lock  = SDL_CreateMutex();
+	job_added = SDL_CreateCond();
+	job_done  = SDL_CreateCond();
+
+	int count = SDL_GetCPUCount() - 1;
+
+	const char *s = M_GetParm("-workers");
+	if (s)
+		count = atoi(s);
+
+	if (M_CheckParm("-noworkers"))
+		count = 0;
+
+	count = MAX(0, MIN(MAX_WORKERS, count));
+
+	for (int i = 0; i < count; i++)
+	{
+		SDL_Thread *th = SDL_CreateThread(WorkerLoop, "edge_worker", NULL);
+
+		if (! th)
+		{
+			I_Warning("Unable to create worker thread: %s\n", SDL_GetError());
+			break;
+		}
+
+		workers.push_back(th);
+	}
+
+	I_Printf("I_StartupThreads: %d worker threads\n", (int)workers.size());
+}
+
+//
+// I_ShutdownThreads
+//
+void I_ShutdownThreads(void)
+{
+	if (! threads_started)
+		return;
+
+	// the failed worker never finishes, and we are on the way out
+	// anyway, so leave the threads alone.
+	if (worker_failed)
+		return;
+
+	SDL_LockMutex(job_lock);
+	workers_quit = true;
+	SDL_CondBroadcast(job_added);
+	SDL_UnlockMutex(job_lock);
+
+	for (size_t i = 0; i < workers.size(); i++)
+		SDL_WaitThread(workers[i], NULL);
+
+	workers.clear();
+
+	// no workers: run whatever is left over right here
+	while (! job_queue.empty())
+	{
+		job_t job = job_queue.front();
+		job_queue.pop_front();
+
+		RunJob(job);
+	}
+
+	SDL_DestroyCond(job_done);
+	SDL_DestroyCond(job_added);
+	SDL_DestroyMutex(job_lock);
+
+	threads_started = false;
+}
+
+//
+// I_WorkerError
+//
+void I_WorkerError(const char *error, va_list argptr)
+{
+	SDL_LockMutex(job_lock);
+
+	// only the first error is kept
+	if (! worker_failed)
+	{
+		vsnprintf(worker_error, sizeof(worker_error), error, argptr);
+		worker_error[sizeof(worker_error) - 1] = 0;
+
+		worker_failed = true;
+	}
+
+	// wake up the main thread, if it is waiting
+	SDL_CondBroadcast(job_done);
+
+	// the job can neither go on nor finish, so wait here until the
+	// program exits.
+	for (;;)
+		SDL_CondWait(job_added, job_lock);
+}
+
+//
+// CheckWorkerError
+//
+// Called by the main thread while waiting, with the lock held.  Raises
+// the error of a failed worker here, where it is safe to shut down.
+//
+static void CheckWorkerError(void)
+{
+	if (! worker_failed)
+		return;
+
+	SDL_UnlockMutex(job_lock);
+
+	I_Error("%s", worker_error);
+}
+
+int I_NumWorkers(void)
+{
+	return (int)workers.size();
+}
+
+bool I_IsMainThread(void)
+{
+	return ! threads_started || SDL_ThreadID() == main_thread_id;
+}
+
+static void QueueJob(job_func_t func, void *data, job_group_c *group)
+{
+	I_StartupThreads();
+
+	job_t job;
+
+	job.func  = func;
+	job.data  = data;
+	job.group = group;
+
+	if (workers.empty())
+	{
+		RunJob(job);
+		return;
+	}
+
+	SDL_LockMutex(job_lock);
+
+	job_queue.push_back(job);
+
+	SDL_CondSignal(job_added);
+	SDL_UnlockMutex(job_lock);
+}
+
+void I_QueueJob(job_func_t func, void *data)
+{
+	QueueJob(func, data, NULL);
+}
+
+
+//----------------------------------------------------------------------------
+//  JOB GROUPS
+//----------------------------------------------------------------------------
+
+job_group_c::job_group_c() : pending(0)
+{ }
+
+job_group_c::~job_group_c()
+{
+	Wait();
+}
+
+void job_group_c::Add(job_func_t func, void *data)
+{
+	pending++;
+
+	QueueJob(func, data, this);
+}
+
+void job_group_c::Wait()
+{
+	if (Done())
+		return;
+
+	SDL_LockMutex(job_lock);
+
+	while (! Done())
+	{
+		CheckWorkerError();
+
+		// help out with our own jobs rather than sitting idle
+		std::deque<job_t>::iterator it;
+
+		for (it = job_queue.begin(); it != job_queue.end(); it++)
+			if (it->group == this)
+				break;
+
+		if (it != job_queue.end())
+		{
+			job_t job = *it;
+			job_queue.erase(it);
+
+			SDL_UnlockMutex(job_lock);
+			RunJob(job);
+			SDL_LockMutex(job_lock);
+			continue;
+		}
+
+		SDL_CondWait(job_done, job_lock);
+	}
+
+	SDL_UnlockMutex(job_lock);
+}
+
+
+//----------------------------------------------------------------------------
+//  TASK GRAPHS
+//----------------------------------------------------------------------------
+
+struct task_graph_c::task_t
+{
+	const char *name;
+
+	job_func_t func;
+	void *data;
+
+	bool main;
+
+	task_graph_c *graph;
+
+	// tasks waiting for this one
+	std::vector<task_t *> dependents;
+
+	int num_deps;
+	std::atomic<int> waiting;
+
+	// times in microseconds, relative to the start of Run()
+	u32_t start;
+	u32_t finish;
+};
+
+static void TaskJob(void *data)
+{
+	task_graph_c::task_t *T = (task_graph_c::task_t *) data;
+
+	T->graph->RunTask(T);
+}
+
+task_graph_c::task_graph_c() :
+	tasks(), main_ready(), remaining(0), start_time(0), total_time(0)
+{ }
+
+task_graph_c::~task_graph_c()
+{
+	for (size_t i = 0; i < tasks.size(); i++)
+		delete tasks[i];
+}
+
+int task_graph_c::Add(const char *name, job_func_t func, void *data, bool main)
+{
+	task_t *T = new task_t;
+
+	T->name  = name;
+	T->func  = func;
+	T->data  = data;
+	T->main  = main;
+	T->graph = this;
+
+	T->num_deps = 0;
+	T->waiting  = 0;
+
+	T->start = T->finish = 0;
+
+	tasks.push_back(T);
+
+	return (int)tasks.size() - 1;
+}
+
+void task_graph_c::Depend(int task, int on)
+{
+	SYS_ASSERT(0 <= task && task < (int)tasks.size());
+	SYS_ASSERT(0 <= on   && on   < task);
+
+	tasks[on]->dependents.push_back(tasks[task]);
+	tasks[task]->num_deps++;
+}
+
+void task_graph_c::Launch(task_t *T)
+{
+	if (! T->main)
+	{
+		QueueJob(TaskJob, T, NULL);
+		return;
+	}
+
+	SDL_LockMutex(job_lock);
+
+	main_ready.push_back(T);
+
+	SDL_CondBroadcast(job_done);
+	SDL_UnlockMutex(job_lock);
+}
+
+void task_graph_c::RunTask(task_t *T)
+{
+	T->start = I_ReadMicroSeconds() - start_time;
+
+	T->func(T->data);
+
+	T->finish = I_ReadMicroSeconds() - start_time;
+
+	// without workers, Run() takes care of the order
+	if (workers.empty())
+	{
+		remaining--;
+		return;
+	}
+
+	for (size_t i = 0; i < T->dependents.size(); i++)
+	{
+		task_t *D = T->dependents[i];
+
+		if (--D->waiting == 0)
+			Launch(D);
+	}
+
+	remaining--;
+}
+
+void task_graph_c::Run()
+{
+	I_StartupThreads();
+
+	start_time = I_ReadMicroSeconds();
+
+	remaining = (int)tasks.size();
+
+	if (workers.empty())
+	{
+		// Depend() only allows earlier tasks, so this order is fine
+		for (size_t i = 0; i < tasks.size(); i++)
+			RunTask(tasks[i]);
+
+		total_time = I_ReadMicroSeconds() - start_time;
+		return;
+	}
+
+	for (size_t i = 0; i < tasks.size(); i++)
+		tasks[i]->waiting = tasks[i]->num_deps;
+
+	for (size_t i = 0; i < tasks.size(); i++)
+		if (tasks[i]->num_deps == 0)
+			Launch(tasks[i]);
+
+	SDL_LockMutex(job_lock);
+
+	while (remaining > 0)
+	{
+		CheckWorkerError();
+
+		if (! main_ready.empty())
+		{
+			task_t *T = main_ready.front();
+			main_ready.erase(main_ready.begin());
+
+			SDL_UnlockMutex(job_lock);
+			RunTask(T);
+			SDL_LockMutex(job_lock);
+			continue;
+		}
+
+		// help out with our own tasks rather than sitting idle
+		std::deque<job_t>::iterator it;
+
+		for (it = job_queue.begin(); it != job_queue.end(); it++)
+			if (it->func == TaskJob && ((task_t *) it->data)->graph == this)
+				break;
+
+		if (it != job_queue.end())
+		{
+			job_t job = *it;
+			job_queue.erase(it);
+
+			SDL_UnlockMutex(job_lock);
+			RunJob(job);
+			SDL_LockMutex(job_lock);
+			continue;
+		}
+
+		SDL_CondWait(job_done, job_lock);
+	}
+
+	SDL_UnlockMutex(job_lock);
+
+	total_time = I_ReadMicroSeconds() - start_time;
+}
+
+void task_graph_c::ShowTimes(const char *title, bool console)
+{
+	u32_t sum = 0;
+
+	for (size_t i = 0; i < tasks.size(); i++)
+		sum += tasks[i]->finish - tasks[i]->start;
+
+	for (int pass = 0; pass < (console ? 2 : 1); pass++)
+	{
+		void (* print)(const char *, ...) = pass ? I_Printf : I_Debugf;
+
+		print("%s: %d ms (%d ms of work)\n", title,
+			  (int)(total_time / 1000), (int)(sum / 1000));
+
+		for (size_t i = 0; i < tasks.size(); i++)
+		{
+			const task_t *T = tasks[i];
+
+			print("  %-18s %6.1f ms  (at %1.1f)\n", T->name,
+				  (T->finish - T->start) / 1000.0f, T->start / 1000.0f);
+		}
+	}
+}
+
+
+//----------------------------------------------------------------------------
+//  PARALLEL FOR
+//----------------------------------------------------------------------------
+
+typedef struct
+{
+	void (* func)(int index, void *data);
+	void *data;
+
+	int count;
+
+	std::atomic<int> next;
+}
+parallel_for_t;
+
+static void ParallelForJob(void *data)
+{
+	parallel_for_t *pf = (parallel_for_t *) data;
+
+	for (;;)
+	{
+		int index = pf->next++;
+
+		if (index >= pf->count)
+			break;
+
+		pf->func(index, pf->data);
+	}
+}
+
+void I_ParallelFor(int count, void (* func)(int index, void *data), void *data)
+{
+	if (count <= 0)
+		return;
+
+	I_StartupThreads();
+
+	if (count == 1 || workers.empty())
+	{
+		for (int i = 0; i < count; i++)
+			func(i, data);
+
+		return;
+	}
+
+	parallel_for_t pf;
+
+	pf.func  = func;
+	pf.data  = data;
+	pf.count = count;
+	pf.next  = 0;
+
+	job_group_c group;
+
+	int jobs = MIN(count - 1, (int)workers.size());
+
+	for (int i = 0; i < jobs; i++)
+		group.Add(ParallelForJob, &pf);
+
+	// the calling thread takes part too
+	ParallelForJob(&pf);
+
+	group.Wait();
+}
+
+
+//----------------------------------------------------------------------------
+//  MUTEXES
+//----------------------------------------------------------------------------
+
+mutex_c::mutex_c()
+{
+	priv = SDL_CreateMutex();
+}
+
+mutex_c::~mutex_c()
+{
+	SDL_DestroyMutex((SDL_mutex *) priv);
+}
+
+void mutex_c::Lock()
+{
+	SDL_LockMutex((SDL_mutex *) priv);
+}
+
+void mutex_c::Unlock()
+{
+	SDL_UnlockMutex((SDL_mutex *) priv);
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -0,0 +1,162 @@
+//----------------------------------------------------------------------------
+//  EDGE Worker Threads
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  A small pool of worker threads for work which can be done off the
+//  main thread (encoding, decoding, building caches).  Job functions
+//  must never call into the renderer, the console or the play
+//  simulation -- only the main thread may do that.
+//
+//  I_Error() on a worker stops that worker, and the error is raised
+//  again on the main thread the next time it waits for a job.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __I_THREAD_H__
+#define __I_THREAD_H__
+
+#include <stdarg.h>
+
+#include <atomic>
+#include <vector>
+
+typedef void (* job_func_t)(void *data);
+
+void I_StartupThreads(void);
+// Starts the worker threads.  The number of workers comes from the
+// "-workers" option, otherwise from the CPU count.  "-noworkers" keeps
+// everything on the main thread.  Called on first use if needed.
+
+void I_ShutdownThreads(void);
+// Finishes every queued job, then stops the worker threads.
+
+int I_NumWorkers(void);
+// Returns the number of worker threads (zero when single-threaded).
+
+bool I_IsMainThread(void);
+// True when called from the main (engine) thread.
+
+void I_WorkerError(const char *error, va_list argptr);
+// Used by I_Error() on a worker thread.  Keeps the message for the
+// main thread and never returns.
+
+
+class job_group_c
+{
+	// A set of jobs which can be waited upon together.  When there are
+	// no workers, jobs simply run immediately inside Add().
+
+public:
+	job_group_c();
+	~job_group_c();
+
+	void Add(job_func_t func, void *data);
+
+	// true when every job added so far has finished
+	bool Done() const { return pending.load() == 0; }
+
+	// waits for all jobs to finish, running our own queued jobs on
+	// the calling thread while waiting.
+	void Wait();
+
+	// used by the worker code
+	void Finished() { pending--; }
+
+private:
+	std::atomic<int> pending;
+};
+
+
+class task_graph_c
+{
+	// A set of tasks where some must wait for others to finish.  Tasks
+	// run on the worker threads as soon as everything they depend on
+	// is done, except 'main' tasks which always run on the thread which
+	// calls Run() (e.g. anything using OpenGL or the lump cache).
+	// Without workers the tasks simply run in the order they were added.
+
+public:
+	task_graph_c();
+	~task_graph_c();
+
+	// adds a task, returns its number
+	int Add(const char *name, job_func_t func, void *data, bool main = false);
+
+	// 'task' will not start until 'on' has finished
+	void Depend(int task, int on);
+
+	// runs every task, returns when they have all finished
+	void Run();
+
+	// prints how long each task took (to the debug file, and to the
+	// console when 'console' is true)
+	void ShowTimes(const char *title, bool console);
+
+	// used by the worker code
+	struct task_t;
+
+	void Launch(task_t *T);
+	void RunTask(task_t *T);
+
+private:
+	std::vector<task_t *> tasks;
+	std::vector<task_t *> main_ready;
+
+	std::atomic<int> remaining;
+
+	u32_t start_time;
+	u32_t total_time;
+};
+
+
+void I_QueueJob(job_func_t func, void *data);
+// Queues a job which nobody will wait for (fire and forget).  The job
+// must report its own completion, e.g. through an atomic flag.
+
+void I_ParallelFor(int count, void (* func)(int index, void *data), void *data);
+// Calls func(index, data) for every index in [0, count), spread over
+// the worker threads and the calling thread.  Returns when all calls
+// have finished.
+
+
+class mutex_c
+{
+public:
+	mutex_c();
+	~mutex_c();
+
+	void Lock();
+	void Unlock();
+
+private:
+	void *priv;
+};
+
+class auto_lock_c
+{
+public:
+	auto_lock_c(mutex_c& _m) : m(_m) { m.Lock(); }
+	~auto_lock_c() { m.Unlock(); }
+
+private:
+	mutex_c& m;
+};
+
+#endif /* __I_THREAD_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -21,6 +21,8 @@ KOS_INIT_FLAGS(INIT_DEFAULT | INIT_THD_PREEMPT | INIT_OCINDEX);
 
 #include "system/i_defs.h"
 #include "system/i_sdlinc.h"
+#include "system/i_log.h"
+#include "system/i_thread.h"
 //#include "system/i_net.h"
 
 #include <unistd.h>
@@ -237,10 +239,20 @@ void I_Error(const char *error, ...)
 {
 	va_list argptr;
 
+	// handled by the main thread, this never returns
+	if (! I_IsMainThread())
+	{
+		va_start (argptr, error);
+		I_WorkerError(error, argptr);
+	}
+
 	va_start (argptr, error);
 	vsprintf (errmsg, error, argptr);
 	va_end (argptr);
 
+	// get everything already logged out first
+	I_FlushLog();
+
 	if (logfile)
 	{
 		fprintf(logfile, "ERROR: %s\n", errmsg);
@@ -413,6 +425,9 @@ void I_SystemShutdown(void)
 	// makre sure audio is unlocked (e.g. I_Error occurred)
 //	I_UnlockAudio();
 
+	// finish any background jobs (e.g. screenshot encoding)
+	I_ShutdownThreads();
+
 #ifndef NO_NETWORK
 	I_ShutdownNetwork();
 #endif
@@ -421,6 +436,8 @@ void I_SystemShutdown(void)
 	I_ShutdownControl();
 	I_ShutdownGraphics();
 
+	I_ShutdownLog();
+
 	if (logfile)
 	{
 		fclose(logfile);
@@ -19,6 +19,8 @@
 #include "../i_defs.h"
 #include "../i_sdlinc.h"
 #include "../i_net.h"
+#include "../i_log.h"
+#include "../i_thread.h"
 
 #include <unistd.h>
 #include <signal.h>
@@ -260,10 +262,20 @@ void I_Error(const char *error, ...)
 {
 	va_list argptr;
 
+	// handled by the main thread, this never returns
+	if (! I_IsMainThread())
+	{
+		va_start (argptr, error);
+		I_WorkerError(error, argptr);
+	}
+
 	va_start (argptr, error);
 	vsprintf (errmsg, error, argptr);
 	va_end (argptr);
 
+	// get everything already logged out first
+	I_FlushLog();
+
 	if (logfile)
 	{
 		fprintf(logfile, "ERROR: %s\n", errmsg);
@@ -479,6 +491,9 @@ void I_SystemShutdown(void)
 	// makre sure audio is unlocked (e.g. I_Error occurred)
 	I_UnlockAudio();
 
+	// finish any background jobs (e.g. screenshot encoding)
+	I_ShutdownThreads();
+
 	I_ShutdownNetwork();
 	I_ShutdownMusic();
 	I_ShutdownSound();
@@ -495,6 +510,8 @@ void I_SystemShutdown(void)
 	}
 #endif
 
+	I_ShutdownLog();
+
 	if (logfile)
 	{
 		fclose(logfile);
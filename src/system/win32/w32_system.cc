@@ -19,6 +19,8 @@
 #include "../i_defs.h"
 #include "../i_sdlinc.h"
 #include "../i_net.h"
+#include "../i_log.h"
+#include "../i_thread.h"
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -211,10 +213,20 @@ void I_Error(const char *error,...)
 {
 	va_list argptr;
 
+	// handled by the main thread, this never returns
+	if (! I_IsMainThread())
+	{
+		va_start(argptr, error);
+		I_WorkerError(error, argptr);
+	}
+
 	va_start(argptr, error);
 	vsprintf(msgbuf, error, argptr);
 	va_end(argptr);
 
+	// get everything already logged out first
+	I_FlushLog();
+
 	if (logfile)
 	{
 		fprintf(logfile, "ERROR: %s\n", msgbuf);
@@ -417,12 +429,17 @@ void I_SystemShutdown(void)
 	// make sure audio is unlocked (e.g. I_Error occurred)
 	I_UnlockAudio();
 
+	// finish any background jobs (e.g. screenshot encoding)
+	I_ShutdownThreads();
+
 	I_ShutdownNetwork();
 	I_ShutdownMusic();
 	I_ShutdownSound();
 	I_ShutdownControl();
 	I_ShutdownGraphics();
 
+	I_ShutdownLog();
+
 	if (logfile)
 	{
 		fclose(logfile);
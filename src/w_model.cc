@@ -26,6 +26,7 @@
 #include "md5_conv/md5.h"
 #include "r_things.h"
 #include "w_model.h"
+#include "w_modelcache.h"
 #include "w_wad.h"
 
 #include "p_local.h"  // mobjlisthead
@@ -94,6 +95,21 @@ static void FindModelFrameNames(md2_model_c *md, int model_num)
 }
 
 
+static md2_model_c *LoadMD2Model(epi::file_c *f, bool is_md3)
+{
+	int length = f->GetLength();
+
+	byte *data = f->LoadIntoMemory();
+	SYS_ASSERT(data);
+
+	md2_model_c *md = MD2_LoadCachedModel(data, length, is_md3);
+
+	delete[] data;
+
+	return md;
+}
+
+
 modeldef_c *LoadModelFromLump(int model_num)
 {
 	const char *basename = ddf_model_names[model_num].c_str();
@@ -117,7 +133,7 @@ modeldef_c *LoadModelFromLump(int model_num)
 				I_Error("Missing model lump?: %s\n", lumpname);
 		SYS_ASSERT(f);
 
-		def->model = MD3_LoadModel(f);
+		def->model = LoadMD2Model(f, true);
 		//def->modeltype = MODEL_MD3_UNIFIED;
 		def->modeltype = MODEL_MD2;
 	} 
@@ -133,7 +149,7 @@ modeldef_c *LoadModelFromLump(int model_num)
 			if (! f)
 				I_Error("Missing model lump: %s\n", lumpname);
 
-			def->model = MD2_LoadModel(f);
+			def->model = LoadMD2Model(f, false);
 			def->modeltype = MODEL_MD2;
 		} 
 		else 
@@ -144,14 +160,13 @@ modeldef_c *LoadModelFromLump(int model_num)
 
 			f = W_OpenLump(lumpname);
 			SYS_ASSERT(f);
+			int length = f->GetLength();
 			byte *modeltext = f->LoadIntoMemory();
 			SYS_ASSERT(modeltext);
 
-			MD5model *md5 = md5_load((char*)modeltext);
 			def->modeltype = MODEL_MD5_UNIFIED;
-			def->md5u = md5_normalize_model(md5);
+			def->md5u = MD5_LoadCachedModel(modeltext, length);
 			
-			md5_free(md5);
 			delete[] modeltext;
 			
 			delete f;
@@ -0,0 +1,560 @@
+//----------------------------------------------------------------------------
+//  EDGE Model Cache
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+
+#include "system/i_defs.h"
+
+#include "../epi/endianess.h"
+#include "../epi/file.h"
+#include "../epi/filesystem.h"
+#include "../epi/math_crc.h"
+#include "../epi/path.h"
+#include "../epi/str_format.h"
+
+#include "dm_state.h"
+#include "m_misc.h"
+#include "w_modelcache.h"
+
+#include "system/i_thread.h"
+
+
+// use the cache files at all?
+DEF_CVAR(r_modelcache, int, "c", 1);
+
+
+#define MDC_MAGIC    "EDGEMDL1"
+
+// bump this when the contents of a cache file change
+#define MDC_VERSION  1
+
+typedef struct
+{
+	char magic[8];
+
+	u32_t kind;
+	u32_t layout;
+	u32_t key;
+	s32_t length;     // of the source lump
+	s32_t data_size;
+
+	u32_t reserved;
+}
+model_cache_header_t;
+
+
+int model_cache_writer_c::Add(const void *src, int bytes)
+{
+	int offset = ((int)data.size() + 15) & ~15;
+
+	data.resize(offset + bytes);
+
+	if (bytes > 0)
+		memcpy(&data[offset], src, bytes);
+
+	return offset;
+}
+
+void model_cache_reader_c::FixString(const char *& str)
+{
+	intptr_t ofs = (intptr_t) str;
+
+	if (ofs < 0 || ofs >= size || memchr(data + ofs, 0, size - ofs) == NULL)
+	{
+		ok  = false;
+		str = NULL;
+		return;
+	}
+
+	str = (const char *)(data + ofs);
+}
+
+void model_cache_reader_c::FixShortList(short *& list)
+{
+	intptr_t ofs = (intptr_t) list;
+
+	if (ofs < 0 || ofs >= size)
+	{
+		ok   = false;
+		list = NULL;
+		return;
+	}
+
+	for (intptr_t pos = ofs; pos + (intptr_t)sizeof(short) <= size; pos += sizeof(short))
+	{
+		if (*(const short *)(data + pos) < 0)
+		{
+			list = (short *)(data + ofs);
+			return;
+		}
+	}
+
+	ok   = false;
+	list = NULL;
+}
+
+
+static std::string CacheFilename(int kind, u32_t key, int length)
+{
+	std::string base = epi::STR_Format("model-%d-%08X-%d.dat", kind, key, length);
+
+	return epi::PATH_Join(cache_dir.c_str(), base.c_str());
+}
+
+//
+// W_ModelCacheKey
+//
+u32_t W_ModelCacheKey(const byte *lump, int length)
+{
+	epi::crc32_c crc;
+
+	crc.AddBlock(lump, length);
+
+	return crc.crc;
+}
+
+//
+// W_LoadModelCache
+//
+bool W_LoadModelCache(int kind, u32_t key, int length, u32_t layout,
+                      model_cache_reader_c *rd)
+{
+	if (r_modelcache <= 0)
+		return false;
+
+	std::string fn = CacheFilename(kind, key, length);
+
+	epi::file_c *fp = epi::FS_Open(fn.c_str(), epi::file_c::ACCESS_READ | epi::file_c::ACCESS_BINARY);
+
+	if (! fp)
+		return false;
+
+	model_cache_header_t hdr;
+
+	bool ok = (fp->Read(&hdr, sizeof(hdr)) == sizeof(hdr)) &&
+	          (memcmp(hdr.magic, MDC_MAGIC, 8) == 0) &&
+	          (EPI_LE_U32(hdr.kind)   == (u32_t)kind) &&
+	          (EPI_LE_U32(hdr.layout) == layout) &&
+	          (EPI_LE_U32(hdr.key)    == key) &&
+	          (EPI_LE_S32(hdr.length) == length);
+
+	int data_size = EPI_LE_S32(hdr.data_size);
+
+	if (ok && (data_size <= 0 || (int)sizeof(hdr) + data_size != fp->GetLength()))
+		ok = false;
+
+	if (ok)
+	{
+		rd->data = new byte[data_size];
+		rd->size = data_size;
+		rd->ok   = true;
+
+		if (fp->Read(rd->data, data_size) != (unsigned int)data_size)
+			ok = false;
+	}
+
+	delete fp;
+
+	if (! ok)
+	{
+		I_Debugf("Model cache file %s is bad, ignoring it.\n", fn.c_str());
+
+		delete[] rd->data;
+
+		rd->data = NULL;
+		rd->size = 0;
+		rd->ok   = false;
+	}
+	else
+		I_Debugf("Using model cache file %s\n", fn.c_str());
+
+	return ok;
+}
+
+
+typedef struct
+{
+	std::string filename;
+
+	model_cache_header_t header;
+
+	model_cache_writer_c *w;
+}
+model_save_t;
+
+static void SaveModelCacheJob(void *data)
+{
+	model_save_t *sv = (model_save_t *) data;
+
+	int size = (int)sv->w->data.size();
+
+	std::vector<byte> buffer(sizeof(sv->header) + size);
+
+	memcpy(buffer.data(), &sv->header, sizeof(sv->header));
+	memcpy(buffer.data() + sizeof(sv->header), sv->w->At(0), size);
+
+	M_SaveCacheFile(sv->filename, buffer.data(), (int)buffer.size());
+
+	delete sv->w;
+	delete sv;
+}
+
+//
+// W_SaveModelCache
+//
+void W_SaveModelCache(int kind, u32_t key, int length, u32_t layout,
+                      model_cache_writer_c *w)
+{
+	if (r_modelcache <= 0 || w->data.empty())
+	{
+		delete w;
+		return;
+	}
+
+	model_save_t *sv = new model_save_t;
+
+	sv->filename = CacheFilename(kind, key, length);
+	sv->w = w;
+
+	model_cache_header_t *hdr = &sv->header;
+
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, MDC_MAGIC, 8);
+
+	hdr->kind      = EPI_LE_U32((u32_t)kind);
+	hdr->layout    = EPI_LE_U32(layout);
+	hdr->key       = EPI_LE_U32(key);
+	hdr->length    = EPI_LE_S32(length);
+	hdr->data_size = EPI_LE_S32((s32_t)w->data.size());
+
+	I_QueueJob(SaveModelCacheJob, sv);
+}
+
+
+//----------------------------------------------------------------------------
+//  MD5 MODELS
+//----------------------------------------------------------------------------
+
+static u32_t MD5ModelLayout(void)
+{
+	epi::crc32_c crc;
+
+	crc += (s32_t) MDC_VERSION;
+	crc += (s32_t) sizeof(MD5umodel);
+	crc += (s32_t) sizeof(MD5joint);
+	crc += (s32_t) sizeof(MD5mesh);
+	crc += (s32_t) sizeof(MD5vertex);
+	crc += (s32_t) sizeof(MD5triangle);
+	crc += (s32_t) sizeof(MD5weight);
+
+	return crc.crc;
+}
+
+static void WriteMD5Model(MD5umodel *umd5, model_cache_writer_c *w)
+{
+	MD5model *md5 = &umd5->model;
+
+	// the meshes all share the unified weights.  weightcnt is not the
+	// size of that array, so work it out from the vertices.
+	int num_weights = 0;
+
+	for (int i = 0; i < md5->meshcnt; i++)
+	{
+		MD5mesh *msh = md5->meshes + i;
+
+		for (int v = 0; v < msh->vertcnt; v++)
+			num_weights = MAX(num_weights, msh->verts[v].firstweight + msh->verts[v].weightcnt);
+	}
+
+	int um_ofs = w->Add(umd5, sizeof(MD5umodel));
+
+	int jo_ofs = w->Add(md5->joints, md5->jointcnt * sizeof(MD5joint));
+	int we_ofs = w->Add(umd5->weights, num_weights * sizeof(MD5weight));
+	int me_ofs = w->Add(md5->meshes, md5->meshcnt * sizeof(MD5mesh));
+
+	for (int i = 0; i < md5->meshcnt; i++)
+	{
+		MD5mesh *src = md5->meshes + i;
+
+		int ve_ofs = w->Add(src->verts, src->vertcnt * sizeof(MD5vertex));
+		int tr_ofs = w->Add(src->tris,  src->tricnt  * sizeof(MD5triangle));
+
+		MD5mesh *dest = (MD5mesh *) w->At(me_ofs) + i;
+
+		dest->tex       = NULL;
+		dest->verts     = model_cache_writer_c::Offset<MD5vertex>(ve_ofs);
+		dest->tris      = model_cache_writer_c::Offset<MD5triangle>(tr_ofs);
+		dest->weights   = model_cache_writer_c::Offset<MD5weight>(we_ofs);
+		dest->weightcnt = num_weights;
+	}
+
+	MD5umodel *dest = (MD5umodel *) w->At(um_ofs);
+
+	dest->model.joints = model_cache_writer_c::Offset<MD5joint>(jo_ofs);
+	dest->model.meshes = model_cache_writer_c::Offset<MD5mesh>(me_ofs);
+	dest->weights      = model_cache_writer_c::Offset<MD5weight>(we_ofs);
+	dest->weightcnt    = num_weights;
+}
+
+//
+// CheckMD5Model
+//
+// The offsets have been checked by Fix(), this checks the indices
+// stored in the data, so a damaged cache cannot make the drawing
+// code read past the arrays.
+//
+static bool CheckMD5Model(const MD5umodel *umd5)
+{
+	const MD5model *md5 = &umd5->model;
+
+	for (int i = 0; i < md5->jointcnt; i++)
+	{
+		int parent = md5->joints[i].parent;
+
+		if (parent < -1 || parent >= md5->jointcnt)
+			return false;
+	}
+
+	for (int i = 0; i < umd5->weightcnt; i++)
+	{
+		int joint = umd5->weights[i].jointidx;
+
+		if (joint < 0 || joint >= md5->jointcnt)
+			return false;
+	}
+
+	for (int m = 0; m < md5->meshcnt; m++)
+	{
+		const MD5mesh *msh = md5->meshes + m;
+
+		for (int i = 0; i < msh->weightcnt; i++)
+		{
+			int joint = msh->weights[i].jointidx;
+
+			if (joint < 0 || joint >= md5->jointcnt)
+				return false;
+		}
+
+		for (int i = 0; i < msh->vertcnt; i++)
+		{
+			const MD5vertex *vert = msh->verts + i;
+
+			if (vert->firstweight < 0 || vert->weightcnt < 0 ||
+				vert->firstweight > msh->weightcnt - vert->weightcnt)
+				return false;
+		}
+
+		for (int i = 0; i < msh->tricnt; i++)
+		{
+			for (int k = 0; k < 3; k++)
+				if ((int)msh->tris[i].vidx[k] >= msh->vertcnt)
+					return false;
+		}
+	}
+
+	return true;
+}
+
+static MD5umodel *ReadMD5Model(model_cache_reader_c *rd)
+{
+	if (rd->size < (int)sizeof(MD5umodel))
+		return NULL;
+
+	MD5umodel *umd5 = (MD5umodel *) rd->data;
+	MD5model  *md5  = &umd5->model;
+
+	if (md5->jointcnt < 0 || md5->jointcnt > MD5_MAX_JOINTS || md5->meshcnt < 0)
+		return NULL;
+
+	rd->Fix(md5->joints,  md5->jointcnt);
+	rd->Fix(md5->meshes,  md5->meshcnt);
+	rd->Fix(umd5->weights, umd5->weightcnt);
+
+	for (int i = 0; rd->ok && i < md5->meshcnt; i++)
+	{
+		MD5mesh *msh = md5->meshes + i;
+
+		rd->Fix(msh->verts,   msh->vertcnt);
+		rd->Fix(msh->tris,    msh->tricnt);
+		rd->Fix(msh->weights, msh->weightcnt);
+	}
+
+	if (! rd->ok || ! CheckMD5Model(umd5))
+		return NULL;
+
+	// the model lives as long as the engine, like the text ones do
+	rd->Release();
+
+	return umd5;
+}
+
+//
+// MD5_LoadCachedModel
+//
+MD5umodel *MD5_LoadCachedModel(byte *lump, int length)
+{
+	u32_t key    = W_ModelCacheKey(lump, length);
+	u32_t layout = MD5ModelLayout();
+
+	model_cache_reader_c rd;
+
+	if (W_LoadModelCache(MDC_MD5Model, key, length, layout, &rd))
+	{
+		MD5umodel *umd5 = ReadMD5Model(&rd);
+
+		if (umd5)
+			return umd5;
+
+		I_Debugf("MD5 model cache is damaged, rebuilding it.\n");
+	}
+
+	MD5model *md5 = md5_load((char *)lump);
+	MD5umodel *umd5 = md5_normalize_model(md5);
+
+	md5_free(md5);
+
+	model_cache_writer_c *w = new model_cache_writer_c();
+
+	WriteMD5Model(umd5, w);
+
+	W_SaveModelCache(MDC_MD5Model, key, length, layout, w);
+
+	return umd5;
+}
+
+
+//----------------------------------------------------------------------------
+//  MD5 ANIMATIONS
+//----------------------------------------------------------------------------
+
+static u32_t MD5AnimLayout(void)
+{
+	epi::crc32_c crc;
+
+	crc += (s32_t) MDC_VERSION;
+	crc += (s32_t) sizeof(MD5animation);
+	crc += (s32_t) sizeof(MD5bounds);
+	crc += (s32_t) sizeof(MD5hierarchy);
+	crc += (s32_t) sizeof(MD5baseframe);
+
+	return crc.crc;
+}
+
+static void WriteMD5Anim(MD5animation *anim, model_cache_writer_c *w)
+{
+	int an_ofs = w->Add(anim, sizeof(MD5animation));
+
+	int bo_ofs = w->Add(anim->bounds,    anim->framecnt * sizeof(MD5bounds));
+	int hi_ofs = w->Add(anim->hierarchy, anim->jointcnt * sizeof(MD5hierarchy));
+	int ba_ofs = w->Add(anim->baseframe, anim->jointcnt * sizeof(MD5baseframe));
+	int fc_ofs = w->Add(anim->framecomponents,
+	                    anim->framecnt * anim->animatedcomponentcnt * sizeof(float));
+
+	MD5animation *dest = (MD5animation *) w->At(an_ofs);
+
+	dest->bounds          = model_cache_writer_c::Offset<MD5bounds>(bo_ofs);
+	dest->hierarchy       = model_cache_writer_c::Offset<MD5hierarchy>(hi_ofs);
+	dest->baseframe       = model_cache_writer_c::Offset<MD5baseframe>(ba_ofs);
+	dest->framecomponents = model_cache_writer_c::Offset<float>(fc_ofs);
+}
+
+//
+// CheckMD5Anim
+//
+// Like CheckMD5Model(), for the parents and the number of animated
+// components which the joint flags ask for.
+//
+static bool CheckMD5Anim(const MD5animation *anim)
+{
+	int components = 0;
+
+	for (int i = 0; i < anim->jointcnt; i++)
+	{
+		const MD5hierarchy *hier = anim->hierarchy + i;
+
+		int parent = (signed char) hier->parentidx;
+
+		if (parent < -1 || parent >= anim->jointcnt)
+			return false;
+
+		for (int bit = 0; bit < 6; bit++)
+			if (hier->flags & (1 << bit))
+				components++;
+	}
+
+	return components <= anim->animatedcomponentcnt;
+}
+
+static MD5animation *ReadMD5Anim(model_cache_reader_c *rd)
+{
+	if (rd->size < (int)sizeof(MD5animation))
+		return NULL;
+
+	MD5animation *anim = (MD5animation *) rd->data;
+
+	if (anim->framecnt < 0 || anim->jointcnt < 0 || anim->jointcnt > MD5_MAX_JOINTS ||
+		anim->animatedcomponentcnt < 0)
+		return NULL;
+
+	rd->Fix(anim->bounds,    anim->framecnt);
+	rd->Fix(anim->hierarchy, anim->jointcnt);
+	rd->Fix(anim->baseframe, anim->jointcnt);
+	rd->Fix(anim->framecomponents, anim->framecnt * anim->animatedcomponentcnt);
+
+	if (! rd->ok || ! CheckMD5Anim(anim))
+		return NULL;
+
+	rd->Release();
+
+	return anim;
+}
+
+//
+// MD5_LoadCachedAnim
+//
+MD5animation *MD5_LoadCachedAnim(byte *lump, int length)
+{
+	u32_t key    = W_ModelCacheKey(lump, length);
+	u32_t layout = MD5AnimLayout();
+
+	model_cache_reader_c rd;
+
+	if (W_LoadModelCache(MDC_MD5Anim, key, length, layout, &rd))
+	{
+		MD5animation *anim = ReadMD5Anim(&rd);
+
+		if (anim)
+			return anim;
+
+		I_Debugf("MD5 animation cache is damaged, rebuilding it.\n");
+	}
+
+	MD5animation *anim = md5_load_anim((char *)lump);
+
+	if (anim)
+	{
+		model_cache_writer_c *w = new model_cache_writer_c();
+
+		WriteMD5Anim(anim, w);
+
+		W_SaveModelCache(MDC_MD5Anim, key, length, layout, w);
+	}
+
+	return anim;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
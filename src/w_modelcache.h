@@ -0,0 +1,135 @@
+//----------------------------------------------------------------------------
+//  EDGE Model Cache
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  Models (and MD5 animations) are stored in the cache directory after
+//  they have been fully processed, named by a CRC of the source lump.
+//  The data is one block holding the structures exactly as they are in
+//  memory, with every pointer replaced by an offset into the block, so
+//  loading is one read plus fixing up those pointers.
+//
+//  Cache files are only good for the same build (structure sizes), so
+//  they carry a layout number and anything unexpected is ignored.
+//
+//----------------------------------------------------------------------------
+
+#ifndef __W_MODELCACHE_H__
+#define __W_MODELCACHE_H__
+
+#include <vector>
+
+#include "md5_conv/md5.h"
+#include "md5_conv/md5_anim.h"
+
+typedef enum
+{
+	MDC_MD2 = 1,
+	MDC_MD3,
+	MDC_MD5Model,
+	MDC_MD5Anim
+}
+model_cache_kind_e;
+
+
+class model_cache_writer_c
+{
+public:
+	std::vector<byte> data;
+
+public:
+	model_cache_writer_c() : data() { }
+	~model_cache_writer_c() { }
+
+	// appends a block (aligned to 16 bytes), returns its offset
+	int Add(const void *src, int bytes);
+
+	byte *At(int offset) { return &data[offset]; }
+
+	// turns an offset into something which can be stored in a pointer
+	template <typename T> static T *Offset(int ofs)
+	{
+		return (T *)(intptr_t) ofs;
+	}
+};
+
+
+class model_cache_reader_c
+{
+public:
+	byte *data;
+	int size;
+
+	// cleared by Fix() when an offset is out of range
+	bool ok;
+
+public:
+	model_cache_reader_c() : data(NULL), size(0), ok(false) { }
+	~model_cache_reader_c() { delete[] data; }
+
+	// turns a stored offset back into a pointer to 'count' elements
+	template <typename T> void Fix(T *& ptr, int count)
+	{
+		intptr_t ofs = (intptr_t) ptr;
+
+		if (count < 0 || ofs < 0 || ofs + (intptr_t)(count * sizeof(T)) > size)
+		{
+			ok  = false;
+			ptr = NULL;
+			return;
+		}
+
+		ptr = (T *)(data + ofs);
+	}
+
+	void FixString(const char *& str);
+
+	// like Fix() for a list of shorts which ends with a negative one,
+	// the whole list (and the end) must be within the data.
+	void FixShortList(short *& list);
+
+	// takes the data away, so it is not freed with the reader
+	byte *Release()
+	{
+		byte *d = data;
+		data = NULL;
+		return d;
+	}
+};
+
+
+u32_t W_ModelCacheKey(const byte *lump, int length);
+
+bool W_LoadModelCache(int kind, u32_t key, int length, u32_t layout,
+                      model_cache_reader_c *rd);
+// Looks for the cache file of a lump.  When found (and the layout
+// matches), the data is read into 'rd' and true is returned.
+
+void W_SaveModelCache(int kind, u32_t key, int length, u32_t layout,
+                      model_cache_writer_c *w);
+// Writes a cache file in the background.  Takes ownership of 'w'.
+
+
+MD5umodel *MD5_LoadCachedModel(byte *lump, int length);
+// Parses and normalizes an MD5 mesh, using the cache when possible.
+
+MD5animation *MD5_LoadCachedAnim(byte *lump, int length);
+// Same for an MD5 animation.
+
+#endif /* __W_MODELCACHE_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -0,0 +1,364 @@
+//----------------------------------------------------------------------------
+//  EDGE Level Prefetching
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+
+#include "system/i_defs.h"
+#include "system/i_thread.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../epi/endianess.h"
+
+#include "../ddf/main.h"
+#include "../ddf/sfx.h"
+
+#include "dm_data.h"
+#include "dm_structs.h"
+#include "r_image.h"
+#include "s_cache.h"
+#include "w_prefetch.h"
+#include "w_wad.h"
+
+
+// memory limit for prefetching (in megabytes), 0 to disable
+DEF_CVAR(w_prefetchmem, int, "c", 64);
+
+// how much of each tic may be spent loading images and sounds
+#define PREFETCH_SLICE_US  4000
+
+
+typedef struct
+{
+	int lump;
+
+	byte *data;
+	int length;
+}
+prefetch_lump_t;
+
+static const mapdef_c *pf_map;
+
+static std::vector<prefetch_lump_t> pf_lumps;
+
+static job_group_c *pf_group;
+
+// images and sounds of the map, found once the lumps are in
+static bool pf_scanned;
+
+static std::vector<const image_c *> pf_images;
+static std::vector<sfxdef_c *> pf_sounds;
+
+static size_t pf_next_image;
+static size_t pf_next_sound;
+
+static int pf_bytes;
+static int pf_budget;
+
+
+static void ReadLumpsJob(void *data)
+{
+	for (size_t i = 0; i < pf_lumps.size(); i++)
+	{
+		prefetch_lump_t *P = &pf_lumps[i];
+
+		P->data = W_ReadLumpBackground(P->lump, &P->length);
+	}
+}
+
+static void AddLump(int lump)
+{
+	if (lump < 0 || lump >= numlumps || W_IsLumpCached(lump))
+		return;
+
+	int length = W_LumpLength(lump);
+
+	if (pf_bytes + length > pf_budget)
+		return;
+
+	pf_bytes += length;
+
+	prefetch_lump_t P;
+
+	P.lump   = lump;
+	P.data   = NULL;
+	P.length = 0;
+
+	pf_lumps.push_back(P);
+}
+
+static void InsertLumps(void)
+{
+	for (size_t i = 0; i < pf_lumps.size(); i++)
+	{
+		prefetch_lump_t *P = &pf_lumps[i];
+
+		if (P->data)
+		{
+			W_AddToCache(P->lump, P->data);
+			delete[] P->data;
+		}
+	}
+
+	pf_lumps.clear();
+}
+
+static void AddImage(const char *name8, image_namespace_e ns)
+{
+	char name[10];
+
+	Z_StrNCpy(name, name8, 8);
+
+	if (! name[0] || name[0] == '-')
+		return;
+
+	const image_c *img = W_ImageLookup(name, ns, ILF_Null);
+
+	if (img)
+		pf_images.push_back(img);
+}
+
+static void AddSound(const struct sfx_s *sfx)
+{
+	if (! sfx)
+		return;
+
+	for (int i = 0; i < sfx->num; i++)
+		pf_sounds.push_back(sfxdefs[sfx->sounds[i]]);
+}
+
+//
+// ScanMap
+//
+// Finds the textures, flats and monster sounds used by the map.  Only
+// binary (non-UDMF) maps are looked at.
+//
+static void ScanMap(int lumpnum)
+{
+	if (W_VerifyLumpName(lumpnum + 1, "TEXTMAP"))
+		return;
+
+	int lump = lumpnum + ML_SIDEDEFS;
+	int count = W_LumpLength(lump) / sizeof(raw_sidedef_t);
+
+	const raw_sidedef_t *side = (const raw_sidedef_t *) W_CacheLumpNum(lump);
+
+	for (int i = 0; i < count; i++)
+	{
+		AddImage(side[i].upper_tex, INS_Texture);
+		AddImage(side[i].mid_tex,   INS_Texture);
+		AddImage(side[i].lower_tex, INS_Texture);
+	}
+
+	W_DoneWithLump(side);
+
+	lump  = lumpnum + ML_SECTORS;
+	count = W_LumpLength(lump) / sizeof(raw_sector_t);
+
+	const raw_sector_t *sec = (const raw_sector_t *) W_CacheLumpNum(lump);
+
+	for (int i = 0; i < count; i++)
+	{
+		AddImage(sec[i].floor_tex, INS_Flat);
+		AddImage(sec[i].ceil_tex,  INS_Flat);
+	}
+
+	W_DoneWithLump(sec);
+
+	// Hexen things are a different size, don't bother with them
+	if (! W_VerifyLumpName(lumpnum + ML_BEHAVIOR, "BEHAVIOR") && ! nosound)
+	{
+		lump  = lumpnum + ML_THINGS;
+		count = W_LumpLength(lump) / sizeof(raw_thing_t);
+
+		const raw_thing_t *mt = (const raw_thing_t *) W_CacheLumpNum(lump);
+
+		for (int i = 0; i < count; i++)
+		{
+			const mobjtype_c *info = mobjtypes.Lookup(EPI_LE_S16(mt[i].type));
+
+			if (! info)
+				continue;
+
+			AddSound(info->seesound);
+			AddSound(info->attacksound);
+			AddSound(info->painsound);
+			AddSound(info->deathsound);
+			AddSound(info->activesound);
+		}
+
+		W_DoneWithLump(mt);
+	}
+
+	std::sort(pf_images.begin(), pf_images.end());
+	pf_images.erase(std::unique(pf_images.begin(), pf_images.end()), pf_images.end());
+
+	std::sort(pf_sounds.begin(), pf_sounds.end());
+	pf_sounds.erase(std::unique(pf_sounds.begin(), pf_sounds.end()), pf_sounds.end());
+}
+
+//
+// W_StartPrefetch
+//
+void W_StartPrefetch(const mapdef_c *map)
+{
+	if (! map || w_prefetchmem <= 0 || map == pf_map)
+		return;
+
+	W_FinishPrefetch();
+
+	int lumpnum = W_CheckNumForName(map->lump.c_str());
+
+	if (lumpnum < 0)
+		return;
+
+	pf_map = map;
+
+	pf_bytes  = 0;
+	pf_budget = MIN(w_prefetchmem, 1024) * 1024 * 1024;
+
+	pf_scanned = false;
+
+	// forget sounds preloaded for an earlier map
+	S_CachePreloadDone();
+
+	if (W_VerifyLumpName(lumpnum + 1, "TEXTMAP"))
+	{
+		for (int lump = lumpnum + 1; lump < numlumps; lump++)
+		{
+			if (W_VerifyLumpName(lump, "ENDMAP"))
+				break;
+
+			AddLump(lump);
+		}
+	}
+	else
+	{
+		for (int k = ML_THINGS; k <= ML_BLOCKMAP; k++)
+			AddLump(lumpnum + k);
+
+		if (W_VerifyLumpName(lumpnum + ML_BEHAVIOR, "BEHAVIOR"))
+			AddLump(lumpnum + ML_BEHAVIOR);
+
+		char gl_lumpname[16];
+
+		sprintf(gl_lumpname, "GL_%s", map->lump.c_str());
+
+		int gl_lumpnum = W_CheckNumForName(gl_lumpname);
+
+		if (gl_lumpnum > lumpnum)
+		{
+			for (int k = ML_GL_VERT; k <= ML_GL_NODES; k++)
+				AddLump(gl_lumpnum + k);
+		}
+	}
+
+	I_Debugf("W_StartPrefetch: %s, %d lumps (%d KB)\n", map->lump.c_str(),
+			 (int)pf_lumps.size(), pf_bytes / 1024);
+
+	pf_group = new job_group_c;
+	pf_group->Add(ReadLumpsJob, NULL);
+}
+
+//
+// W_PrefetchTicker
+//
+void W_PrefetchTicker(void)
+{
+	if (! pf_map)
+		return;
+
+	if (pf_group)
+	{
+		if (! pf_group->Done())
+			return;
+
+		delete pf_group;
+		pf_group = NULL;
+
+		InsertLumps();
+	}
+
+	if (! pf_scanned)
+	{
+		pf_scanned = true;
+
+		ScanMap(W_CheckNumForName(pf_map->lump.c_str()));
+
+		pf_next_image = pf_next_sound = 0;
+		return;
+	}
+
+	// sounds which were still decoding when they were preloaded
+	pf_bytes += S_CachePreloadDone();
+
+	u32_t start = I_ReadMicroSeconds();
+
+	while (pf_next_image < pf_images.size() && pf_bytes < pf_budget)
+	{
+		const image_c *img = pf_images[pf_next_image++];
+
+		W_ImagePreCache(img);
+
+		pf_bytes += img->total_w * img->total_h * 4;
+
+		if (I_ReadMicroSeconds() - start > PREFETCH_SLICE_US)
+			return;
+	}
+
+	while (pf_next_sound < pf_sounds.size() && pf_bytes < pf_budget)
+	{
+		sfxdef_c *def = pf_sounds[pf_next_sound++];
+
+		pf_bytes += S_CachePreload(def);
+
+		if (I_ReadMicroSeconds() - start > PREFETCH_SLICE_US)
+			return;
+	}
+}
+
+//
+// W_FinishPrefetch
+//
+void W_FinishPrefetch(void)
+{
+	if (! pf_map)
+		return;
+
+	if (pf_group)
+	{
+		pf_group->Wait();
+
+		delete pf_group;
+		pf_group = NULL;
+	}
+
+	InsertLumps();
+
+	I_Debugf("W_FinishPrefetch: %s, %d/%d images, %d/%d sounds, %d KB\n",
+			 pf_map->lump.c_str(),
+			 (int)pf_next_image, (int)pf_images.size(),
+			 (int)pf_next_sound, (int)pf_sounds.size(), pf_bytes / 1024);
+
+	pf_images.clear();
+	pf_sounds.clear();
+
+	pf_map = NULL;
+}
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------
+//  EDGE Level Prefetching
+//----------------------------------------------------------------------------
+//
+//  Copyright (c) 2026  The EDGE Team.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 2
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//----------------------------------------------------------------------------
+//
+//  While the intermission (or a finale) is showing, the lumps of the
+//  next map are read on a worker thread and put into the lump cache.
+//  After that, a little of each tic is used to load the textures,
+//  flats and sounds which the map refers to.  All of it is limited by
+//  w_prefetchmem (in megabytes, 0 turns prefetching off).
+//
+//----------------------------------------------------------------------------
+
+#ifndef __W_PREFETCH_H__
+#define __W_PREFETCH_H__
+
+class mapdef_c;
+
+void W_StartPrefetch(const mapdef_c *map);
+// Begins prefetching the given map.  Does nothing when the map is
+// NULL, or is already being prefetched.
+
+void W_PrefetchTicker(void);
+// Does some of the main thread work.  Called every tic while the
+// intermission or finale is running.
+
+void W_FinishPrefetch(void);
+// Waits for the worker to finish and puts everything it read into
+// the cache.  Called when the next level is about to be set up.
+
+#endif /* __W_PREFETCH_H__ */
+
+//--- editor settings ---
+// vi:ts=4:sw=4:noexpandtab
@@ -324,16 +324,52 @@ typedef struct lumpheader_s
 
 	// index in lumplookup
 	int lumpindex;
+
+	// which pool (CACHE_Hot or CACHE_Bulk)
+	int pool;
+
+	// only lumps without users are linked into the LRU list
 	struct lumpheader_s *next, *prev;
 }
 lumpheader_t;
 
+typedef enum
+{
+	CACHE_Hot  = 0,  // palettes, colormaps, fonts
+	CACHE_Bulk = 1,  // everything else: patches, sounds, maps...
+
+	NUM_CACHE_POOLS
+}
+cache_pool_e;
+
 static lumpheader_t **lumplookup;
-static lumpheader_t lumphead;
 
-// number of freeable bytes in cache (excluding headers).
+// least recently used lumps are at the head of each list
+static lumpheader_t lumphead[NUM_CACHE_POOLS];
+
+// number of freeable bytes in each pool (excluding headers).
 // Used to decide how many bytes we should flush.
-static int cache_size = 0;
+static int cache_size[NUM_CACHE_POOLS];
+
+// number of bytes in lumps which have users
+static int cache_used;
+
+static struct
+{
+	int hits;
+	int misses;
+	int evictions;
+
+	double bytes_read;
+	double bytes_evicted;
+}
+cache_stats;
+
+// budget for unused lumps in the bulk pool (in megabytes)
+DEF_CVAR(w_cachemem, int, "c", 64);
+
+// budget for unused lumps in the hot pool (in megabytes)
+DEF_CVAR(w_cachehot, int, "c", 8);
 
 // the first datafile which contains a PLAYPAL lump
 static int palette_datafile = -1;
@@ -1146,12 +1182,11 @@ static void SortSpriteLumps(data_file_c *df)
 //  for the lump name.
 //
 
-#if 0
 static void FreeLump(lumpheader_t *h)
 {
 	int lumpnum = h->lumpindex;
 
-	cache_size -= W_LumpLength(lumpnum);
+	cache_size[h->pool] -= W_LumpLength(lumpnum);
 #ifdef DEVELOPERS
 	if (h->id != lumpheader_s::LUMPID)
 		I_Error("FreeLump: id != LUMPID");
@@ -1168,12 +1203,61 @@ static void FreeLump(lumpheader_t *h)
 	h->next->prev = h->prev;
 	Z_Free(h);
 }
-#endif
+
+//
+// LumpPool
+//
+// Small lumps which are needed all the time go into their own pool,
+// so that streaming through lots of patches or sounds cannot push
+// them out.
+//
+static int LumpPool(int lump)
+{
+	const lumpinfo_t *L = &lumpinfo[lump];
+
+	if (L->kind == LMKIND_WadTex || L->kind == LMKIND_Colmap)
+		return CACHE_Hot;
+
+	if (strncmp(L->name, "PLAYPAL", 8) == 0 ||
+		strncmp(L->name, "PAL", 4) == 0 ||
+		strncmp(L->name, "COLORMAP", 8) == 0 ||
+		strncmp(L->name, "STCFN", 5) == 0 ||
+		strncmp(L->name, "FONT", 4) == 0)
+		return CACHE_Hot;
+
+	return CACHE_Bulk;
+}
+
+//
+// TrimCache
+//
+// Frees the least recently used lumps of a pool until it fits into
+// its budget again.
+//
+static void TrimCache(int pool)
+{
+	int limit = (pool == CACHE_Hot) ? w_cachehot : w_cachemem;
+
+	limit = CLAMP(0, limit, 2047) * 1024 * 1024;
+
+	while (cache_size[pool] > limit && lumphead[pool].next != &lumphead[pool])
+	{
+		lumpheader_t *h = lumphead[pool].next;
+
+		cache_stats.evictions++;
+		cache_stats.bytes_evicted += W_LumpLength(h->lumpindex);
+
+		FreeLump(h);
+	}
+}
 
 //
 // MarkAsCached
 //
-static void MarkAsCached(lumpheader_t *item)
+// The lump has no more users: link it into the LRU list of its pool,
+// at the tail normally, or at the head when it should be flushed early.
+//
+static void MarkAsCached(lumpheader_t *item, bool flushable = false)
 {
 #ifdef DEVELOPERS
 	if (item->id != lumpheader_s::LUMPID)
@@ -1186,7 +1270,50 @@ static void MarkAsCached(lumpheader_t *item)
 		I_Error("MarkAsCached: Internal error, lump %d", item->lumpindex);
 #endif
 
-	cache_size += W_LumpLength(item->lumpindex);
+	lumpheader_t *head = &lumphead[item->pool];
+
+	if (flushable)
+	{
+		item->prev = head;
+		item->next = head->next;
+	}
+	else
+	{
+		item->prev = head->prev;
+		item->next = head;
+	}
+
+	item->prev->next = item;
+	item->next->prev = item;
+
+	int length = W_LumpLength(item->lumpindex);
+
+	cache_used -= length;
+	cache_size[item->pool] += length;
+
+	TrimCache(item->pool);
+}
+
+//
+// NewLumpHeader
+//
+static lumpheader_t *NewLumpHeader(int lump)
+{
+	int length = W_LumpLength(lump);
+
+	lumpheader_t *h = (lumpheader_t *)Z_Malloc(sizeof(lumpheader_t) + length);
+	lumplookup[lump] = h;
+#ifdef DEVELOPERS
+	h->id = lumpheader_s::LUMPID;
+#endif
+	h->lumpindex = lump;
+	h->pool = LumpPool(lump);
+	h->users = 1;
+	h->next = h->prev = NULL;
+
+	cache_used += length;
+
+	return h;
 }
 
 //
@@ -3001,7 +3128,11 @@ static void AddFile(const char *filename, int kind, int dyn_index)
 
 static void InitCaches(void)
 {
-	lumphead.next = lumphead.prev = &lumphead;
+	for (int pool = 0; pool < NUM_CACHE_POOLS; pool++)
+	{
+		lumphead[pool].next = lumphead[pool].prev = &lumphead[pool];
+		cache_size[pool] = 0;
+	}
 }
 
 //
@@ -3742,6 +3873,88 @@ byte *W_ReadLumpAlloc(int lump, int *length)
 	return data;
 }
 
+//
+// W_ReadLumpBackground
+//
+// Like W_ReadLumpAlloc(), but can be used from a worker thread: the
+// file is opened again instead of sharing its seek position.  Returns
+// NULL when the lump cannot be read.
+//
+byte *W_ReadLumpBackground(int lump, int *length)
+{
+	SYS_ASSERT(0 <= lump && lump < numlumps);
+
+	const lumpinfo_t *L = &lumpinfo[lump];
+	const data_file_c *df = data_files[L->file];
+
+	*length = L->size;
+
+	byte *data = new byte[L->size + 1];
+	int c = -1;
+
+	if ((df->kind == FLKIND_PAK) || (df->kind == FLKIND_PK3) || (df->kind == FLKIND_PK7) || (df->kind == FLKIND_EPK))
+	{
+#ifdef HAVE_PHYSFS
+		PHYSFS_File *handle = PHYSFS_openRead(L->path);
+		if (handle)
+		{
+			PHYSFS_seek(handle, L->position);
+			c = PHYSFS_readBytes(handle, data, L->size);
+			PHYSFS_close(handle);
+		}
+#endif
+	}
+	else
+	{
+		epi::file_c *F = epi::FS_Open(df->file_name, epi::file_c::ACCESS_READ | epi::file_c::ACCESS_BINARY);
+		if (F)
+		{
+			F->Seek(L->position, epi::file_c::SEEKPOINT_START);
+			c = F->Read(data, L->size);
+			delete F;
+		}
+	}
+
+	if (c < L->size)
+	{
+		delete[] data;
+		return NULL;
+	}
+
+	data[L->size] = 0;
+
+	return data;
+}
+
+//
+// W_IsLumpCached
+//
+bool W_IsLumpCached(int lump)
+{
+	SYS_ASSERT(0 <= lump && lump < numlumps);
+
+	return lumplookup[lump] != NULL;
+}
+
+//
+// W_AddToCache
+//
+// Puts lump data which has been read elsewhere (see above) into the
+// cache, as if it had been cached and then released.
+//
+void W_AddToCache(int lump, const byte *data)
+{
+	if (W_IsLumpCached(lump))
+		return;
+
+	lumpheader_t *h = NewLumpHeader(lump);
+
+	memcpy(h + 1, data, W_LumpLength(lump));
+
+	h->users = 0;
+	MarkAsCached(h);
+}
+
 //
 // W_DoneWithLump
 //
@@ -3762,12 +3975,6 @@ void W_DoneWithLump(const void *ptr)
 	if (h->users == 0)
 	{
 		// Move the item to the tail.
-		h->prev->next = h->next;
-		h->next->prev = h->prev;
-		h->prev = lumphead.prev;
-		h->next = &lumphead;
-		h->prev->next = h;
-		h->next->prev = h;
 		MarkAsCached(h);
 	}
 }
@@ -3798,13 +4005,7 @@ void W_DoneWithLump_Flushable(const void *ptr)
 	if (h->users == 0)
 	{
 		// Move the item to the head of the list.
-		h->prev->next = h->next;
-		h->next->prev = h->prev;
-		h->next = lumphead.next;
-		h->prev = &lumphead;
-		h->prev->next = h;
-		h->next->prev = h;
-		MarkAsCached(h);
+		MarkAsCached(h, true);
 	}
 }
 
@@ -3826,25 +4027,30 @@ const void *W_CacheLumpNum2(int lump)
 	{
 		// cache hit
 		if (h->users == 0)
-			cache_size -= W_LumpLength(h->lumpindex);
+		{
+			// take it off the LRU list while in use
+			h->prev->next = h->next;
+			h->next->prev = h->prev;
+			h->next = h->prev = NULL;
+
+			int length = W_LumpLength(h->lumpindex);
+
+			cache_size[h->pool] -= length;
+			cache_used += length;
+		}
 		h->users++;
+
+		cache_stats.hits++;
 	}
 	else
 	{
 		// cache miss. load the new item.
-		h = (lumpheader_t *)Z_Malloc(sizeof(lumpheader_t) + W_LumpLength(lump));
-		lumplookup[lump] = h;
-#ifdef DEVELOPERS
-		h->id = lumpheader_s::LUMPID;
-#endif
-		h->lumpindex = lump;
-		h->users = 1;
-		h->prev = lumphead.prev;
-		h->next = &lumphead;
-		h->prev->next = h;
-		lumphead.prev = h;
+		h = NewLumpHeader(lump);
 
 		W_ReadLump(lump, (void *)(h + 1));
+
+		cache_stats.misses++;
+		cache_stats.bytes_read += W_LumpLength(lump);
 	}
 
 	return (void *)(h + 1);
@@ -3881,19 +4087,35 @@ void W_PreCacheLumpName(const char *name)
 //
 int W_CacheInfo(int level)
 {
-	lumpheader_t *h;
 	int value = 0;
 
-	for (h = lumphead.next; h != &lumphead; h = h->next)
-	{
-		if ((level & 1) && h->users)
-			value += W_LumpLength(h->lumpindex);
-		if ((level & 2) && !h->users)
-			value += W_LumpLength(h->lumpindex);
-	}
+	if (level & 1)
+		value += cache_used;
+	if (level & 2)
+		value += cache_size[CACHE_Hot] + cache_size[CACHE_Bulk];
+
 	return value;
 }
 
+//
+// W_ShowCacheInfo
+//
+void W_ShowCacheInfo(void)
+{
+	int lookups = cache_stats.hits + cache_stats.misses;
+
+	I_Printf("Lump cache:\n");
+	I_Printf("  in use: %d KB\n", cache_used / 1024);
+	I_Printf("  hot:    %d KB (limit %d MB)\n", cache_size[CACHE_Hot]  / 1024, w_cachehot);
+	I_Printf("  bulk:   %d KB (limit %d MB)\n", cache_size[CACHE_Bulk] / 1024, w_cachemem);
+	I_Printf("  hits %d, misses %d (%1.1f%%), evictions %d\n",
+			 cache_stats.hits, cache_stats.misses,
+			 lookups ? cache_stats.misses * 100.0 / lookups : 0.0,
+			 cache_stats.evictions);
+	I_Printf("  read %1.1f MB, evicted %1.1f MB\n",
+			 cache_stats.bytes_read / 1048576.0, cache_stats.bytes_evicted / 1048576.0);
+}
+
 //
 // W_LoadLumpNum
 //
@@ -149,7 +149,11 @@ bool W_VerifyLumpName(int lump, const char *name);
 const char *W_GetLumpName(int lump);
 const char *W_GetLumpFullName(int lump);
 int W_CacheInfo(int level);
+void W_ShowCacheInfo(void);
 byte *W_ReadLumpAlloc(int lump, int *length);
+byte *W_ReadLumpBackground(int lump, int *length);
+bool W_IsLumpCached(int lump);
+void W_AddToCache(int lump, const byte *data);
 
 epi::file_c *W_OpenLump(int lump);
 epi::file_c *W_OpenLump(const char *name);
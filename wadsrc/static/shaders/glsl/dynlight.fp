@@ -0,0 +1,62 @@
+// Single pass dynamic lights and sector glows (see r_units.cc).
+//
+// Gives the same result as drawing the polygon once per light with
+// the DLIGHT_EXP image: additive lights add their colour, the others
+// add their colour multiplied by the texture.
+
+in vec3 WorldPos;
+in vec2 TexCoord;
+in vec4 VertColor;
+
+out vec4 FragColor;
+
+uniform sampler2D Texture;
+uniform int Masked;
+
+uniform int NumLights;
+uniform vec4 LightPos[MAX_LIGHTS];     // w is 1 for a sector glow
+uniform vec4 LightColor[MAX_LIGHTS];   // a is 1 to modulate the texture
+uniform float LightRadius[MAX_LIGHTS];
+
+void main()
+{
+	vec4 tex = texture(Texture, TexCoord);
+
+	vec3 add = vec3(0.0);
+	vec3 modulate = vec3(0.0);
+
+	for (int i = 0; i < MAX_LIGHTS; i++)
+	{
+		if (i >= NumLights)
+			break;
+
+		float d;
+
+		if (LightPos[i].w > 0.5)
+			d = abs(WorldPos.z - LightPos[i].z);
+		else
+			d = distance(WorldPos, LightPos[i].xyz);
+
+		d /= LightRadius[i];
+
+		// the standard light curve, see MakeStdCurve() in r_shader.cc.
+		// Lights with other shapes are never passed to this shader.
+		float ity = (d < 1.0) ? exp(-5.44 * d * d) : 0.0;
+
+		if (LightColor[i].a > 0.5)
+			modulate += LightColor[i].rgb * ity;
+		else
+			add += LightColor[i].rgb * ity;
+	}
+
+	// the multi-pass version only used the texture's alpha for the
+	// additive lights when the surface was masked.
+	float alpha = VertColor.a;
+
+	if (Masked != 0)
+		alpha *= tex.a;
+	else
+		modulate *= tex.a;
+
+	FragColor = vec4((add + tex.rgb * modulate) * VertColor.rgb, alpha);
+}